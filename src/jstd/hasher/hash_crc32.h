@@ -14,6 +14,8 @@
 
 #include <assert.h>
 
+#include <cstring>      // For std::memcpy()
+
 // Just for coding in msvc or test, please comment it in the release version.
 #ifdef _MSC_VER
 #ifndef __SSE4_2__
@@ -137,6 +139,76 @@ static uint32_t intel_crc32_x86(const char * data, size_t length)
 
 #if JSTD_IS_X86_64
 
+#ifndef JSTD_CRC32_USE_PCLMUL
+#if defined(__PCLMUL__) || (defined(_MSC_VER) && defined(__AVX__))
+#define JSTD_CRC32_USE_PCLMUL   1
+#else
+#define JSTD_CRC32_USE_PCLMUL   0
+#endif
+#endif // JSTD_CRC32_USE_PCLMUL
+
+#if JSTD_CRC32_USE_PCLMUL
+
+//
+// The crc32 instruction has a latency of 3 cycles, but a throughput of one per cycle.
+// The long keys are split into 3 streams of block_size bytes, the 3 chains run in
+// parallel, then the crc of the first two streams are shifted over the bytes behind
+// them and merged, the result is the same as the single chain.
+//
+// Shifting a crc over n bytes is a multiply by x^(8n) mod P, it's a carry-less
+// multiply by the constant x^(8n - 33) mod P (bit-reflected), and the crc32 of
+// the 64 bits product, which multiplies it by x^33 and reduces it.
+//
+// See: https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/crc-iscsi-polynomial-crc32-instruction-paper.pdf
+//
+static const uint64_t kCrc32cShift16  = 0x493C7D27ULL;  // x^(8 * 16  - 33) mod P
+static const uint64_t kCrc32cShift32  = 0xBA4FC28EULL;  // x^(8 * 32  - 33) mod P
+static const uint64_t kCrc32cShift64  = 0x9E4ADDF8ULL;  // x^(8 * 64  - 33) mod P
+static const uint64_t kCrc32cShift128 = 0x0D3B6092ULL;  // x^(8 * 128 - 33) mod P
+
+static inline
+uint64_t intel_crc32_x64_combine3(uint64_t crc0, uint64_t crc1, uint64_t crc2,
+                                  uint64_t shift1, uint64_t shift2)
+{
+    __m128i product0 = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(crc0)),
+                                            _mm_cvtsi64_si128(static_cast<long long>(shift2)), 0x00);
+    __m128i product1 = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(crc1)),
+                                            _mm_cvtsi64_si128(static_cast<long long>(shift1)), 0x00);
+    uint64_t product = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_xor_si128(product0, product1)));
+    return (_mm_crc32_u64(0, product) ^ crc2);
+}
+
+//
+// Consume the blocks of 3 * block_size bytes, shift1 and shift2 are the shift
+// constants of block_size and 2 * block_size bytes.
+//
+static inline
+uint64_t intel_crc32_x64_3way(uint64_t crc64, const char *& data, size_t & remain,
+                              size_t block_size, uint64_t shift1, uint64_t shift2)
+{
+    static const size_t kStepSize = sizeof(uint64_t);
+
+    while (remain >= block_size * 3) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        for (size_t offset = 0; offset < block_size; offset += kStepSize) {
+            uint64_t word0, word1, word2;
+            std::memcpy(&word0, data + offset, sizeof(word0));
+            std::memcpy(&word1, data + block_size + offset, sizeof(word1));
+            std::memcpy(&word2, data + block_size * 2 + offset, sizeof(word2));
+            crc64 = _mm_crc32_u64(crc64, word0);
+            crc1  = _mm_crc32_u64(crc1,  word1);
+            crc2  = _mm_crc32_u64(crc2,  word2);
+        }
+        crc64 = intel_crc32_x64_combine3(crc64, crc1, crc2, shift1, shift2);
+        data += block_size * 3;
+        remain -= block_size * 3;
+    }
+    return crc64;
+}
+
+#endif // JSTD_CRC32_USE_PCLMUL
+
 static uint32_t intel_crc32_x64(const char * data, size_t length)
 {
     assert(data != nullptr);
@@ -148,10 +220,22 @@ static uint32_t intel_crc32_x64(const char * data, size_t length)
     uint64_t crc64 = ~uint64_t(0);
     ssize_t remain = static_cast<ssize_t>(length);
 
+#if JSTD_CRC32_USE_PCLMUL
+    // The keys of 48 bytes or more, 3 streams of 64 bytes blocks, then of 16 bytes blocks.
+    static const size_t kMin3WayLength = 16 * 3;
+    if (length >= kMin3WayLength) {
+        size_t remain_3way = length;
+        crc64 = intel_crc32_x64_3way(crc64, data, remain_3way, 64, kCrc32cShift64, kCrc32cShift128);
+        crc64 = intel_crc32_x64_3way(crc64, data, remain_3way, 16, kCrc32cShift16, kCrc32cShift32);
+        remain = static_cast<ssize_t>(remain_3way);
+    }
+#endif
+
     do {
         if (likely(remain >= kStepSize)) {
             assert(data < data_end);
-            uint64_t data64 = *(uint64_t *)(data);
+            uint64_t data64;
+            std::memcpy(&data64, data, sizeof(data64));
             crc64 = _mm_crc32_u64(crc64, data64);
             data += kStepSize;
             remain -= kStepSize;
@@ -161,7 +245,8 @@ static uint32_t intel_crc32_x64(const char * data, size_t length)
             assert((data_end - data) == remain);
             assert(remain >= 0);
             if (likely(remain > 0)) {
-                uint64_t data64 = *(uint64_t *)(data);
+                uint64_t data64;
+                std::memcpy(&data64, data, sizeof(data64));
                 size_t rest = (size_t)(kStepSize - remain);
                 assert(rest > 0 && rest < (size_t)kStepSize);
                 uint64_t mask = kMaskOne >> (rest * 8U);
@@ -175,6 +260,158 @@ static uint32_t intel_crc32_x64(const char * data, size_t length)
     return static_cast<uint32_t>(crc64);
 }
 
+#ifndef JSTD_CRC32_ADDRESS_SANITIZER
+#if defined(__SANITIZE_ADDRESS__)
+#define JSTD_CRC32_ADDRESS_SANITIZER    1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define JSTD_CRC32_ADDRESS_SANITIZER    1
+#endif
+#endif
+#ifndef JSTD_CRC32_ADDRESS_SANITIZER
+#define JSTD_CRC32_ADDRESS_SANITIZER    0
+#endif
+#endif // JSTD_CRC32_ADDRESS_SANITIZER
+
+//
+// Continue intel_crc32_x64() of the key [data, data + length) from the crc64 of
+// it's first offset bytes. The tail word is a masked load like intel_crc32_x64(),
+// but only if it doesn't cross the page, otherwise it's loaded backward from the end
+// of the key, or pieced from two short loads, it's the same value.
+//
+static inline
+uint32_t intel_crc32_x64_continue(uint64_t crc64, const char * data, size_t offset, size_t length)
+{
+    static const size_t kStepSize = sizeof(uint64_t);
+
+    while ((offset + kStepSize) <= length) {
+        uint64_t data64;
+        std::memcpy(&data64, data + offset, sizeof(data64));
+        crc64 = _mm_crc32_u64(crc64, data64);
+        offset += kStepSize;
+    }
+
+    size_t remain = length - offset;
+    if (remain > 0) {
+        uint64_t data64;
+#if !JSTD_CRC32_ADDRESS_SANITIZER
+        // Don't cross the page, the masked load of the tail is safe then.
+        static const uintptr_t kPageSize = 4096;
+        if (JSTD_LIKELY((reinterpret_cast<uintptr_t>(data + offset) & (kPageSize - 1)) <= (kPageSize - kStepSize))) {
+            std::memcpy(&data64, data + offset, sizeof(data64));
+            data64 &= (~uint64_t(0) >> ((kStepSize - remain) * 8));
+        } else
+#endif
+        if (length >= kStepSize) {
+            std::memcpy(&data64, data + length - kStepSize, sizeof(data64));
+            data64 >>= (kStepSize - remain) * 8;
+        } else if (remain >= sizeof(uint32_t)) {
+            uint32_t low, high;
+            std::memcpy(&low, data, sizeof(low));
+            std::memcpy(&high, data + remain - sizeof(uint32_t), sizeof(high));
+            data64 = static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << ((remain - sizeof(uint32_t)) * 8));
+        } else if (remain >= sizeof(uint16_t)) {
+            uint16_t low, high;
+            std::memcpy(&low, data, sizeof(low));
+            std::memcpy(&high, data + remain - sizeof(uint16_t), sizeof(high));
+            data64 = static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << ((remain - sizeof(uint16_t)) * 8));
+        } else {
+            data64 = static_cast<uint8_t>(data[0]);
+        }
+        crc64 = _mm_crc32_u64(crc64, data64);
+    }
+    return static_cast<uint32_t>(crc64);
+}
+
+//
+// intel_crc32_x64() over-reads the tail word, it's kept out of the ASan builds.
+//
+static inline
+uint32_t intel_crc32_x64_one(const char * data, size_t length)
+{
+#if JSTD_CRC32_ADDRESS_SANITIZER
+    return intel_crc32_x64_continue(~uint64_t(0), data, 0, length);
+#else
+    return intel_crc32_x64(data, length);
+#endif
+}
+
+//
+// The crc32 instruction has a latency of 3 cycles, but a throughput of one per cycle,
+// so a long key is one dependency chain that leaves the unit idle. Hash 4 keys in
+// lockstep over the words of the shortest one, the 4 chains run in parallel, then
+// finish each key alone. The results are the same as intel_crc32_x64() of each key.
+//
+// The lockstep only pays off if it covers most of the bytes, the short keys and
+// the groups of very different lengths are hashed one by one, the out-of-order core
+// overlaps their chains already, and the lanes only add the exit mispredictions.
+//
+template <typename StringViewT>
+static void intel_crc32_x64_many(const StringViewT * keys, size_t count, uint32_t * hash_codes)
+{
+    static const size_t kStepSize = sizeof(uint64_t);
+    static const size_t kLanes = 4;
+    static const size_t kMinLockstepLength = 32;
+
+    size_t i = 0;
+    for (; (i + kLanes) <= count; i += kLanes) {
+        const char * data0 = reinterpret_cast<const char *>(keys[i + 0].data());
+        const char * data1 = reinterpret_cast<const char *>(keys[i + 1].data());
+        const char * data2 = reinterpret_cast<const char *>(keys[i + 2].data());
+        const char * data3 = reinterpret_cast<const char *>(keys[i + 3].data());
+        size_t length0 = keys[i + 0].size() * sizeof(*keys[i + 0].data());
+        size_t length1 = keys[i + 1].size() * sizeof(*keys[i + 1].data());
+        size_t length2 = keys[i + 2].size() * sizeof(*keys[i + 2].data());
+        size_t length3 = keys[i + 3].size() * sizeof(*keys[i + 3].data());
+
+        // Select by value, std::min() and std::max() return references and compile to branches,
+        // which mispredict on the random lengths.
+        size_t min01 = (length0 < length1) ? length0 : length1;
+        size_t min23 = (length2 < length3) ? length2 : length3;
+        size_t max01 = (length0 < length1) ? length1 : length0;
+        size_t max23 = (length2 < length3) ? length3 : length2;
+        size_t min_length = (min01 < min23) ? min01 : min23;
+        size_t max_length = (max01 < max23) ? max23 : max01;
+        if (likely((min_length < kMinLockstepLength) || (min_length < max_length / 2))) {
+            for (size_t lane = 0; lane < kLanes; lane++) {
+                hash_codes[i + lane] = intel_crc32_x64_one(reinterpret_cast<const char *>(keys[i + lane].data()),
+                                                           keys[i + lane].size() * sizeof(*keys[i + lane].data()));
+            }
+            continue;
+        }
+
+        size_t lockstep_length = min_length & ~(kStepSize - 1);
+
+        uint64_t crc0 = ~uint64_t(0);
+        uint64_t crc1 = ~uint64_t(0);
+        uint64_t crc2 = ~uint64_t(0);
+        uint64_t crc3 = ~uint64_t(0);
+
+        for (size_t offset = 0; offset < lockstep_length; offset += kStepSize) {
+            uint64_t word0, word1, word2, word3;
+            std::memcpy(&word0, data0 + offset, sizeof(word0));
+            std::memcpy(&word1, data1 + offset, sizeof(word1));
+            std::memcpy(&word2, data2 + offset, sizeof(word2));
+            std::memcpy(&word3, data3 + offset, sizeof(word3));
+            crc0 = _mm_crc32_u64(crc0, word0);
+            crc1 = _mm_crc32_u64(crc1, word1);
+            crc2 = _mm_crc32_u64(crc2, word2);
+            crc3 = _mm_crc32_u64(crc3, word3);
+        }
+
+        hash_codes[i + 0] = intel_crc32_x64_continue(crc0, data0, lockstep_length, length0);
+        hash_codes[i + 1] = intel_crc32_x64_continue(crc1, data1, lockstep_length, length1);
+        hash_codes[i + 2] = intel_crc32_x64_continue(crc2, data2, lockstep_length, length2);
+        hash_codes[i + 3] = intel_crc32_x64_continue(crc3, data3, lockstep_length, length3);
+    }
+
+    for (; i < count; i++) {
+        const char * data = reinterpret_cast<const char *>(keys[i].data());
+        size_t length = keys[i].size() * sizeof(*keys[i].data());
+        hash_codes[i] = intel_crc32_x64_one(data, length);
+    }
+}
+
 #endif //JSTD_IS_X86_64
 
 static uint32_t intel_crc32_simple_x86(const char * data, size_t length)
@@ -247,6 +484,24 @@ static uint32_t hash_crc32(const char * data, size_t length)
 #endif
 }
 
+//
+// Hash count keys (any string type with data() and size()) into hash_codes[],
+// hash_codes[i] is the same as hash_crc32() of keys[i]. For the callers that
+// hash a block of keys before the inserts or the lookups.
+//
+template <typename StringViewT>
+static void hash_crc32_many(const StringViewT * keys, size_t count, uint32_t * hash_codes)
+{
+#if defined(__SSE4_2__) && JSTD_IS_X86_64
+    intel_crc32_x64_many(keys, count, hash_codes);
+#else
+    for (size_t i = 0; i < count; i++) {
+        hash_codes[i] = hash_crc32(reinterpret_cast<const char *>(keys[i].data()),
+                                   keys[i].size() * sizeof(*keys[i].data()));
+    }
+#endif
+}
+
 static size_t int_hash_crc32(size_t value)
 {
 #ifdef __SSE4_2__
@@ -260,6 +515,29 @@ static size_t int_hash_crc32(size_t value)
 #endif
 }
 
+//
+// Hash count integers into hash_codes[], hash_codes[i] is the same as int_hash_crc32(values[i]).
+// There is no SIMD form of the crc32 instruction, but the crc32 of the different values
+// are independent, so the loop keeps the crc32 unit busy (latency 3, throughput 1).
+//
+static void int_hash_crc32_many(const size_t * values, size_t count, size_t * hash_codes)
+{
+    size_t i = 0;
+    for (; (i + 4) <= count; i += 4) {
+        size_t hash_code0 = int_hash_crc32(values[i + 0]);
+        size_t hash_code1 = int_hash_crc32(values[i + 1]);
+        size_t hash_code2 = int_hash_crc32(values[i + 2]);
+        size_t hash_code3 = int_hash_crc32(values[i + 3]);
+        hash_codes[i + 0] = hash_code0;
+        hash_codes[i + 1] = hash_code1;
+        hash_codes[i + 2] = hash_code2;
+        hash_codes[i + 3] = hash_code3;
+    }
+    for (; i < count; i++) {
+        hash_codes[i] = int_hash_crc32(values[i]);
+    }
+}
+
 static size_t simple_int_hash_crc32(size_t value)
 {
 #ifdef __SSE4_2__
@@ -12,6 +12,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <cstring>       // For std::memcpy()
 #include <string>
 #include <vector>
 #include <thread>
@@ -32,6 +33,11 @@
 #include "jstd/traits/type_traits.h"
 #include "jstd/support/BitUtils.h"
 #include "jstd/support/Power2.h"
+#include "jstd/support/x86_intrin.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) && !defined(__AES__)
+#include <wmmintrin.h>  // For the target("aes") functions
+#endif
 
 #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX64) || defined(_M_AMD64))
   #include <intrin.h>
@@ -828,6 +834,363 @@ std::size_t mum_mul_mix(std::size_t value) noexcept
 #endif
 }
 
+//
+// Batch integer hashing: hash count values into hash_codes[], hash_codes[i] is the same
+// as the scalar hash of values[i], and hash_codes can be the same array as values.
+// For the callers that hash a block of keys before the inserts or the lookups,
+// 4 keys per AVX2 sequence (8 keys per AVX-512DQ sequence for fibonacci_hash).
+//
+// AVX2 has no 64x64 bit multiply, the low 64 bits of the product are made of
+// three _mm256_mul_epu32(), the high 64 bits need the fourth one and the carries
+// of the middle column.
+//
+
+#if defined(__AVX2__) && (JSTD_WORD_LEN == 64)
+
+JSTD_FORCED_INLINE
+__m256i mm256_mullo_epu64(__m256i a, __m256i b) noexcept
+{
+    __m256i lo_lo = _mm256_mul_epu32(a, b);
+    __m256i hi_lo = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    __m256i lo_hi = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+    __m256i cross = _mm256_slli_epi64(_mm256_add_epi64(hi_lo, lo_hi), 32);
+    return _mm256_add_epi64(lo_lo, cross);
+}
+
+//
+// (low 64 bits ^ high 64 bits) of the 128 bits product a * b.
+//
+JSTD_FORCED_INLINE
+__m256i mm256_mum_epu64(__m256i a, __m256i b) noexcept
+{
+    const __m256i kLowMask = _mm256_set1_epi64x(0x00000000FFFFFFFFll);
+    __m256i a_hi = _mm256_srli_epi64(a, 32);
+    __m256i b_hi = _mm256_srli_epi64(b, 32);
+
+    __m256i lo_lo = _mm256_mul_epu32(a, b);
+    __m256i lo_hi = _mm256_mul_epu32(a, b_hi);
+    __m256i hi_lo = _mm256_mul_epu32(a_hi, b);
+    __m256i hi_hi = _mm256_mul_epu32(a_hi, b_hi);
+
+    __m256i middle = _mm256_add_epi64(_mm256_srli_epi64(lo_lo, 32),
+                     _mm256_add_epi64(_mm256_and_si256(lo_hi, kLowMask),
+                                      _mm256_and_si256(hi_lo, kLowMask)));
+    __m256i low  = _mm256_or_si256(_mm256_and_si256(lo_lo, kLowMask),
+                                   _mm256_slli_epi64(middle, 32));
+    __m256i high = _mm256_add_epi64(_mm256_add_epi64(hi_hi, _mm256_srli_epi64(middle, 32)),
+                   _mm256_add_epi64(_mm256_srli_epi64(lo_hi, 32), _mm256_srli_epi64(hi_lo, 32)));
+    return _mm256_xor_si256(low, high);
+}
+
+#elif defined(__SSE4_1__) && (JSTD_WORD_LEN == 32)
+
+//
+// (low 32 bits ^ high 32 bits) of the 64 bits product a * b, in the 4 lanes.
+//
+JSTD_FORCED_INLINE
+__m128i mm_mum_epu32(__m128i a, __m128i b) noexcept
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), b);
+    even = _mm_xor_si128(even, _mm_srli_epi64(even, 32));
+    odd  = _mm_xor_si128(odd,  _mm_srli_epi64(odd,  32));
+    return _mm_blend_epi16(even, _mm_slli_epi64(odd, 32), 0xCC);
+}
+
+#endif // __AVX2__
+
+static inline
+void fibonacci_hash_many(const std::size_t * values, std::size_t count,
+                         std::size_t * hash_codes) noexcept
+{
+    std::size_t i = 0;
+#if defined(__AVX2__) && (JSTD_WORD_LEN == 64)
+  #if defined(__AVX512DQ__)
+    const __m512i kMultiplier512 = _mm512_set1_epi64((long long)11400714818402800987ull);
+    for (; (i + 8) <= count; i += 8) {
+        __m512i value = _mm512_loadu_si512((const void *)(values + i));
+        __m512i hash_code = _mm512_srli_epi64(_mm512_mullo_epi64(value, kMultiplier512), 28);
+        _mm512_storeu_si512((void *)(hash_codes + i), hash_code);
+    }
+  #endif
+    const __m256i kMultiplier = _mm256_set1_epi64x((long long)11400714818402800987ull);
+    for (; (i + 4) <= count; i += 4) {
+        __m256i value = _mm256_loadu_si256((const __m256i *)(values + i));
+        __m256i hash_code = _mm256_srli_epi64(mm256_mullo_epu64(value, kMultiplier), 28);
+        _mm256_storeu_si256((__m256i *)(hash_codes + i), hash_code);
+    }
+#elif defined(__SSE4_1__) && (JSTD_WORD_LEN == 32)
+    const __m128i kMultiplier = _mm_set1_epi32((int)2654435761ul);
+    for (; (i + 4) <= count; i += 4) {
+        __m128i value = _mm_loadu_si128((const __m128i *)(values + i));
+        __m128i hash_code = _mm_srli_epi32(_mm_mullo_epi32(value, kMultiplier), 12);
+        _mm_storeu_si128((__m128i *)(hash_codes + i), hash_code);
+    }
+#endif
+    for (; i < count; i++) {
+        hash_codes[i] = fibonacci_hash(values[i]);
+    }
+}
+
+static inline
+void mum_hash_many(const std::size_t * values, std::size_t count,
+                   std::size_t * hash_codes) noexcept
+{
+    std::size_t i = 0;
+#if defined(__AVX2__) && (JSTD_WORD_LEN == 64)
+    const __m256i kMultiplier = _mm256_set1_epi64x((long long)11400714818402800987ull);
+    for (; (i + 4) <= count; i += 4) {
+        __m256i value = _mm256_loadu_si256((const __m256i *)(values + i));
+        _mm256_storeu_si256((__m256i *)(hash_codes + i), mm256_mum_epu64(value, kMultiplier));
+    }
+#elif defined(__SSE4_1__) && (JSTD_WORD_LEN == 32)
+    const __m128i kMultiplier = _mm_set1_epi32((int)2654435761ul);
+    for (; (i + 4) <= count; i += 4) {
+        __m128i value = _mm_loadu_si128((const __m128i *)(values + i));
+        _mm_storeu_si128((__m128i *)(hash_codes + i), mm_mum_epu32(value, kMultiplier));
+    }
+#endif
+    for (; i < count; i++) {
+        hash_codes[i] = mum_hash(values[i]);
+    }
+}
+
+static inline
+void mum_mul_mix_many(const std::size_t * values, std::size_t count,
+                      std::size_t * hash_codes) noexcept
+{
+    std::size_t i = 0;
+#if defined(__AVX2__) && (JSTD_WORD_LEN == 64) && defined(JSTD_64B_ARCHITECTURE)
+    const __m256i kMultiplier = _mm256_set1_epi64x((long long)0x9E3779B97F4A7C15ull);
+    for (; (i + 4) <= count; i += 4) {
+        __m256i value = _mm256_loadu_si256((const __m256i *)(values + i));
+        _mm256_storeu_si256((__m256i *)(hash_codes + i), mm256_mum_epu64(value, kMultiplier));
+    }
+#elif defined(__SSE4_1__) && (JSTD_WORD_LEN == 32) && !defined(JSTD_64B_ARCHITECTURE)
+    const __m128i kMultiplier = _mm_set1_epi32((int)0xE817FB2Du);
+    for (; (i + 4) <= count; i += 4) {
+        __m128i value = _mm_loadu_si128((const __m128i *)(values + i));
+        _mm_storeu_si128((__m128i *)(hash_codes + i), mm_mum_epu32(value, kMultiplier));
+    }
+#endif
+    for (; i < count; i++) {
+        hash_codes[i] = mum_mul_mix(values[i]);
+    }
+}
+
+//
+// wyhash (final version 4.2), a fast 64-bit string hash, the output passes SMHasher
+// and is avalanching, so the hash tables don't need to mix it again.
+//
+// The keys longer than 48 bytes are consumed in three independent mum lanes,
+// so the 64x64->128 bit multiplies of the lanes run in parallel.
+//
+// See: https://github.com/wangyi-fudan/wyhash
+//
+
+static const std::uint64_t kWyHashSecret[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+    0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+JSTD_FORCED_INLINE
+void wyhash_mum(std::uint64_t & a, std::uint64_t & b) noexcept
+{
+    _uint128_t product = uint128_mul(a, b);
+    a = product.low;
+    b = product.high;
+}
+
+JSTD_FORCED_INLINE
+std::uint64_t wyhash_mix(std::uint64_t a, std::uint64_t b) noexcept
+{
+    wyhash_mum(a, b);
+    return (a ^ b);
+}
+
+JSTD_FORCED_INLINE
+std::uint64_t wyhash_read64(const std::uint8_t * ptr) noexcept
+{
+    std::uint64_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+JSTD_FORCED_INLINE
+std::uint64_t wyhash_read32(const std::uint8_t * ptr) noexcept
+{
+    std::uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+JSTD_FORCED_INLINE
+std::uint64_t wyhash_read3(const std::uint8_t * ptr, std::size_t len) noexcept
+{
+    return ((static_cast<std::uint64_t>(ptr[0]) << 16) |
+            (static_cast<std::uint64_t>(ptr[len >> 1]) << 8) |
+             static_cast<std::uint64_t>(ptr[len - 1]));
+}
+
+static inline
+std::uint64_t wyhash(const void * key, std::size_t len, std::uint64_t seed = 0,
+                     const std::uint64_t * secret = kWyHashSecret) noexcept
+{
+    const std::uint8_t * p = static_cast<const std::uint8_t *>(key);
+    seed ^= wyhash_mix(seed ^ secret[0], secret[1]);
+    std::uint64_t a, b;
+    if (JSTD_LIKELY(len <= 16)) {
+        if (JSTD_LIKELY(len >= 4)) {
+            std::size_t offset = ((len >> 3) << 2);
+            a = (wyhash_read32(p) << 32) | wyhash_read32(p + offset);
+            b = (wyhash_read32(p + len - 4) << 32) | wyhash_read32(p + len - 4 - offset);
+        } else if (JSTD_LIKELY(len > 0)) {
+            a = wyhash_read3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        std::size_t i = len;
+        if (JSTD_UNLIKELY(i > 48)) {
+            std::uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed  = wyhash_mix(wyhash_read64(p +  0) ^ secret[1], wyhash_read64(p +  8) ^ seed);
+                seed1 = wyhash_mix(wyhash_read64(p + 16) ^ secret[2], wyhash_read64(p + 24) ^ seed1);
+                seed2 = wyhash_mix(wyhash_read64(p + 32) ^ secret[3], wyhash_read64(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (JSTD_LIKELY(i > 48));
+            seed ^= seed1 ^ seed2;
+        }
+        while (JSTD_UNLIKELY(i > 16)) {
+            seed = wyhash_mix(wyhash_read64(p) ^ secret[1], wyhash_read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wyhash_read64(p + i - 16);
+        b = wyhash_read64(p + i - 8);
+    }
+    a ^= secret[1];
+    b ^= seed;
+    wyhash_mum(a, b);
+    return wyhash_mix(a ^ secret[0] ^ static_cast<std::uint64_t>(len), b ^ secret[1]);
+}
+
+//
+// The wyhash of two 64-bit integers, it's used for the integer keys.
+//
+JSTD_FORCED_INLINE
+std::uint64_t wyhash64(std::uint64_t a, std::uint64_t b) noexcept
+{
+    a ^= kWyHashSecret[0];
+    b ^= kWyHashSecret[1];
+    wyhash_mum(a, b);
+    return wyhash_mix(a ^ kWyHashSecret[0], b ^ kWyHashSecret[1]);
+}
+
+//
+// AES hash of the small fixed-size POD keys (struct keys of 16 to 64 bytes), each 16 bytes
+// block is absorbed by one aesenc round, then one more round, the two rounds of the last
+// block are a full diffusion of the 128 bits state, and the output is avalanching.
+//
+// The AES-NI is detected at compile-time (-maes), or at runtime on x86-64, the CPUs
+// without it use hashes::wyhash(). So the hash codes may be different on the other
+// machines, but they are stable in a process.
+//
+#if defined(JSTD_HAVE_AES)
+  #define JSTD_AES_HASH_ENABLED         1
+  #define JSTD_AES_HASH_RUNTIME_CHECK   0
+  #define JSTD_AES_HASH_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+  #define JSTD_AES_HASH_ENABLED         1
+  #define JSTD_AES_HASH_RUNTIME_CHECK   1
+  #define JSTD_AES_HASH_TARGET          __attribute__((target("aes")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+  #define JSTD_AES_HASH_ENABLED         1
+  #define JSTD_AES_HASH_RUNTIME_CHECK   1
+  #define JSTD_AES_HASH_TARGET
+#else
+  #define JSTD_AES_HASH_ENABLED         0
+  #define JSTD_AES_HASH_RUNTIME_CHECK   0
+#endif
+
+#if JSTD_AES_HASH_ENABLED
+
+static inline
+bool cpu_has_aes() noexcept
+{
+#if !JSTD_AES_HASH_RUNTIME_CHECK
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int cpu_info[4];
+    __cpuid(cpu_info, 1);
+    return ((cpu_info[2] & (1 << 25)) != 0);
+#else
+    return (__builtin_cpu_supports("aes") != 0);
+#endif
+}
+
+static inline
+bool aes_hash_is_supported() noexcept
+{
+    static const bool is_supported = cpu_has_aes();
+    return is_supported;
+}
+
+JSTD_AES_HASH_TARGET
+static inline
+std::uint64_t aes_hash_aesni(const void * key, std::size_t len, std::uint64_t seed) noexcept
+{
+    const std::uint8_t * p = static_cast<const std::uint8_t *>(key);
+    const __m128i kRoundKey0 = _mm_set_epi64x(static_cast<long long>(kWyHashSecret[0]),
+                                              static_cast<long long>(kWyHashSecret[1]));
+    const __m128i kRoundKey1 = _mm_set_epi64x(static_cast<long long>(kWyHashSecret[2]),
+                                              static_cast<long long>(kWyHashSecret[3]));
+    __m128i state = _mm_set_epi64x(static_cast<long long>(seed ^ kWyHashSecret[0]),
+                                   static_cast<long long>(len ^ kWyHashSecret[1]));
+    __m128i last_block;
+    if (len > 16) {
+        for (std::size_t offset = 0; (offset + 16) < len; offset += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + offset));
+            state = _mm_aesenc_si128(_mm_xor_si128(state, block), kRoundKey0);
+        }
+        // The last block overlaps the previous one if len isn't a multiple of 16.
+        last_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + len - 16));
+    } else if (len == 16) {
+        last_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    } else {
+        std::uint8_t buffer[16] = { 0 };
+        std::memcpy(buffer, p, len);
+        last_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer));
+    }
+    state = _mm_aesenc_si128(_mm_xor_si128(state, last_block), kRoundKey0);
+    state = _mm_aesenc_si128(state, kRoundKey1);
+
+    std::uint64_t parts[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(parts), state);
+    return (parts[0] ^ parts[1]);
+}
+
+#endif // JSTD_AES_HASH_ENABLED
+
+static inline
+std::uint64_t aes_hash(const void * key, std::size_t len, std::uint64_t seed = 0) noexcept
+{
+#if JSTD_AES_HASH_ENABLED
+  #if JSTD_AES_HASH_RUNTIME_CHECK
+    if (JSTD_LIKELY(aes_hash_is_supported()))
+        return aes_hash_aesni(key, len, seed);
+    else
+        return wyhash(key, len, seed);
+  #else
+    return aes_hash_aesni(key, len, seed);
+  #endif
+#else
+    return wyhash(key, len, seed);
+#endif
+}
+
 } // namespace hashes
 
 //
@@ -1600,6 +1963,69 @@ struct is_excluded_type<basic_string_view<CharT, Traits>> {
 
 //////////////////////////////////////////////////////////////////////////////////////
 
+//
+// The hasher of the string keys based on hashes::wyhash(), the hash codes are
+// avalanching, so the hash tables use them directly, without the extra mixing
+// of fibonacci_hash() or mum_hash().
+//
+struct WyHash
+{
+    typedef std::size_t     result_type;
+    typedef std::true_type  is_avalanching;
+
+    template <typename Integer, typename std::enable_if<
+                                (std::is_integral<Integer>::value &&
+                                (sizeof(Integer) <= 8))>::type * = nullptr>
+    result_type operator () (Integer value) const noexcept {
+        return static_cast<result_type>(hashes::wyhash64(static_cast<std::uint64_t>(value), 0));
+    }
+
+    template <typename CharT, typename Traits, typename Allocator>
+    result_type operator () (const std::basic_string<CharT, Traits, Allocator> & key) const noexcept {
+        return static_cast<result_type>(hashes::wyhash(key.data(), key.size() * sizeof(CharT)));
+    }
+
+    template <typename CharT, typename Traits>
+    result_type operator () (const jstd::basic_string_view<CharT, Traits> & key) const noexcept {
+        return static_cast<result_type>(hashes::wyhash(key.data(), key.size() * sizeof(CharT)));
+    }
+
+#if (jstd_cplusplus >= 2017L)
+    template <typename CharT, typename Traits>
+    result_type operator () (const std::basic_string_view<CharT, Traits> & key) const noexcept {
+        return static_cast<result_type>(hashes::wyhash(key.data(), key.size() * sizeof(CharT)));
+    }
+#endif
+
+    result_type operator () (const char * key) const noexcept {
+        return static_cast<result_type>(hashes::wyhash(key, std::char_traits<char>::length(key)));
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+//
+// The hasher of the fixed-size POD keys (e.g. the composite struct keys of 16 to 64 bytes)
+// based on hashes::aes_hash(), the hash codes are avalanching. All the bytes of the key
+// are hashed, so the key type mustn't have any padding bytes, or they must be zeroed.
+//
+template <typename T>
+struct AesHash
+{
+    typedef T               argument_type;
+    typedef std::size_t     result_type;
+    typedef std::true_type  is_avalanching;
+
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "jstd::AesHash<T>: T must be a trivially copyable type.");
+
+    result_type operator () (const T & key) const noexcept {
+        return static_cast<result_type>(hashes::aes_hash(&key, sizeof(T)));
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////
+
 template <typename Hasher>
 struct SimpleHash {
     //typedef typename Hasher::argument_type  argument_type;
@@ -1722,6 +2148,36 @@ public:
         return hash_code;
     }
 
+    //
+    // The batch hook, hash_codes[i] is the same as get_hash_code(keys[i]),
+    // the integral keys are hashed 4 at a time by hashes::fibonacci_hash_many().
+    //
+    template <typename Key>
+    void get_hash_codes(const Key * keys, size_type count, size_type * hash_codes) const noexcept {
+        this->get_hash_codes_impl(keys, count, hash_codes,
+            std::integral_constant<bool, (std::is_integral<Key>::value && (sizeof(Key) <= 8))>{});
+    }
+
+private:
+    template <typename Key>
+    void get_hash_codes_impl(const Key * keys, size_type count, size_type * hash_codes,
+                             std::true_type /* is integral */) const noexcept {
+        for (size_type i = 0; i < count; i++) {
+            hash_codes[i] = static_cast<size_type>(keys[i]);
+        }
+        hashes::fibonacci_hash_many(hash_codes, count, hash_codes);
+    }
+
+    template <typename Key>
+    void get_hash_codes_impl(const Key * keys, size_type count, size_type * hash_codes,
+                             std::false_type /* is integral */) const noexcept {
+        for (size_type i = 0; i < count; i++) {
+            hash_codes[i] = this->get_hash_code(keys[i]);
+        }
+    }
+
+public:
+
     template <typename Key>
     size_type index_for_hash(size_type hash_code, size_type /* mask */) const noexcept {
         static constexpr bool isExcludedType = is_excluded_type<Key>::value;
@@ -1785,6 +2241,36 @@ public:
         return hash_code;
     }
 
+    //
+    // The batch hook, hash_codes[i] is the same as get_hash_code(keys[i]),
+    // the integral keys are hashed 4 at a time by hashes::mum_hash_many().
+    //
+    template <typename Key>
+    void get_hash_codes(const Key * keys, size_type count, size_type * hash_codes) const noexcept {
+        this->get_hash_codes_impl(keys, count, hash_codes,
+            std::integral_constant<bool, (std::is_integral<Key>::value && (sizeof(Key) <= 8))>{});
+    }
+
+private:
+    template <typename Key>
+    void get_hash_codes_impl(const Key * keys, size_type count, size_type * hash_codes,
+                             std::true_type /* is integral */) const noexcept {
+        for (size_type i = 0; i < count; i++) {
+            hash_codes[i] = static_cast<size_type>(keys[i]);
+        }
+        hashes::mum_hash_many(hash_codes, count, hash_codes);
+    }
+
+    template <typename Key>
+    void get_hash_codes_impl(const Key * keys, size_type count, size_type * hash_codes,
+                             std::false_type /* is integral */) const noexcept {
+        for (size_type i = 0; i < count; i++) {
+            hash_codes[i] = this->get_hash_code(keys[i]);
+        }
+    }
+
+public:
+
     template <typename Key>
     size_type index_for_hash(size_type hash_code, size_type /* mask */) const noexcept {
         static constexpr bool isExcludedType = is_excluded_type<Key>::value;
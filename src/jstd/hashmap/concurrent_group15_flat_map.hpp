@@ -0,0 +1,595 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2024-2025 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+*************************************************************************************
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+  You are free to:
+
+    1. Share -- copy and redistribute the material in any medium or format.
+
+    2. Adapt -- remix, transforn, and build upon the material for any purpose,
+    even commerically.
+
+    The licensor cannot revoke these freedoms as long as you follow the license terms.
+
+  Under the following terms:
+
+    * Attribution -- You must give appropriate credit, provide a link to the license,
+    and indicate if changes were made. You may do so in any reasonable manner,
+    but not in any way that suggests the licensor endorses you or your use.
+
+    * ShareAlike -- If you remix, transform, or build upon the material, you must
+    distribute your contributions under the same license as the original.
+
+    * No additional restrictions -- You may not apply legal terms or technological
+    measures that legally restrict others from doing anything the license permits.
+
+  Notices:
+
+    * You do not have to comply with the license for elements of the material
+    in the public domain or where your use is permitted by an applicable exception
+    or limitation.
+
+    * No warranties are given. The license may not give you all of the permissions
+    necessary for your intended use. For example, other rights such as publicity,
+    privacy, or moral rights may limit how you use the material.
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_CONCURRENT_GROUP15_FLAT_MAP_HPP
+#define JSTD_HASHMAP_CONCURRENT_GROUP15_FLAT_MAP_HPP
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>               // For std::allocator<T>, std::unique_ptr<T>
+#include <functional>           // For std::hash<Key>
+#include <type_traits>
+#include <utility>              // For std::pair<F, S>
+#include <tuple>                // For std::forward_as_tuple()
+#include <algorithm>            // For std::max()
+#include <atomic>
+#include <assert.h>
+
+#include "jstd/basic/stddef.h"
+#include "jstd/support/BitUtils.h"
+#include "jstd/system/rw_spin_lock.h"
+
+#include "jstd/hashmap/flat_map_type_policy.hpp"
+#include "jstd/hashmap/group15_flat_table.hpp"
+
+namespace jstd {
+
+//
+// A concurrent hash map on the group15 layout, in the style of boost::concurrent_flat_map.
+//
+// Every group has a pair of tiny spin locks, which is stored in a parallel array
+// instead of in the 16 bytes group itself, so the SIMD layout of group15 is unchanged:
+//
+//   access: guards the ctrl bytes and the slots of the group,
+//           shared for the readers and exclusive for the writers.
+//   writer: taken on the home group of the key by the inserters only,
+//           the inserters of the same key are serialized by it, so there is no duplicate key.
+//
+// A thread holds at most one writer lock and one access lock at the same time,
+// so the group locks can't deadlock. The table-wide lock is taken shared
+// by all the operations, and exclusive only while growing or clearing the table.
+//
+// All the accesses to the elements are done by the callbacks, which is invoked
+// while the access lock is held, the callbacks must not re-enter the same map.
+//
+template <typename Key, typename Value,
+          typename Hash = std::hash< typename std::remove_const<Key>::type >,
+          typename KeyEqual = std::equal_to< typename std::remove_const<Key>::type >,
+          typename Allocator = std::allocator< std::pair<const typename std::remove_const<Key>::type,
+                                                         typename std::remove_const<Value>::type> > >
+class JSTD_DLL concurrent_group15_flat_map
+{
+public:
+    typedef jstd::flat_map_type_policy<Key, Value>  type_policy;
+    typedef std::size_t                             size_type;
+    typedef std::intptr_t                           ssize_type;
+    typedef std::ptrdiff_t                          difference_type;
+
+    typedef typename type_policy::key_type      key_type;
+    typedef typename type_policy::mapped_type   mapped_type;
+    typedef typename type_policy::value_type    value_type;
+    typedef typename type_policy::init_type     init_type;
+    typedef Hash                                hasher;
+    typedef KeyEqual                            key_equal;
+    typedef Allocator                           allocator_type;
+
+    typedef jstd::group15_flat_table<type_policy, Hash, KeyEqual,
+        typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>>
+                                                table_type;
+
+    typedef typename table_type::group_type     group_type;
+    typedef typename table_type::slot_type      slot_type;
+    typedef typename table_type::prober_type    prober_type;
+    typedef typename table_type::SlotPolicyTraits SlotPolicyTraits;
+
+    typedef jstd::rw_spin_lock                  lock_type;
+
+    using this_type = jstd::concurrent_group15_flat_map<Key, Value, Hash, KeyEqual, Allocator>;
+
+    static constexpr size_type kGroupSize = table_type::kGroupSize;
+
+private:
+    struct group_access {
+        lock_type access;
+        lock_type writer;
+    };
+
+    template <bool IsExclusive>
+    struct access_guard {
+        lock_type & lock;
+
+        explicit access_guard(lock_type & _lock) noexcept : lock(_lock) {
+            if (IsExclusive)
+                this->lock.lock();
+            else
+                this->lock.lock_shared();
+        }
+
+        ~access_guard() {
+            if (IsExclusive)
+                this->lock.unlock();
+            else
+                this->lock.unlock_shared();
+        }
+    };
+
+    mutable lock_type               table_lock_;
+    table_type                      table_;
+    std::unique_ptr<group_access[]> group_access_;
+    std::atomic<size_type>          slot_size_;
+    std::atomic<size_type>          slot_threshold_;
+
+public:
+    ///
+    /// Constructors
+    ///
+    concurrent_group15_flat_map() : concurrent_group15_flat_map(0) {}
+
+    explicit concurrent_group15_flat_map(size_type capacity, hasher const & hash = hasher(),
+                                         key_equal const & pred = key_equal(),
+                                         allocator_type const & allocator = allocator_type())
+        : table_(capacity, hash, pred, allocator), group_access_(),
+          slot_size_(0), slot_threshold_(0) {
+        this->sync_from_table();
+    }
+
+    concurrent_group15_flat_map(concurrent_group15_flat_map const &) = delete;
+    concurrent_group15_flat_map(concurrent_group15_flat_map &&) = delete;
+
+    ~concurrent_group15_flat_map() = default;
+
+    concurrent_group15_flat_map & operator = (concurrent_group15_flat_map const &) = delete;
+    concurrent_group15_flat_map & operator = (concurrent_group15_flat_map &&) = delete;
+
+    ///
+    /// Observers
+    ///
+    hasher hash_function() const noexcept {
+        return this->table_.hash_function();
+    }
+
+    key_equal key_eq() const noexcept {
+        return this->table_.key_eq();
+    }
+
+    static const char * name() noexcept {
+        return "jstd::concurrent_group15_flat_map<K, V>";
+    }
+
+    ///
+    /// Capacity
+    ///
+    bool empty() const noexcept { return (this->size() == 0); }
+    size_type size() const noexcept { return this->slot_size_.load(std::memory_order_relaxed); }
+
+    size_type capacity() const noexcept {
+        jstd::shared_lock_guard<lock_type> table_guard(this->table_lock_);
+        return this->table_.capacity();
+    }
+
+    ///
+    /// Hash policy
+    ///
+    void reserve(size_type new_capacity) {
+        jstd::exclusive_lock_guard<lock_type> table_guard(this->table_lock_);
+        this->sync_to_table();
+        this->table_.reserve(new_capacity);
+        this->sync_from_table();
+    }
+
+    void rehash(size_type new_capacity) {
+        jstd::exclusive_lock_guard<lock_type> table_guard(this->table_lock_);
+        this->sync_to_table();
+        this->table_.rehash(new_capacity);
+        this->sync_from_table();
+    }
+
+    ///
+    /// Lookup
+    ///
+    bool contains(const key_type & key) const {
+        return this->cvisit(key, [](const value_type &) {});
+    }
+
+    size_type count(const key_type & key) const {
+        return (this->contains(key) ? 1 : 0);
+    }
+
+    ///
+    /// visit(key, f): f(value_type &) under the exclusive group lock.
+    ///
+    template <typename F>
+    bool visit(const key_type & key, F && f) {
+        std::size_t key_hash = this->table_.hash_for(key);
+        jstd::shared_lock_guard<lock_type> table_guard(this->table_lock_);
+        return this->visit_impl<true>(key, key_hash, f);
+    }
+
+    template <typename F>
+    bool visit(const key_type & key, F && f) const {
+        return this->cvisit(key, std::forward<F>(f));
+    }
+
+    ///
+    /// cvisit(key, f): f(const value_type &) under the shared group lock.
+    ///
+    template <typename F>
+    bool cvisit(const key_type & key, F && f) const {
+        std::size_t key_hash = this->table_.hash_for(key);
+        jstd::shared_lock_guard<lock_type> table_guard(this->table_lock_);
+        return const_cast<this_type *>(this)->template visit_impl<false>(key, key_hash,
+            [&f](const value_type & value) { f(value); });
+    }
+
+    ///
+    /// visit_all(f): visit all elements, one group at a time.
+    ///
+    template <typename F>
+    void visit_all(F && f) {
+        jstd::shared_lock_guard<lock_type> table_guard(this->table_lock_);
+        this->for_each_slot<true>([&f](slot_type * slot) {
+            f(slot->value);
+            return false;
+        });
+    }
+
+    template <typename F>
+    void cvisit_all(F && f) const {
+        jstd::shared_lock_guard<lock_type> table_guard(this->table_lock_);
+        const_cast<this_type *>(this)->template for_each_slot<false>([&f](slot_type * slot) {
+            f(static_cast<const value_type &>(slot->value));
+            return false;
+        });
+    }
+
+    ///
+    /// Modifiers
+    ///
+    void clear() noexcept {
+        jstd::exclusive_lock_guard<lock_type> table_guard(this->table_lock_);
+        this->sync_to_table();
+        this->table_.clear();
+        this->sync_from_table();
+    }
+
+    ///
+    /// insert(value)
+    ///
+    bool insert(const value_type & value) {
+        return this->emplace_or_visit_impl(value.first, [](value_type &) {}, value);
+    }
+
+    bool insert(value_type && value) {
+        return this->emplace_or_visit_impl(value.first, [](value_type &) {}, std::move(value));
+    }
+
+    bool insert(const init_type & value) {
+        return this->emplace_or_visit_impl(value.first, [](value_type &) {}, value);
+    }
+
+    bool insert(init_type && value) {
+        return this->emplace_or_visit_impl(value.first, [](value_type &) {}, std::move(value));
+    }
+
+    ///
+    /// insert_or_visit(value, f): insert the value, or f(value_type &) if the key exists.
+    ///
+    template <typename F>
+    bool insert_or_visit(const value_type & value, F && f) {
+        return this->emplace_or_visit_impl(value.first, f, value);
+    }
+
+    template <typename F>
+    bool insert_or_visit(value_type && value, F && f) {
+        return this->emplace_or_visit_impl(value.first, f, std::move(value));
+    }
+
+    template <typename F>
+    bool insert_or_visit(const init_type & value, F && f) {
+        return this->emplace_or_visit_impl(value.first, f, value);
+    }
+
+    template <typename F>
+    bool insert_or_visit(init_type && value, F && f) {
+        return this->emplace_or_visit_impl(value.first, f, std::move(value));
+    }
+
+    ///
+    /// emplace(key, value)
+    ///
+    template <typename KeyT, typename MappedT>
+    bool emplace(KeyT && key, MappedT && value) {
+        return this->emplace_or_visit(std::forward<KeyT>(key), std::forward<MappedT>(value),
+                                      [](value_type &) {});
+    }
+
+    ///
+    /// emplace_or_visit(key, value, f): emplace the pair, or f(value_type &) if the key exists.
+    ///
+    template <typename KeyT, typename MappedT, typename F>
+    bool emplace_or_visit(KeyT && key, MappedT && value, F && f) {
+        const key_type & key_ref = key;
+        return this->emplace_or_visit_impl(key_ref, f, std::forward<KeyT>(key),
+                                                       std::forward<MappedT>(value));
+    }
+
+    ///
+    /// try_emplace(key, args...)
+    ///
+    template <typename ... Args>
+    bool try_emplace(const key_type & key, Args && ... args) {
+        return this->emplace_or_visit_impl(key, [](value_type &) {},
+                                           std::piecewise_construct,
+                                           std::forward_as_tuple(key),
+                                           std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <typename ... Args>
+    bool try_emplace(key_type && key, Args && ... args) {
+        return this->emplace_or_visit_impl(key, [](value_type &) {},
+                                           std::piecewise_construct,
+                                           std::forward_as_tuple(std::move(key)),
+                                           std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    ///
+    /// erase(key)
+    ///
+    size_type erase(const key_type & key) {
+        return this->erase_if(key, [](const value_type &) { return true; });
+    }
+
+    ///
+    /// erase_if(key, pred): erase the element if pred(const value_type &) returns true.
+    ///
+    template <typename Pred>
+    size_type erase_if(const key_type & key, Pred && pred) {
+        std::size_t key_hash = this->table_.hash_for(key);
+        jstd::shared_lock_guard<lock_type> table_guard(this->table_lock_);
+
+        size_type group_index0 = this->table_.index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->table_.ctrl_for_hash(key_hash);
+        auto hash_bits = group_type::make_hash_bits(ctrl_hash);
+        prober_type prober(group_index0);
+
+        do {
+            size_type group_index = prober.get();
+            group_type * group = this->table_.groups() + group_index;
+            jstd::exclusive_lock_guard<lock_type> guard(this->group_access_[group_index].access);
+            std::uint32_t match_mask = group->match_hash(hash_bits);
+            while (match_mask != 0) {
+                std::uint32_t match_pos = BitUtils::bsf32(match_mask);
+                slot_type * slot = this->slot_at(group_index, match_pos);
+                if (this->table_.key_equal_(key, slot->get_key())) {
+                    if (pred(static_cast<const value_type &>(slot->value))) {
+                        this->erase_slot(group, match_pos, slot);
+                        return 1;
+                    }
+                    return 0;
+                }
+                match_mask = BitUtils::clearLowBit32(match_mask);
+            }
+            if (group->is_not_overflow(ctrl_hash)) {
+                break;
+            }
+        } while (prober.next_bucket(this->table_.group_mask()));
+
+        return 0;
+    }
+
+    ///
+    /// erase_if(pred): erase all the elements that pred(const value_type &) returns true.
+    ///
+    template <typename Pred>
+    size_type erase_if(Pred && pred) {
+        size_type num_deleted = 0;
+        jstd::shared_lock_guard<lock_type> table_guard(this->table_lock_);
+        this->for_each_slot<true>([&pred](slot_type * slot) {
+            return pred(static_cast<const value_type &>(slot->value));
+        }, [this, &num_deleted](group_type * group, std::uint32_t pos, slot_type * slot) {
+            this->erase_slot(group, pos, slot);
+            num_deleted++;
+        });
+        return num_deleted;
+    }
+
+private:
+    JSTD_FORCED_INLINE
+    slot_type * slot_at(size_type group_index, std::uint32_t pos) noexcept {
+        return (this->table_.slots() + group_index * kGroupSize + pos);
+    }
+
+    // Must hold the exclusive table lock.
+    void sync_to_table() noexcept {
+        this->table_.slot_size_ = this->slot_size_.load(std::memory_order_relaxed);
+        this->table_.slot_threshold_ = this->slot_threshold_.load(std::memory_order_relaxed);
+    }
+
+    // Must hold the exclusive table lock, or in the constructor.
+    void sync_from_table() {
+        this->slot_size_.store(this->table_.slot_size_, std::memory_order_relaxed);
+        this->slot_threshold_.store(this->table_.slot_threshold_, std::memory_order_relaxed);
+        // The empty table uses two static empty groups, see default_empty_groups().
+        size_type group_capacity = (std::max)(this->table_.group_capacity(), size_type(2));
+        this->group_access_.reset(new group_access[group_capacity]);
+    }
+
+    void grow_if_necessary() {
+        jstd::exclusive_lock_guard<lock_type> table_guard(this->table_lock_);
+        // Other thread may have grown the table already.
+        if (this->slot_size_.load(std::memory_order_relaxed) >=
+            this->slot_threshold_.load(std::memory_order_relaxed)) {
+            this->sync_to_table();
+            this->table_.grow_if_necessary();
+            this->sync_from_table();
+        }
+    }
+
+    // Must hold the exclusive access lock of the group.
+    void erase_slot(group_type * group, std::uint32_t pos, slot_type * slot) {
+        this->table_.destroy_slot(slot);
+        bool maybe_overflow = this->table_.maybe_caused_overflow(group, pos);
+        group->set_empty(pos);
+        this->slot_threshold_.fetch_sub(maybe_overflow ? 1 : 0, std::memory_order_relaxed);
+        this->slot_size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    template <bool IsExclusive, typename F>
+    bool visit_impl(const key_type & key, std::size_t key_hash, F && f) {
+        size_type group_index0 = this->table_.index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->table_.ctrl_for_hash(key_hash);
+        auto hash_bits = group_type::make_hash_bits(ctrl_hash);
+        prober_type prober(group_index0);
+
+        do {
+            size_type group_index = prober.get();
+            const group_type * group = this->table_.groups() + group_index;
+            access_guard<IsExclusive> guard(this->group_access_[group_index].access);
+            std::uint32_t match_mask = group->match_hash(hash_bits);
+            while (match_mask != 0) {
+                std::uint32_t match_pos = BitUtils::bsf32(match_mask);
+                slot_type * slot = this->slot_at(group_index, match_pos);
+                if (this->table_.key_equal_(key, slot->get_key())) {
+                    f(slot->value);
+                    return true;
+                }
+                match_mask = BitUtils::clearLowBit32(match_mask);
+            }
+            if (group->is_not_overflow(ctrl_hash)) {
+                break;
+            }
+        } while (prober.next_bucket(this->table_.group_mask()));
+
+        return false;
+    }
+
+    template <typename F, typename ... Args>
+    bool emplace_or_visit_impl(const key_type & key, F && f, Args && ... args) {
+        std::size_t key_hash = this->table_.hash_for(key);
+        for (;;) {
+            {
+                jstd::shared_lock_guard<lock_type> table_guard(this->table_lock_);
+
+                size_type group_index0 = this->table_.index_for_hash(key_hash);
+                jstd::exclusive_lock_guard<lock_type> writer_guard(this->group_access_[group_index0].writer);
+
+                if (this->visit_impl<true>(key, key_hash, f)) {
+                    return false;
+                }
+
+                size_type old_size = this->slot_size_.fetch_add(1, std::memory_order_relaxed);
+                if (JSTD_LIKELY(old_size < this->slot_threshold_.load(std::memory_order_relaxed))) {
+                    std::size_t ctrl_hash = this->table_.ctrl_for_hash(key_hash);
+                    try {
+                        this->unique_insert(group_index0, ctrl_hash, std::forward<Args>(args)...);
+                    } catch (...) {
+                        this->slot_size_.fetch_sub(1, std::memory_order_relaxed);
+                        throw;
+                    }
+                    return true;
+                }
+                this->slot_size_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            // The table is full, release all the locks and grow it, then try again.
+            this->grow_if_necessary();
+        }
+    }
+
+    template <typename ... Args>
+    void unique_insert(size_type group_index0, std::size_t ctrl_hash, Args && ... args) {
+        prober_type prober(group_index0);
+        for (;;) {
+            size_type group_index = prober.get();
+            group_type * group = this->table_.groups() + group_index;
+            jstd::exclusive_lock_guard<lock_type> guard(this->group_access_[group_index].access);
+            std::uint32_t empty_mask = group->match_empty();
+            if (JSTD_LIKELY(empty_mask != 0)) {
+                std::uint32_t empty_pos = BitUtils::bsf32(empty_mask);
+                slot_type * slot = this->slot_at(group_index, empty_pos);
+                SlotPolicyTraits::construct(&this->table_.slot_allocator_, slot,
+                                            std::forward<Args>(args)...);
+                group->set_used(empty_pos, ctrl_hash);
+                return;
+            } else {
+                group->set_overflow(ctrl_hash);
+            }
+            // Because (slot_size < slot_threshold), there must be a empty slot.
+            prober.next_bucket(this->table_.group_mask());
+        }
+    }
+
+    template <bool IsExclusive, typename Pred>
+    void for_each_slot(Pred && pred) {
+        this->for_each_slot<IsExclusive>(std::forward<Pred>(pred),
+            [](group_type *, std::uint32_t, slot_type *) {});
+    }
+
+    //
+    // Call pred(slot) for each used slot, if it returns true, then call action(group, pos, slot).
+    //
+    template <bool IsExclusive, typename Pred, typename Action>
+    void for_each_slot(Pred && pred, Action && action) {
+        size_type group_capacity = this->table_.group_capacity();
+        if (this->table_.slots() == nullptr)
+            return;
+        for (size_type group_index = 0; group_index < group_capacity; group_index++) {
+            group_type * group = this->table_.groups() + group_index;
+            access_guard<IsExclusive> guard(this->group_access_[group_index].access);
+            std::uint32_t used_mask = group->match_used();
+            while (used_mask != 0) {
+                std::uint32_t used_pos = BitUtils::bsf32(used_mask);
+                if (JSTD_UNLIKELY(group->is_sentinel(used_pos)))
+                    break;
+                slot_type * slot = this->slot_at(group_index, used_pos);
+                if (pred(slot)) {
+                    action(group, used_pos, slot);
+                }
+                used_mask = BitUtils::clearLowBit32(used_mask);
+            }
+        }
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_CONCURRENT_GROUP15_FLAT_MAP_HPP
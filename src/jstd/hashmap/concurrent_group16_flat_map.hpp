@@ -0,0 +1,468 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2024-2025 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+*************************************************************************************
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+  You are free to:
+
+    1. Share -- copy and redistribute the material in any medium or format.
+
+    2. Adapt -- remix, transforn, and build upon the material for any purpose,
+    even commerically.
+
+    The licensor cannot revoke these freedoms as long as you follow the license terms.
+
+  Under the following terms:
+
+    * Attribution -- You must give appropriate credit, provide a link to the license,
+    and indicate if changes were made. You may do so in any reasonable manner,
+    but not in any way that suggests the licensor endorses you or your use.
+
+    * ShareAlike -- If you remix, transform, or build upon the material, you must
+    distribute your contributions under the same license as the original.
+
+    * No additional restrictions -- You may not apply legal terms or technological
+    measures that legally restrict others from doing anything the license permits.
+
+  Notices:
+
+    * You do not have to comply with the license for elements of the material
+    in the public domain or where your use is permitted by an applicable exception
+    or limitation.
+
+    * No warranties are given. The license may not give you all of the permissions
+    necessary for your intended use. For example, other rights such as publicity,
+    privacy, or moral rights may limit how you use the material.
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_CONCURRENT_GROUP16_FLAT_MAP_HPP
+#define JSTD_HASHMAP_CONCURRENT_GROUP16_FLAT_MAP_HPP
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>               // For std::allocator<T>, std::unique_ptr<T>
+#include <functional>           // For std::hash<Key>
+#include <type_traits>
+#include <utility>              // For std::pair<F, S>
+#include <assert.h>
+
+#include "jstd/basic/stddef.h"
+#include "jstd/system/rw_spin_lock.h"
+#include "jstd/hasher/hashes.h"
+
+#include "jstd/hashmap/detail/hashmap_traits.h"
+#include "jstd/hashmap/flat_map_type_policy.hpp"
+#include "jstd/hashmap/group16_flat_table.hpp"
+
+namespace jstd {
+
+//
+// A sharded concurrent hash map, the key space is split into (1 << shard_bits) shards,
+// each shard is a group16_flat_table guarded by it's own reader/writer spin lock.
+//
+// No reference or iterator escapes the lock, all the accesses to the elements
+// are done by the callbacks, which is invoked while the shard lock is held.
+// So the callbacks must not re-enter the same map.
+//
+template <typename Key, typename Value,
+          typename Hash = std::hash< typename std::remove_const<Key>::type >,
+          typename KeyEqual = std::equal_to< typename std::remove_const<Key>::type >,
+          typename Allocator = std::allocator< std::pair<const typename std::remove_const<Key>::type,
+                                                         typename std::remove_const<Value>::type> > >
+class JSTD_DLL concurrent_group16_flat_map
+{
+public:
+    typedef jstd::flat_map_type_policy<Key, Value>  type_policy;
+    typedef std::size_t                             size_type;
+    typedef std::intptr_t                           ssize_type;
+    typedef std::ptrdiff_t                          difference_type;
+
+    typedef typename type_policy::key_type      key_type;
+    typedef typename type_policy::mapped_type   mapped_type;
+    typedef typename type_policy::value_type    value_type;
+    typedef typename type_policy::init_type     init_type;
+    typedef Hash                                hasher;
+    typedef KeyEqual                            key_equal;
+    typedef Allocator                           allocator_type;
+
+    typedef jstd::group16_flat_table<type_policy, Hash, KeyEqual,
+        typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>>
+                                                table_type;
+
+    typedef jstd::rw_spin_lock                  lock_type;
+
+    using this_type = jstd::concurrent_group16_flat_map<Key, Value, Hash, KeyEqual, Allocator>;
+
+    static constexpr size_type kCacheLineSize = 64;
+
+    static constexpr size_type kDefaultShardBits = 6;
+    static constexpr size_type kMaxShardBits = 16;
+
+    //
+    // The group index of table uses the high bits of the hash code, and the ctrl hash
+    // uses the low 7 bits, if the shard index also takes the top bits, all the keys
+    // in a shard will crowd into (1 / shard_count) of it's groups. So we take
+    // the shard index from the bits just above the ctrl hash, they are only reached
+    // by the group index when a shard has more than 2^(64 - 8 - kMaxShardBits) groups.
+    //
+    static constexpr size_type kShardHashShift = 8;
+
+private:
+    struct alignas(kCacheLineSize) shard_type {
+        mutable lock_type lock;
+        table_type        table;
+    };
+
+    std::unique_ptr<shard_type[]> shards_;
+    size_type                     shard_mask_;
+    hasher                        hasher_;
+
+public:
+    ///
+    /// Constructors
+    ///
+    concurrent_group16_flat_map() : concurrent_group16_flat_map(0) {}
+
+    explicit concurrent_group16_flat_map(size_type capacity,
+                                         size_type shard_bits = kDefaultShardBits,
+                                         hasher const & hash = hasher(),
+                                         key_equal const & pred = key_equal(),
+                                         allocator_type const & allocator = allocator_type())
+        : shards_(), shard_mask_(0), hasher_(hash) {
+        shard_bits = (std::min)(shard_bits, kMaxShardBits);
+        size_type shard_count = size_type(1) << shard_bits;
+        this->shard_mask_ = shard_count - 1;
+        this->shards_.reset(new shard_type[shard_count]);
+
+        size_type shard_capacity = (capacity + shard_count - 1) / shard_count;
+        for (size_type i = 0; i < shard_count; i++) {
+            this->shards_[i].table = table_type(shard_capacity, hash, pred, allocator);
+        }
+    }
+
+    concurrent_group16_flat_map(concurrent_group16_flat_map const &) = delete;
+    concurrent_group16_flat_map(concurrent_group16_flat_map &&) = delete;
+
+    ~concurrent_group16_flat_map() = default;
+
+    concurrent_group16_flat_map & operator = (concurrent_group16_flat_map const &) = delete;
+    concurrent_group16_flat_map & operator = (concurrent_group16_flat_map &&) = delete;
+
+    ///
+    /// Observers
+    ///
+    hasher hash_function() const noexcept {
+        return this->hasher_;
+    }
+
+    static const char * name() noexcept {
+        return "jstd::concurrent_group16_flat_map<K, V>";
+    }
+
+    ///
+    /// Capacity
+    ///
+    size_type shard_count() const noexcept { return (this->shard_mask_ + 1); }
+
+    bool empty() const noexcept { return (this->size() == 0); }
+
+    //
+    // Each shard is locked in turn, the result is not a snapshot
+    // if there are concurrent writers.
+    //
+    size_type size() const noexcept {
+        size_type total_size = 0;
+        for (size_type i = 0; i <= this->shard_mask_; i++) {
+            const shard_type & shard = this->shards_[i];
+            jstd::shared_lock_guard<lock_type> guard(shard.lock);
+            total_size += shard.table.size();
+        }
+        return total_size;
+    }
+
+    size_type capacity() const noexcept {
+        size_type total_capacity = 0;
+        for (size_type i = 0; i <= this->shard_mask_; i++) {
+            const shard_type & shard = this->shards_[i];
+            jstd::shared_lock_guard<lock_type> guard(shard.lock);
+            total_capacity += shard.table.capacity();
+        }
+        return total_capacity;
+    }
+
+    ///
+    /// Hash policy
+    ///
+    void reserve(size_type new_capacity) {
+        size_type shard_capacity = (new_capacity + this->shard_mask_) / this->shard_count();
+        for (size_type i = 0; i <= this->shard_mask_; i++) {
+            shard_type & shard = this->shards_[i];
+            jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+            shard.table.reserve(shard_capacity);
+        }
+    }
+
+    void shrink_to_fit() {
+        for (size_type i = 0; i <= this->shard_mask_; i++) {
+            shard_type & shard = this->shards_[i];
+            jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+            shard.table.shrink_to_fit();
+        }
+    }
+
+    ///
+    /// Lookup
+    ///
+    bool contains(const key_type & key) const {
+        const shard_type & shard = this->shard_for(key);
+        jstd::shared_lock_guard<lock_type> guard(shard.lock);
+        return shard.table.contains(key);
+    }
+
+    size_type count(const key_type & key) const {
+        return (this->contains(key) ? 1 : 0);
+    }
+
+    ///
+    /// find(key, f): f(const value_type &) under the shared lock.
+    ///
+    template <typename F>
+    bool find(const key_type & key, F && f) const {
+        return this->cvisit(key, std::forward<F>(f));
+    }
+
+    ///
+    /// visit(key, f): f(value_type &) under the exclusive lock.
+    ///
+    template <typename F>
+    bool visit(const key_type & key, F && f) {
+        shard_type & shard = this->shard_for(key);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        auto iter = shard.table.find(key);
+        if (iter != shard.table.end()) {
+            f(*iter);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename F>
+    bool visit(const key_type & key, F && f) const {
+        return this->cvisit(key, std::forward<F>(f));
+    }
+
+    template <typename F>
+    bool cvisit(const key_type & key, F && f) const {
+        const shard_type & shard = this->shard_for(key);
+        jstd::shared_lock_guard<lock_type> guard(shard.lock);
+        auto iter = shard.table.find(key);
+        if (iter != shard.table.end()) {
+            f(static_cast<const value_type &>(*iter));
+            return true;
+        }
+        return false;
+    }
+
+    ///
+    /// visit_all(f): visit all elements, one shard at a time.
+    ///
+    template <typename F>
+    void visit_all(F && f) {
+        for (size_type i = 0; i <= this->shard_mask_; i++) {
+            shard_type & shard = this->shards_[i];
+            jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+            for (auto iter = shard.table.begin(); iter != shard.table.end(); ++iter) {
+                f(*iter);
+            }
+        }
+    }
+
+    template <typename F>
+    void cvisit_all(F && f) const {
+        for (size_type i = 0; i <= this->shard_mask_; i++) {
+            const shard_type & shard = this->shards_[i];
+            jstd::shared_lock_guard<lock_type> guard(shard.lock);
+            for (auto iter = shard.table.cbegin(); iter != shard.table.cend(); ++iter) {
+                f(static_cast<const value_type &>(*iter));
+            }
+        }
+    }
+
+    ///
+    /// Modifiers
+    ///
+    void clear() noexcept {
+        for (size_type i = 0; i <= this->shard_mask_; i++) {
+            shard_type & shard = this->shards_[i];
+            jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+            shard.table.clear();
+        }
+    }
+
+    ///
+    /// insert(value)
+    ///
+    bool insert(const value_type & value) {
+        shard_type & shard = this->shard_for(value.first);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        return shard.table.insert(value).second;
+    }
+
+    bool insert(value_type && value) {
+        shard_type & shard = this->shard_for(value.first);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        return shard.table.insert(std::move(value)).second;
+    }
+
+    bool insert(const init_type & value) {
+        shard_type & shard = this->shard_for(value.first);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        return shard.table.insert(value).second;
+    }
+
+    bool insert(init_type && value) {
+        shard_type & shard = this->shard_for(value.first);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        return shard.table.insert(std::move(value)).second;
+    }
+
+    ///
+    /// insert_or_visit(value, f): insert the value, or f(value_type &) if the key exists.
+    ///
+    template <typename ValueT, typename F>
+    bool insert_or_visit(ValueT && value, F && f) {
+        shard_type & shard = this->shard_for(value.first);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        auto result = shard.table.insert(std::forward<ValueT>(value));
+        if (!result.second) {
+            f(*result.first);
+        }
+        return result.second;
+    }
+
+    ///
+    /// insert_or_assign(key, value)
+    ///
+    template <typename KeyT, typename MappedT>
+    bool insert_or_assign(KeyT && key, MappedT && value) {
+        shard_type & shard = this->shard_for(key);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        return shard.table.insert_or_assign(std::forward<KeyT>(key),
+                                            std::forward<MappedT>(value)).second;
+    }
+
+    ///
+    /// emplace(args...)
+    ///
+    template <typename ... Args>
+    bool emplace(Args && ... args) {
+        // We need the key to select the shard before taking the lock.
+        init_type value(std::forward<Args>(args)...);
+        return this->insert(std::move(value));
+    }
+
+    ///
+    /// try_emplace(key, args...)
+    ///
+    template <typename KeyT, typename ... Args>
+    bool try_emplace(KeyT && key, Args && ... args) {
+        shard_type & shard = this->shard_for(key);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        return shard.table.try_emplace(std::forward<KeyT>(key),
+                                       std::forward<Args>(args)...).second;
+    }
+
+    ///
+    /// erase(key)
+    ///
+    size_type erase(const key_type & key) {
+        shard_type & shard = this->shard_for(key);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        return shard.table.erase(key);
+    }
+
+    ///
+    /// erase_if(key, pred): erase the element if pred(const value_type &) returns true.
+    ///
+    template <typename Pred>
+    size_type erase_if(const key_type & key, Pred && pred) {
+        shard_type & shard = this->shard_for(key);
+        jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+        auto iter = shard.table.find(key);
+        if (iter != shard.table.end()) {
+            if (pred(static_cast<const value_type &>(*iter))) {
+                shard.table.erase(iter);
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    ///
+    /// erase_if(pred): erase all the elements that pred(const value_type &) returns true.
+    ///
+    template <typename Pred>
+    size_type erase_if(Pred && pred) {
+        size_type num_deleted = 0;
+        for (size_type i = 0; i <= this->shard_mask_; i++) {
+            shard_type & shard = this->shards_[i];
+            jstd::exclusive_lock_guard<lock_type> guard(shard.lock);
+            auto iter = shard.table.begin();
+            while (iter != shard.table.end()) {
+                if (pred(static_cast<const value_type &>(*iter))) {
+                    iter = shard.table.erase(iter);
+                    num_deleted++;
+                } else {
+                    ++iter;
+                }
+            }
+        }
+        return num_deleted;
+    }
+
+private:
+    JSTD_FORCED_INLINE
+    std::size_t hash_for(const key_type & key) const
+        noexcept(noexcept(std::declval<const hasher &>()(key))) {
+        std::size_t key_hash = static_cast<std::size_t>(this->hasher_(key));
+        if (!jstd::detail::hash_is_avalanching<Hash>::value)
+            key_hash = hashes::mum_mul_mix(key_hash);
+        return key_hash;
+    }
+
+    JSTD_FORCED_INLINE
+    size_type shard_index(const key_type & key) const {
+        std::size_t key_hash = this->hash_for(key);
+        return static_cast<size_type>((key_hash >> kShardHashShift) & this->shard_mask_);
+    }
+
+    JSTD_FORCED_INLINE
+    shard_type & shard_for(const key_type & key) {
+        return this->shards_[this->shard_index(key)];
+    }
+
+    JSTD_FORCED_INLINE
+    const shard_type & shard_for(const key_type & key) const {
+        return this->shards_[this->shard_index(key)];
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_CONCURRENT_GROUP16_FLAT_MAP_HPP
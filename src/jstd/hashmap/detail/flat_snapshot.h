@@ -0,0 +1,159 @@
+
+#ifndef JSTD_HASHMAP_DETAIL_FLAT_SNAPSHOT_H
+#define JSTD_HASHMAP_DETAIL_FLAT_SNAPSHOT_H
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>       // For std::fopen(), std::fwrite()
+#include <cstring>      // For std::memcmp(), std::memcpy()
+
+#include "jstd/system/mapped_file.h"
+
+namespace jstd {
+namespace detail {
+
+//
+// The snapshot file of a flat table:
+//
+//   [flat_snapshot_header] [groups array] [slots array]
+//
+// Each array starts at a multiple of kSnapshotAlignment, the mapped file
+// starts at a page boundary, so the arrays can be used in place.
+//
+static constexpr std::size_t   kSnapshotAlignment = 64;
+static constexpr std::uint32_t kSnapshotVersion   = 1;
+static constexpr std::uint32_t kSnapshotByteOrder = 0x01020304u;
+
+struct flat_snapshot_header {
+    char            magic[8];
+    std::uint32_t   version;
+    std::uint32_t   byte_order;
+    std::uint32_t   group_bytes;        // sizeof(group_type)
+    std::uint32_t   slot_bytes;         // sizeof(slot_type)
+    std::uint32_t   key_bytes;          // sizeof(key_type)
+    std::uint32_t   mapped_bytes;       // sizeof(mapped_type)
+    std::uint64_t   slot_size;
+    std::uint64_t   slot_capacity;
+    std::uint64_t   group_capacity;
+    std::uint64_t   slot_threshold;
+    std::uint64_t   max_load_factor;
+    // hash_for() of the key in the slot check_index, to verify the hasher (or it's seed)
+    std::uint64_t   hash_check;
+    std::uint64_t   check_index;
+    std::uint64_t   groups_offset;
+    std::uint64_t   slots_offset;
+    std::uint64_t   file_size;
+    std::uint64_t   reserved[2];
+};
+
+static_assert((sizeof(flat_snapshot_header) % kSnapshotAlignment) == 0,
+              "jstd::detail::flat_snapshot_header: the size must be a multiple of kSnapshotAlignment.");
+
+static inline
+std::uint64_t snapshot_align(std::uint64_t offset) noexcept {
+    return ((offset + kSnapshotAlignment - 1) & ~std::uint64_t(kSnapshotAlignment - 1));
+}
+
+//
+// The sizes of the element types, to reject a snapshot of the other map type.
+//
+struct flat_snapshot_layout {
+    const char *    magic;              // 8 bytes, including the '\0'
+    std::size_t     group_bytes;
+    std::size_t     slot_bytes;
+    std::size_t     key_bytes;
+    std::size_t     mapped_bytes;
+};
+
+//
+// Fill the magic, version, layout and the array offsets of the header.
+//
+static inline
+void init_snapshot_header(flat_snapshot_header & header, const flat_snapshot_layout & layout,
+                          std::size_t group_capacity, std::size_t slot_capacity) noexcept {
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, layout.magic, sizeof(header.magic));
+    header.version = kSnapshotVersion;
+    header.byte_order = kSnapshotByteOrder;
+    header.group_bytes = static_cast<std::uint32_t>(layout.group_bytes);
+    header.slot_bytes = static_cast<std::uint32_t>(layout.slot_bytes);
+    header.key_bytes = static_cast<std::uint32_t>(layout.key_bytes);
+    header.mapped_bytes = static_cast<std::uint32_t>(layout.mapped_bytes);
+    header.slot_capacity = slot_capacity;
+    header.group_capacity = group_capacity;
+    header.groups_offset = sizeof(flat_snapshot_header);
+    header.slots_offset = snapshot_align(header.groups_offset + layout.group_bytes * group_capacity);
+    header.file_size = header.slots_offset + layout.slot_bytes * slot_capacity;
+}
+
+static inline
+bool write_snapshot_padding(std::FILE * fp, std::uint64_t offset) noexcept {
+    static const char s_zeros[kSnapshotAlignment] = { 0 };
+    std::size_t padding = static_cast<std::size_t>(snapshot_align(offset) - offset);
+    return (padding == 0) || (std::fwrite(s_zeros, 1, padding, fp) == padding);
+}
+
+static inline
+bool write_snapshot_file(const char * path, const flat_snapshot_header & header,
+                         const void * groups, const void * slots) noexcept {
+    std::FILE * fp = std::fopen(path, "wb");
+    if (fp == nullptr)
+        return false;
+
+    std::size_t groups_size = static_cast<std::size_t>(header.group_bytes * header.group_capacity);
+    std::size_t slots_size = static_cast<std::size_t>(header.slot_bytes * header.slot_capacity);
+
+    bool ok = (std::fwrite(&header, sizeof(header), 1, fp) == 1);
+    if (ok && (groups_size != 0)) {
+        ok = (std::fwrite(groups, 1, groups_size, fp) == groups_size) &&
+              write_snapshot_padding(fp, header.groups_offset + groups_size);
+    }
+    if (ok && (slots_size != 0)) {
+        ok = (std::fwrite(slots, 1, slots_size, fp) == slots_size);
+    }
+    ok = (std::fclose(fp) == 0) && ok;
+    if (!ok) {
+        std::remove(path);
+    }
+    return ok;
+}
+
+//
+// Returns the header of the mapped snapshot, or nullptr if the file is
+// not a snapshot of the same table layout.
+//
+static inline
+const flat_snapshot_header *
+check_snapshot_header(const jstd::mapped_file & file, const flat_snapshot_layout & layout) noexcept {
+    if (!file.is_open() || (file.size() < sizeof(flat_snapshot_header)))
+        return nullptr;
+
+    const flat_snapshot_header * header = reinterpret_cast<const flat_snapshot_header *>(file.data());
+    if ((std::memcmp(header->magic, layout.magic, sizeof(header->magic)) != 0) ||
+        (header->version != kSnapshotVersion) ||
+        (header->byte_order != kSnapshotByteOrder) ||
+        (header->group_bytes != layout.group_bytes) ||
+        (header->slot_bytes != layout.slot_bytes) ||
+        (header->key_bytes != layout.key_bytes) ||
+        (header->mapped_bytes != layout.mapped_bytes))
+        return nullptr;
+
+    flat_snapshot_header expected;
+    init_snapshot_header(expected, layout, static_cast<std::size_t>(header->group_capacity),
+                         static_cast<std::size_t>(header->slot_capacity));
+    if ((header->groups_offset != expected.groups_offset) ||
+        (header->slots_offset != expected.slots_offset) ||
+        (header->file_size != expected.file_size) ||
+        (header->file_size > file.size()) ||
+        (header->slot_size > header->slot_capacity))
+        return nullptr;
+
+    return header;
+}
+
+} // namespace detail
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_DETAIL_FLAT_SNAPSHOT_H
@@ -22,6 +22,19 @@ using is_emplace_kv_able = std::integral_constant<bool,
     (jstd::is_similar<K, typename Container::key_type>::value ||
      jstd::is_complete_and_move_constructible<typename Container::key_type>::value)>;
 
+//
+// For the sets, init_type is the same as value_type, so the init_type overloads
+// of the tables take this unconstructible type instead, to avoid the redefinition.
+//
+class no_init_type {
+    no_init_type() = delete;
+    int unused_;
+};
+
+template <typename ValueType, typename InitType>
+using init_arg_type = typename std::conditional<std::is_same<ValueType, InitType>::value,
+                                                no_init_type, InitType>::type;
+
 namespace hash_detail {
 
 template <typename IsAvalanching>
@@ -0,0 +1,64 @@
+
+#ifndef JSTD_HASHMAP_DETAIL_PARALLEL_RUN_H
+#define JSTD_HASHMAP_DETAIL_PARALLEL_RUN_H
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <algorithm>    // For std::min()
+
+namespace jstd {
+namespace detail {
+
+//
+// The upper limit of the thread count for the parallel rehash.
+//
+static constexpr std::size_t kMaxRehashThreads = 64;
+
+static inline
+std::size_t clamp_rehash_threads(std::size_t thread_count) noexcept {
+    if (thread_count == 0) {
+        thread_count = static_cast<std::size_t>(std::thread::hardware_concurrency());
+        if (thread_count == 0)
+            thread_count = 1;
+    }
+    return (std::min)(thread_count, kMaxRehashThreads);
+}
+
+//
+// Call func(index) for index in [0, count), the index 0 runs on the calling thread.
+// If a thread can't be created, its index runs on the calling thread too,
+// so every index is always executed exactly once.
+//
+// func() must not throw.
+//
+template <typename Func>
+void parallel_run(std::size_t count, Func && func) {
+    std::vector<std::thread> workers;
+    std::size_t first_inline = count;
+    try {
+        workers.reserve(count);
+        for (std::size_t i = 1; i < count; i++) {
+            workers.emplace_back(func, i);
+        }
+    } catch (...) {
+        first_inline = workers.size() + 1;
+    }
+
+    func(std::size_t(0));
+    for (std::size_t i = first_inline; i < count; i++) {
+        func(i);
+    }
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace detail
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_DETAIL_PARALLEL_RUN_H
@@ -0,0 +1,81 @@
+#ifndef JSTD_HASHMAP_DETAIL_REGION_REHASH_H
+#define JSTD_HASHMAP_DETAIL_REGION_REHASH_H
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>      // For std::swap()
+
+namespace jstd {
+namespace detail {
+
+//
+// The partitioned rehash writes the new arrays one region at a time, a region
+// takes about a half of L2, so its groups and slots stay in the cache while
+// the region is written.
+//
+static constexpr std::size_t kRehashRegionBytes = 1024 * 1024;
+
+//
+// If the home index is taken from the low bits of the hash, the old slots of a
+// group go to (new_capacity / old_capacity) places of the new arrays, which is
+// as good as random from this growth rate on.
+//
+static constexpr std::size_t kMinRegionRehashGrowth = 16;
+
+//
+// The log2 of the slot count of a region, slot_bytes is the size of the new arrays per slot.
+//
+static inline
+std::size_t region_rehash_shift(std::size_t slot_bytes) noexcept {
+    std::size_t shift = 0;
+    while (((std::size_t(2) << shift) * slot_bytes) <= kRehashRegionBytes) {
+        shift++;
+    }
+    return shift;
+}
+
+//
+// Partition the items by region_of(item), which is in [0, region_count),
+// in place (American flag sort), the order in a region isn't kept.
+// Returns false if the counters can't be allocated, the items are untouched then.
+//
+template <typename Item, typename RegionOf>
+bool partition_by_region(std::vector<Item> & items, std::size_t region_count, RegionOf && region_of) {
+    std::vector<std::size_t> heads, tails;
+    try {
+        heads.resize(region_count, 0);
+        tails.resize(region_count, 0);
+    } catch (...) {
+        return false;
+    }
+
+    for (const Item & item : items) {
+        tails[region_of(item)]++;
+    }
+    std::size_t offset = 0;
+    for (std::size_t region = 0; region < region_count; region++) {
+        heads[region] = offset;
+        offset += tails[region];
+        tails[region] = offset;
+    }
+
+    for (std::size_t region = 0; region < region_count; region++) {
+        while (heads[region] < tails[region]) {
+            Item & item = items[heads[region]];
+            std::size_t item_region = region_of(item);
+            if (item_region == region)
+                heads[region]++;
+            else
+                std::swap(item, items[heads[item_region]++]);
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_DETAIL_REGION_REHASH_H
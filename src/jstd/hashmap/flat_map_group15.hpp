@@ -323,10 +323,10 @@ public:
          * 16-byte atomic reads.
          */
         return _mm_set_epi8(
-            (char)ctrls[15], (char)ctrls[14], (char)ctrls[13], (char)ctrls[12],
-            (char)ctrls[11], (char)ctrls[10], (char)ctrls[9],  (char)ctrls[8],
-            (char)ctrls[7],  (char)ctrls[6],  (char)ctrls[5],  (char)ctrls[4],
-            (char)ctrls[3],  (char)ctrls[2],  (char)ctrls[1],  (char)ctrls[0]
+            (char)ctrls[15].value(), (char)ctrls[14].value(), (char)ctrls[13].value(), (char)ctrls[12].value(),
+            (char)ctrls[11].value(), (char)ctrls[10].value(), (char)ctrls[9].value(),  (char)ctrls[8].value(),
+            (char)ctrls[7].value(),  (char)ctrls[6].value(),  (char)ctrls[5].value(),  (char)ctrls[4].value(),
+            (char)ctrls[3].value(),  (char)ctrls[2].value(),  (char)ctrls[1].value(),  (char)ctrls[0].value()
         );
 #else
         return _mm_load_si128(reinterpret_cast<const __m128i *>(ctrls));
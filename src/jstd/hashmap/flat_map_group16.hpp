@@ -387,6 +387,17 @@ public:
         ctrl.set_overflow();
     }
 
+    inline void clear_overflow() {
+        __m128i ctrl_bits = load_metadata();
+        _mm_store_si128(reinterpret_cast<__m128i *>(ctrls), _mm_and_si128(ctrl_bits, make_mask_bits()));
+    }
+
+    // The overflow bit is the sign bit of each ctrl byte.
+    inline std::uint32_t match_overflow() const {
+        __m128i ctrl_bits = load_metadata();
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_bits));
+    }
+
     static inline
     __m128i make_mask_bits() noexcept {
 #if 1
@@ -305,14 +305,14 @@ public:
          * 32-byte atomic reads.
          */
         return _mm256_set_epi8(
-            (char)ctrls[31], (char)ctrls[30], (char)ctrls[29], (char)ctrls[28],
-            (char)ctrls[27], (char)ctrls[26], (char)ctrls[25], (char)ctrls[24],
-            (char)ctrls[23], (char)ctrls[22], (char)ctrls[21], (char)ctrls[20],
-            (char)ctrls[19], (char)ctrls[18], (char)ctrls[17], (char)ctrls[16]
-            (char)ctrls[15], (char)ctrls[14], (char)ctrls[13], (char)ctrls[12],
-            (char)ctrls[11], (char)ctrls[10], (char)ctrls[9],  (char)ctrls[8],
-            (char)ctrls[7],  (char)ctrls[6],  (char)ctrls[5],  (char)ctrls[4],
-            (char)ctrls[3],  (char)ctrls[2],  (char)ctrls[1],  (char)ctrls[0]
+            (char)ctrls[31].value(), (char)ctrls[30].value(), (char)ctrls[29].value(), (char)ctrls[28].value(),
+            (char)ctrls[27].value(), (char)ctrls[26].value(), (char)ctrls[25].value(), (char)ctrls[24].value(),
+            (char)ctrls[23].value(), (char)ctrls[22].value(), (char)ctrls[21].value(), (char)ctrls[20].value(),
+            (char)ctrls[19].value(), (char)ctrls[18].value(), (char)ctrls[17].value(), (char)ctrls[16].value(),
+            (char)ctrls[15].value(), (char)ctrls[14].value(), (char)ctrls[13].value(), (char)ctrls[12].value(),
+            (char)ctrls[11].value(), (char)ctrls[10].value(), (char)ctrls[9].value(),  (char)ctrls[8].value(),
+            (char)ctrls[7].value(),  (char)ctrls[6].value(),  (char)ctrls[5].value(),  (char)ctrls[4].value(),
+            (char)ctrls[3].value(),  (char)ctrls[2].value(),  (char)ctrls[1].value(),  (char)ctrls[0].value()
         );
 #else
         return _mm256_load_si256(reinterpret_cast<const __m256i *>(ctrls));
@@ -504,7 +504,7 @@ private:
     }
 
     inline const mask_type & overflow_masks() const {
-        ctrl_type * mask_ctrl = &ctrls[kGroupSize];
+        const ctrl_type * mask_ctrl = &ctrls[kGroupSize];
         return *reinterpret_cast<const mask_type *>(mask_ctrl);
     }
 
@@ -85,6 +85,7 @@ public:
     using hashmap_type = HashMap;
     using ctrl_type = typename HashMap::ctrl_type;
     using slot_type = typename HashMap::slot_type;
+    using slot_policy = typename HashMap::slot_policy_t;
     using size_type = typename HashMap::size_type;
     using ssize_type = typename HashMap::ssize_type;
     using difference_type = typename HashMap::difference_type;
@@ -152,6 +153,12 @@ public:
         return *this;
 #else
         ssize_type index = this->index_;
+        if (JSTD_UNLIKELY((HashMap::kIncrementalRehash && (index < 0)) || this->hashmap_->has_stale_groups())) {
+            // It's in the old arrays of the migrating table, or the stale groups of
+            // generation clear are skipped as empty, they are not reset here.
+            this->index_ = this->hashmap_->next_used_index(index);
+            return *this;
+        }
         const ctrl_type * ctrl = this->hashmap_->ctrl_at(index);
         ssize_type max_index = static_cast<ssize_type>(this->hashmap_->slot_capacity());
 
@@ -177,6 +184,10 @@ public:
     JSTD_FORCED_INLINE
     flat_map_iterator & operator -- () {
         ssize_type index = this->index_;
+        if (JSTD_UNLIKELY(this->hashmap_->is_migrating() || this->hashmap_->has_stale_groups())) {
+            this->index_ = this->hashmap_->prev_used_index(index);
+            return *this;
+        }
         const ctrl_type * ctrl = this->hashmap_->ctrl_at(index);
 
         while (index > 0) {
@@ -199,26 +210,26 @@ public:
 
     inline reference operator * () {
         slot_type * _slot = this->slot();
-        return _slot->value;
+        return slot_policy::element(_slot);
     }
 
     inline const_reference operator * () const {
         const slot_type * _slot = this->slot();
-        return _slot->value;
+        return slot_policy::element(const_cast<slot_type *>(_slot));
     }
 
     inline pointer operator -> () {
         slot_type * _slot = this->slot();
-        return std::addressof(_slot->value);
+        return std::addressof(slot_policy::element(_slot));
     }
 
     inline const_pointer operator -> () const {
         const slot_type * _slot = this->slot();
-        return std::addressof(_slot->value);
+        return std::addressof(slot_policy::element(const_cast<slot_type *>(_slot)));
     }
 
     inline hashmap_type * hashmap() noexcept {
-        return this->hashmap_;
+        return const_cast<hashmap_type *>(this->hashmap_);
     }
 
     inline const hashmap_type * hashmap() const noexcept {
@@ -230,23 +241,25 @@ public:
     }
 
     inline ctrl_type * ctrl() noexcept {
-        const ctrl_type * _ctrl = this->hashmap_->ctrl_at(this->index_);
-        return const_cast<slot_type *>(_ctrl);
+        return const_cast<ctrl_type *>(const_cast<const flat_map_iterator *>(this)->ctrl());
     }
 
     inline const ctrl_type * ctrl() const noexcept {
-        const ctrl_type * _ctrl = this->hashmap_->ctrl_at(this->index_);
-        return _ctrl;
+        if (JSTD_LIKELY(!HashMap::kIncrementalRehash || (this->index_ >= 0)))
+            return this->hashmap_->ctrl_at(static_cast<size_type>(this->index_));
+        else
+            return this->hashmap_->old_ctrl_at(this->index_);
     }
 
     inline slot_type * slot() noexcept {
-        const slot_type * _slot = this->hashmap_->slot_at(this->index_);
-        return const_cast<slot_type *>(_slot);
+        return const_cast<slot_type *>(const_cast<const flat_map_iterator *>(this)->slot());
     }
 
     inline const slot_type * slot() const noexcept {
-        const slot_type * _slot = this->hashmap_->slot_at(this->index_);
-        return _slot;
+        if (JSTD_LIKELY(!HashMap::kIncrementalRehash || (this->index_ >= 0)))
+            return this->hashmap_->slot_at(static_cast<size_type>(this->index_));
+        else
+            return this->hashmap_->old_slot_at(this->index_);
     }
 };
 
@@ -273,6 +286,7 @@ public:
     using hashmap_type = HashMap;
     using ctrl_type = typename HashMap::ctrl_type;
     using slot_type = typename HashMap::slot_type;
+    using slot_policy = typename HashMap::slot_policy_t;
     using size_type = typename HashMap::size_type;
     using ssize_type = typename HashMap::ssize_type;
     using difference_type = typename HashMap::difference_type;
@@ -351,19 +365,19 @@ public:
     }
 
     inline reference operator * () {
-        return const_cast<slot_type *>(this->slot_)->value;
+        return slot_policy::element(const_cast<slot_type *>(this->slot_));
     }
 
     inline const_reference operator * () const {
-        return const_cast<slot_type *>(this->slot_)->value;
+        return slot_policy::element(const_cast<slot_type *>(this->slot_));
     }
 
     inline pointer operator -> () {
-        return std::addressof(const_cast<slot_type *>(this->slot_)->value);
+        return std::addressof(slot_policy::element(const_cast<slot_type *>(this->slot_)));
     }
 
     inline const_pointer operator -> () const {
-        return std::addressof(const_cast<slot_type *>(this->slot_)->value);
+        return std::addressof(slot_policy::element(const_cast<slot_type *>(this->slot_)));
     }
 
     inline hashmap_type * hashmap() noexcept {
@@ -72,6 +72,7 @@ public:
     using ctrl_type = typename HashMap::ctrl_type;
     using group_type = typename HashMap::group_type;
     using slot_type = typename HashMap::slot_type;
+    using slot_policy = typename HashMap::slot_policy_t;
     using size_type = typename HashMap::size_type;
     using ssize_type = typename HashMap::ssize_type;
     using difference_type = typename HashMap::difference_type;
@@ -249,6 +250,7 @@ public:
     using ctrl_type = typename HashMap::ctrl_type;
     using group_type = typename HashMap::group_type;
     using slot_type = typename HashMap::slot_type;
+    using slot_policy = typename HashMap::slot_policy_t;
     using locator_t = typename HashMap::locator_t;
     using size_type = typename HashMap::size_type;
     using ssize_type = typename HashMap::ssize_type;
@@ -339,22 +341,22 @@ public:
 
     inline reference operator * () {
         slot_type * _slot = this->slot();
-        return _slot->value;
+        return slot_policy::element(_slot);
     }
 
     inline const_reference operator * () const {
         const slot_type * _slot = this->slot();
-        return _slot->value;
+        return slot_policy::element(const_cast<slot_type *>(_slot));
     }
 
     inline pointer operator -> () {
         slot_type * _slot = this->slot();
-        return std::addressof(_slot->value);
+        return std::addressof(slot_policy::element(_slot));
     }
 
     inline const_pointer operator -> () const {
         const slot_type * _slot = this->slot();
-        return std::addressof(_slot->value);
+        return std::addressof(slot_policy::element(const_cast<slot_type *>(_slot)));
     }
 
     inline locator_t & locator() noexcept {
@@ -422,6 +424,7 @@ public:
     using ctrl_type = typename HashMap::ctrl_type;
     using group_type = typename HashMap::group_type;
     using slot_type = typename HashMap::slot_type;
+    using slot_policy = typename HashMap::slot_policy_t;
     using locator_t = typename HashMap::locator_t;
     using size_type = typename HashMap::size_type;
     using ssize_type = typename HashMap::ssize_type;
@@ -515,22 +518,22 @@ public:
 
     inline reference operator * () {
         slot_type * _slot = this->slot();
-        return _slot->value;
+        return slot_policy::element(_slot);
     }
 
     inline const_reference operator * () const {
         const slot_type * _slot = this->slot();
-        return _slot->value;
+        return slot_policy::element(const_cast<slot_type *>(_slot));
     }
 
     inline pointer operator -> () {
         slot_type * _slot = this->slot();
-        return std::addressof(_slot->value);
+        return std::addressof(slot_policy::element(_slot));
     }
 
     inline const_pointer operator -> () const {
         const slot_type * _slot = this->slot();
-        return std::addressof(_slot->value);
+        return std::addressof(slot_policy::element(const_cast<slot_type *>(_slot)));
     }
 
     inline ctrl_type * ctrl() noexcept { return const_cast<ctrl_type *>(this->ctrl_); }
@@ -653,6 +656,7 @@ public:
     using ctrl_type = typename HashMap::ctrl_type;
     using group_type = typename HashMap::group_type;
     using slot_type = typename HashMap::slot_type;
+    using slot_policy = typename HashMap::slot_policy_t;
     using locator_t = typename HashMap::locator_t;
     using size_type = typename HashMap::size_type;
     using ssize_type = typename HashMap::ssize_type;
@@ -732,19 +736,19 @@ public:
     }
 
     inline reference operator * () {
-        return const_cast<slot_type *>(this->slot_)->value;
+        return slot_policy::element(const_cast<slot_type *>(this->slot_));
     }
 
     inline const_reference operator * () const {
-        return const_cast<slot_type *>(this->slot_)->value;
+        return slot_policy::element(const_cast<slot_type *>(this->slot_));
     }
 
     inline pointer operator -> () {
-        return std::addressof(const_cast<slot_type *>(this->slot_)->value);
+        return std::addressof(slot_policy::element(const_cast<slot_type *>(this->slot_)));
     }
 
     inline const_pointer operator -> () const {
-        return std::addressof(const_cast<slot_type *>(this->slot_)->value);
+        return std::addressof(slot_policy::element(const_cast<slot_type *>(this->slot_)));
     }
 
     inline group_type * group() noexcept { return nullptr; }
@@ -57,6 +57,8 @@
 #include "jstd/basic/stddef.h"
 #include "jstd/traits/type_traits.h"
 #include "jstd/hashmap/map_types_constructibility.hpp"
+#include "jstd/hashmap/map_slot_policy.h"
+#include "jstd/hashmap/flat_map_slot_policy.hpp"
 
 namespace jstd {
 
@@ -75,6 +77,9 @@ public:
 
     typedef value_type                                      element_type;
 
+    typedef map_slot_type<raw_key_type, raw_mapped_type>    slot_type;
+    typedef flat_map_slot_policy<slot_type>                 slot_policy;
+
     typedef flat_map_type_policy<Key, Value>                this_type;
 
     using constructibility_checker = flat_map_types_constructibility<this_type>;
@@ -83,8 +88,22 @@ public:
         return x;
     }
 
-    template <typename K, typename V>
-    static const raw_key_type & extract(const std::pair<K, V> & kv) {
+    static const raw_key_type & extract(const init_type & kv) {
+        return kv.first;
+    }
+
+    static const raw_key_type & extract(const value_type & kv) {
+        return kv.first;
+    }
+
+    //
+    // If K isn't the key_type, return the first as it is, don't convert it into
+    // a temporary key_type here, the reference to it would dangle. The callers
+    // take it as a heterogeneous key.
+    //
+    template <typename K, typename V, typename std::enable_if<
+              !std::is_same<typename std::remove_cv<K>::type, raw_key_type>::value>::type * = nullptr>
+    static const K & extract(const std::pair<K, V> & kv) {
         return kv.first;
     }
 
@@ -0,0 +1,110 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2024-2025 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+*************************************************************************************
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+  You are free to:
+
+    1. Share -- copy and redistribute the material in any medium or format.
+
+    2. Adapt -- remix, transforn, and build upon the material for any purpose,
+    even commerically.
+
+    The licensor cannot revoke these freedoms as long as you follow the license terms.
+
+  Under the following terms:
+
+    * Attribution -- You must give appropriate credit, provide a link to the license,
+    and indicate if changes were made. You may do so in any reasonable manner,
+    but not in any way that suggests the licensor endorses you or your use.
+
+    * ShareAlike -- If you remix, transform, or build upon the material, you must
+    distribute your contributions under the same license as the original.
+
+    * No additional restrictions -- You may not apply legal terms or technological
+    measures that legally restrict others from doing anything the license permits.
+
+  Notices:
+
+    * You do not have to comply with the license for elements of the material
+    in the public domain or where your use is permitted by an applicable exception
+    or limitation.
+
+    * No warranties are given. The license may not give you all of the permissions
+    necessary for your intended use. For example, other rights such as publicity,
+    privacy, or moral rights may limit how you use the material.
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_FLAT_SET_TYPE_POLICY_HPP
+#define JSTD_HASHMAP_FLAT_SET_TYPE_POLICY_HPP
+
+#pragma once
+
+#include <memory>           // For std::allocator_traits<T>
+#include <type_traits>
+#include <utility>          // For std::move()
+
+#include "jstd/basic/stddef.h"
+#include "jstd/traits/type_traits.h"
+#include "jstd/hashmap/set_slot_policy.h"
+
+namespace jstd {
+
+template <typename Key>
+class JSTD_DLL flat_set_type_policy
+{
+public:
+    typedef Key                                             key_type;
+    typedef typename std::remove_const<Key>::type           raw_key_type;
+    // The sets have no mapped value, it's only used by the traits of the tables.
+    typedef raw_key_type                                    mapped_type;
+    typedef raw_key_type                                    raw_mapped_type;
+
+    typedef raw_key_type                                    init_type;
+    typedef raw_key_type &&                                 moved_type;
+    typedef raw_key_type                                    value_type;
+
+    typedef value_type                                      element_type;
+
+    typedef set_slot_type<raw_key_type>                     slot_type;
+    typedef set_slot_policy<slot_type>                      slot_policy;
+
+    typedef flat_set_type_policy<Key>                       this_type;
+
+    static value_type & value_from(element_type & x) {
+        return x;
+    }
+
+    static const raw_key_type & extract(const value_type & key) {
+        return key;
+    }
+
+    static moved_type move(value_type & x) {
+        return std::move(x);
+    }
+
+    template <typename Allocator, typename ... Args>
+    static void construct(Allocator & al, value_type * p, Args &&... args) {
+        std::allocator_traits<jstd::remove_cvref_t<decltype(al)>>::construct(al, p, std::forward<Args>(args)...);
+    }
+
+    template <typename Allocator>
+    static void destroy(Allocator & al, value_type * p) noexcept {
+        std::allocator_traits<jstd::remove_cvref_t<decltype(al)>>::destroy(al, p);
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_FLAT_SET_TYPE_POLICY_HPP
@@ -0,0 +1,93 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2024-2025 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+*************************************************************************************
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+  You are free to:
+
+    1. Share -- copy and redistribute the material in any medium or format.
+
+    2. Adapt -- remix, transforn, and build upon the material for any purpose,
+    even commerically.
+
+    The licensor cannot revoke these freedoms as long as you follow the license terms.
+
+  Under the following terms:
+
+    * Attribution -- You must give appropriate credit, provide a link to the license,
+    and indicate if changes were made. You may do so in any reasonable manner,
+    but not in any way that suggests the licensor endorses you or your use.
+
+    * ShareAlike -- If you remix, transform, or build upon the material, you must
+    distribute your contributions under the same license as the original.
+
+    * No additional restrictions -- You may not apply legal terms or technological
+    measures that legally restrict others from doing anything the license permits.
+
+  Notices:
+
+    * You do not have to comply with the license for elements of the material
+    in the public domain or where your use is permitted by an applicable exception
+    or limitation.
+
+    * No warranties are given. The license may not give you all of the permissions
+    necessary for your intended use. For example, other rights such as publicity,
+    privacy, or moral rights may limit how you use the material.
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_FLAT_TABLE_POLICY_HPP
+#define JSTD_HASHMAP_FLAT_TABLE_POLICY_HPP
+
+#pragma once
+
+#include "jstd/basic/stddef.h"
+
+namespace jstd {
+
+//
+// TablePolicy decides which of the optional runtime modes a group table is built with,
+// a disabled mode has no member in the table and no branch in the hot paths, so the
+// default policy compiles to the plain table.
+//
+//   IncrementalRehash: a grow migrates the old groups a few at a time, see start_migration().
+//   GenerationClear:   clear() only bumps the generation of the groups, see clear_generation().
+//   Snapshot:          open_mapped() serves the table from a saved file, see save().
+//   ReleasePages:      clear(true) and the shrinks keep a big slot array, and return it's pages
+//                      to the OS, see jstd::detail::released_array.
+//   SparseClear:       clear() only resets the groups written since the last clear(),
+//                      see group15_flat_table::sparse_clear().
+//
+template <bool IncrementalRehash = false, bool GenerationClear = false, bool Snapshot = false,
+          bool ReleasePages = false, bool SparseClear = false>
+struct JSTD_DLL flat_table_policy
+{
+    static constexpr bool incremental_rehash = IncrementalRehash;
+    static constexpr bool generation_clear = GenerationClear;
+    static constexpr bool snapshot = Snapshot;
+    static constexpr bool release_pages = ReleasePages;
+    static constexpr bool sparse_clear = SparseClear;
+};
+
+namespace detail {
+
+//
+// The state of a disabled mode, the states of the enabled modes derive from it
+// one by one, so all the disabled modes take no room (the empty base optimization).
+//
+struct empty_table_state {};
+
+} // namespace detail
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_FLAT_TABLE_POLICY_HPP
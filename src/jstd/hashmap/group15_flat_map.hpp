@@ -61,29 +61,41 @@
 #include <initializer_list>
 #include <type_traits>
 #include <utility>              // For std::pair<F, S>
+#include <string>
 #include <exception>
 #include <stdexcept>
 
 #include "jstd/basic/stddef.h"
 #include "jstd/hashmap/detail/hashmap_traits.h"
 #include "jstd/hashmap/flat_map_type_policy.hpp"
+#include "jstd/hashmap/flat_table_policy.hpp"
 #include "jstd/hashmap/group15_flat_table.hpp"
 
 namespace jstd {
 
 template <typename TypePolicy, typename Hash,
-          typename KeyEqual, typename Allocator>
+          typename KeyEqual, typename Allocator,
+          typename TablePolicy>
 class group15_flat_table;
 
+//
+// TypePolicy decides how the elements are stored in the slots: flat_map_type_policy
+// stores them in place, node_map_type_policy stores the pointers of the nodes,
+// see group15_node_map. TablePolicy enables the optional modes of the table,
+// see jstd::flat_table_policy.
+//
 template <typename Key, typename Value,
           typename Hash = std::hash< typename std::remove_const<Key>::type >,
           typename KeyEqual = std::equal_to< typename std::remove_const<Key>::type >,
           typename Allocator = std::allocator< std::pair<const typename std::remove_const<Key>::type,
-                                                         typename std::remove_const<Value>::type> > >
+                                                         typename std::remove_const<Value>::type> >,
+          typename TypePolicy = jstd::flat_map_type_policy<Key, Value>,
+          typename TablePolicy = jstd::flat_table_policy<> >
 class JSTD_DLL group15_flat_map
 {
 public:
-    typedef jstd::flat_map_type_policy<Key, Value>  type_policy;
+    typedef TypePolicy                              type_policy;
+    typedef TablePolicy                             table_policy;
     typedef std::size_t                             size_type;
     typedef std::intptr_t                           ssize_type;
     typedef std::ptrdiff_t                          difference_type;
@@ -104,7 +116,7 @@ public:
     typedef typename std::allocator_traits<allocator_type>::const_pointer   const_pointer;
 
     typedef jstd::group15_flat_table<type_policy, Hash, KeyEqual,
-        typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>>
+        typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>, table_policy>
                                                 table_type;
 
     typedef typename table_type::ctrl_type      ctrl_type;
@@ -113,7 +125,7 @@ public:
     typedef typename table_type::iterator       iterator;
     typedef typename table_type::const_iterator const_iterator;
 
-    using this_type = jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Allocator>;
+    using this_type = jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Allocator, TypePolicy, TablePolicy>;
 
 private:
     table_type table_;
@@ -308,10 +320,41 @@ public:
         table_.rehash(new_capacity);
     }
 
+    // Reinsert the old elements by thread_count threads, 0 is hardware_concurrency().
+    void reserve(size_type new_capacity, size_type thread_count) {
+        table_.reserve(new_capacity, thread_count);
+    }
+
+    void rehash(size_type new_capacity, size_type thread_count) {
+        table_.rehash(new_capacity, thread_count);
+    }
+
     void shrink_to_fit(bool read_only = false) {
         table_.shrink_to_fit(read_only);
     }
 
+    ///
+    /// Sparse clear
+    ///
+    static constexpr bool sparse_clear() noexcept {
+        return table_type::sparse_clear();
+    }
+
+    ///
+    /// Snapshot
+    ///
+    bool save(const char * path) const {
+        return table_.save(path);
+    }
+
+    bool open_mapped(const char * path) {
+        return table_.open_mapped(path);
+    }
+
+    bool is_mapped() const noexcept {
+        return table_.is_mapped();
+    }
+
     ///
     /// Lookup
     ///
@@ -332,7 +375,7 @@ public:
         // TODO: someday refactor this to conditionally serialize the key and
         // include it in the error message
         //
-        throw std::out_of_range("key was not found in jstd::group15_flat_map");
+        throw std::out_of_range(std::string("key was not found in ") + this_type::name());
     }
 
     const mapped_type & at(const key_type & key) const {
@@ -341,7 +384,7 @@ public:
             return pos->second;
         }
 
-        throw std::out_of_range("key was not found in jstd::group15_flat_map");
+        throw std::out_of_range(std::string("key was not found in ") + this_type::name());
     }
 
     JSTD_FORCED_INLINE
@@ -458,7 +501,7 @@ public:
     JSTD_FORCED_INLINE
     void insert(InputIter first, InputIter last) {
         for (InputIter pos = first; pos != last; ++pos) {
-            table_.emplace(*first);
+            table_.emplace(*pos);
         }
     }
 
@@ -466,19 +509,24 @@ public:
         this->insert(ilist.begin(), ilist.end());
     }
 
+    template <typename InputIter>
+    void build_from(InputIter first, InputIter last, size_type thread_count = 0) {
+        table_.build_from(first, last, thread_count);
+    }
+
     ///
     /// insert_or_assign(key, value)
     ///
     template <typename MappedT>
     JSTD_FORCED_INLINE
     std::pair<iterator, bool> insert_or_assign(const key_type & key, MappedT && value) {
-        return table_.template emplace_impl<true>(key, std::forward<MappedT>(value));
+        return table_.insert_or_assign(key, std::forward<MappedT>(value));
     }
 
     template <typename MappedT>
     JSTD_FORCED_INLINE
     std::pair<iterator, bool> insert_or_assign(key_type && key, MappedT && value) {
-        return table_.template emplace_impl<true>(std::move(key), std::forward<MappedT>(value));
+        return table_.insert_or_assign(std::move(key), std::forward<MappedT>(value));
     }
 
     template <typename KeyT, typename MappedT, typename std::enable_if<
@@ -488,19 +536,19 @@ public:
               !std::is_convertible<KeyT, const_iterator>::value>::type * = nullptr>
     JSTD_FORCED_INLINE
     std::pair<iterator, bool> insert_or_assign(KeyT && key, MappedT && value) {
-        return table_.template emplace_impl<true>(std::move(key), std::forward<MappedT>(value));
+        return table_.insert_or_assign(std::move(key), std::forward<MappedT>(value));
     }
 
     template <typename MappedT>
     JSTD_FORCED_INLINE
     iterator insert_or_assign(const_iterator hint, const key_type & key, MappedT && value) {
-        return table_.template emplace_impl<true>(key, std::forward<MappedT>(value))->first;
+        return table_.insert_or_assign(key, std::forward<MappedT>(value)).first;
     }
 
     template <typename MappedT>
     JSTD_FORCED_INLINE
     iterator insert_or_assign(const_iterator hint, key_type && key, MappedT && value) {
-        return table_.template emplace_impl<true>(std::move(key), std::forward<MappedT>(value))->first;
+        return table_.insert_or_assign(std::move(key), std::forward<MappedT>(value)).first;
     }
 
     template <typename KeyT, typename MappedT, typename std::enable_if<
@@ -510,7 +558,7 @@ public:
               !std::is_convertible<KeyT, const_iterator>::value>::type * = nullptr>
     JSTD_FORCED_INLINE
     iterator insert_or_assign(const_iterator hint, KeyT && key, MappedT && value) {
-        return table_.template emplace_impl<true>(std::move(key), std::forward<MappedT>(value))->first;
+        return table_.insert_or_assign(std::move(key), std::forward<MappedT>(value)).first;
     }
 
     ///
@@ -609,6 +657,22 @@ public:
         return table_.try_emplace(hint, std::forward<KeyT>(key), std::forward<Args>(args)...);
     }
 
+    ///
+    /// insert_batch(values, count)
+    ///
+    template <typename ValueT>
+    size_type insert_batch(const ValueT * values, size_type count) {
+        return table_.insert_batch(values, count);
+    }
+
+    ///
+    /// try_emplace_batch(keys, values, count)
+    ///
+    template <typename KeyT, typename MappedT>
+    size_type try_emplace_batch(const KeyT * keys, const MappedT * values, size_type count) {
+        return table_.try_emplace_batch(keys, values, count);
+    }
+
     ///
     /// erase(key)
     ///
@@ -618,12 +682,12 @@ public:
     }
 
     JSTD_FORCED_INLINE
-    size_type erase(iterator pos) {
+    iterator erase(iterator pos) {
         return table_.erase(pos);
     }
 
     JSTD_FORCED_INLINE
-    size_type erase(const_iterator pos) {
+    iterator erase(const_iterator pos) {
         return table_.erase(pos);
     }
 
@@ -682,10 +746,11 @@ public:
  * @param lhs the map on the right side to swap
  */
 
-template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Alloc>
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Alloc,
+          typename TypePolicy, typename TablePolicy>
 inline
-void swap(group15_flat_map<Key, Value, Hash, KeyEqual, Alloc> & lhs,
-          group15_flat_map<Key, Value, Hash, KeyEqual, Alloc> & rhs)
+void swap(group15_flat_map<Key, Value, Hash, KeyEqual, Alloc, TypePolicy, TablePolicy> & lhs,
+          group15_flat_map<Key, Value, Hash, KeyEqual, Alloc, TypePolicy, TablePolicy> & rhs)
           noexcept(noexcept(lhs.swap(rhs)))
 {
     lhs.swap(rhs);
@@ -706,19 +771,21 @@ namespace std {
  * @param lhs the map on the right side to swap
  */
 
-template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Alloc>
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Alloc,
+          typename TypePolicy, typename TablePolicy>
 inline
-void swap(jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Alloc> & lhs,
-          jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Alloc> & rhs)
+void swap(jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Alloc, TypePolicy, TablePolicy> & lhs,
+          jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Alloc, TypePolicy, TablePolicy> & rhs)
           noexcept(noexcept(lhs.swap(rhs)))
 {
     lhs.swap(rhs);
 }
 
-template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Alloc, typename Pred>
-typename jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Alloc>::size_type
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Alloc,
+          typename TypePolicy, typename TablePolicy, typename Pred>
+typename jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Alloc, TypePolicy, TablePolicy>::size_type
 inline
-erase_if(jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Alloc> & hash_map, Pred pred)
+erase_if(jstd::group15_flat_map<Key, Value, Hash, KeyEqual, Alloc, TypePolicy, TablePolicy> & hash_map, Pred pred)
 {
     auto old_size = hash_map.size();
 
@@ -63,6 +63,9 @@
 #include <type_traits>
 #include <algorithm>        // For std::max()
 #include <utility>          // For std::pair<F, S>
+#include <iterator>         // For std::iterator_traits<T>
+#include <vector>
+#include <exception>        // For std::exception_ptr
 
 #include <assert.h>
 
@@ -75,14 +78,18 @@
 #include "jstd/traits/type_traits.h"    // For jstd::narrow_cast<T>()
 #include "jstd/hasher/hashes.h"
 #include "jstd/utility/utility.h"
+#include "jstd/memory/released_array.h"
 
 #include "jstd/hashmap/flat_map_iterator15.hpp"
 #include "jstd/hashmap/flat_map_group15.hpp"
 #include "jstd/hashmap/group_quadratic_prober.hpp"
 
 #include "jstd/hashmap/detail/hashmap_traits.h"
+#include "jstd/hashmap/detail/parallel_run.h"
+#include "jstd/hashmap/detail/flat_snapshot.h"
 
 #include "jstd/hashmap/flat_map_type_policy.hpp"
+#include "jstd/hashmap/flat_table_policy.hpp"
 #include "jstd/hashmap/flat_map_slot_policy.hpp"
 #include "jstd/hashmap/slot_policy_traits.h"
 
@@ -100,12 +107,22 @@
 
 namespace jstd {
 
-template <typename TypePolicy, typename Hash,
+template <typename Key, typename Value, typename Hash,
           typename KeyEqual, typename Allocator>
+class concurrent_group15_flat_map;
+
+template <typename TypePolicy, typename Hash,
+          typename KeyEqual, typename Allocator,
+          typename TablePolicy = jstd::flat_table_policy<>>
 class JSTD_DLL group15_flat_table
 {
+    // The concurrent map drives the probing itself with it's group-level locks.
+    template <typename K, typename V, typename H, typename E, typename A>
+    friend class concurrent_group15_flat_map;
+
 public:
     typedef TypePolicy                          type_policy;
+    typedef TablePolicy                         table_policy;
     typedef std::size_t                         size_type;
     typedef std::intptr_t                       ssize_type;
     typedef std::ptrdiff_t                      difference_type;
@@ -124,10 +141,13 @@ public:
     typedef value_type &                        reference;
     typedef value_type const &                  const_reference;
 
+    // For the sets, init_type is the same as value_type.
+    typedef jstd::detail::init_arg_type<value_type, init_type>  init_arg_type;
+
     typedef typename std::allocator_traits<allocator_type>::pointer         pointer;
     typedef typename std::allocator_traits<allocator_type>::const_pointer   const_pointer;
 
-    using this_type = jstd::group15_flat_table<TypePolicy, Hash, KeyEqual, Allocator>;
+    using this_type = jstd::group15_flat_table<TypePolicy, Hash, KeyEqual, Allocator, TablePolicy>;
 
     static constexpr bool kUseIndexSalt = false;
     static constexpr bool kEnableExchange = true;
@@ -165,19 +185,37 @@ public:
     static constexpr bool kIsMoveAssignKey    = std::is_move_assignable<key_type>::value;
     static constexpr bool kIsMoveAssignMapped = std::is_move_assignable<mapped_type>::value;
 
-    static constexpr bool is_slot_trivial_copyable =
+    // The slots only hold the pointers of the nodes, see node_map_slot_policy.
+    static constexpr bool kIsNodeBased =
+            jstd::slot_policy_traits<typename type_policy::slot_policy>::node_based::value;
+
+    static constexpr bool is_slot_trivial_copyable = !kIsNodeBased &&
             (std::is_trivially_copyable<value_type>::value ||
             (std::is_trivially_copyable<key_type>::value &&
              std::is_trivially_copyable<mapped_type>::value) ||
             (std::is_scalar<key_type>::value && std::is_scalar<mapped_type>::value));
 
-    static constexpr bool is_slot_trivial_destructor =
+    static constexpr bool is_slot_trivial_destructor = !kIsNodeBased &&
             (std::is_trivially_destructible<value_type>::value ||
             (std::is_trivially_destructible<key_type>::value &&
              std::is_trivially_destructible<mapped_type>::value) ||
             (jstd::is_plain_type<key_type>::value &&
              jstd::is_plain_type<mapped_type>::value));
 
+    // The slots can be moved to the new place by memcpy, and the old ones are not destroyed.
+    static constexpr bool kIsRelocatableSlot = !kIsNodeBased &&
+            (std::is_trivially_copy_constructible<element_type>::value ||
+             jstd::is_trivially_relocatable<element_type>::value) &&
+            (jstd::is_std_allocator<Allocator>::value ||
+            !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value);
+
+    // The slots are transferred without any exception, the parallel rehash relies on it.
+    static constexpr bool kIsNothrowTransfer = kIsRelocatableSlot || kIsNodeBased ||
+            (std::is_nothrow_move_constructible<typename std::conditional<kIsLayoutCompatible,
+                                                std::pair<key_type, mapped_type>, value_type>::type>::value &&
+            (jstd::is_std_allocator<Allocator>::value ||
+            !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value));
+
     static constexpr size_type kWordLength = sizeof(std::size_t) * CHAR_BIT;
     static constexpr size_type kSizeTypeLength = sizeof(std::size_t);
 
@@ -199,8 +237,8 @@ public:
     static constexpr bool kIsIndirectKV = kIsIndirectKey | kIsIndirectValue;
     static constexpr bool kNeedStoreHash = true;
 
-    using slot_type = jstd::map_slot_type<key_type, mapped_type>;
-    using slot_policy_t = jstd::flat_map_slot_policy<slot_type>;
+    using slot_type = typename type_policy::slot_type;
+    using slot_policy_t = typename type_policy::slot_policy;
     using SlotPolicyTraits = jstd::slot_policy_traits<slot_policy_t>;
 
     static constexpr size_type kCacheLineSize = 64;
@@ -236,6 +274,18 @@ public:
 
     static constexpr size_type kSkipGroupsLimit = 5;
 
+    // The number of keys hashed and prefetched ahead in insert_batch().
+    static constexpr size_type kBatchPrefetchSize = 16;
+
+    // The parallel rehash is only used when the old table has at least so many elements.
+    static constexpr size_type kMinParallelRehashSize = 65536;
+    // The dirty bits are indexed by the group index, the indirect slots are not.
+    static constexpr bool kSupportSparseClear = !kIsIndirectKV;
+    static constexpr bool kSparseClear = kSupportSparseClear && table_policy::sparse_clear;
+    // save() writes any table, but only open_mapped() needs the member of the mapped file.
+    static constexpr bool kSnapshot = table_policy::snapshot;
+    static constexpr bool kReleasePages = table_policy::release_pages;
+
     using group_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<group_type>;
     using slot_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<slot_type>;
 
@@ -246,6 +296,43 @@ public:
 
     using hash_policy_t = typename jstd::hash_policy_selector<Hash>::type;
 
+    //
+    // The members of the modes enabled by TablePolicy, see jstd::flat_table_policy.
+    // The snapshot file which the arrays are mapped from, see open_mapped().
+    //
+    struct snapshot_state : public jstd::detail::empty_table_state {
+        jstd::mapped_file   mapped_;
+    };
+
+    using snapshot_state_t = typename std::conditional<kSnapshot, snapshot_state,
+                                                       jstd::detail::empty_table_state>::type;
+
+    //
+    // The slot array given up by clear(true) or a shrink, see jstd::detail::released_array.
+    //
+    struct release_pages_state : public snapshot_state_t {
+        jstd::detail::released_array<slot_type> released_slots_;
+    };
+
+    using release_pages_state_t = typename std::conditional<kReleasePages, release_pages_state,
+                                                            snapshot_state_t>::type;
+
+    //
+    // The groups written since the last clear(), one bit per group, see sparse_clear().
+    //
+    struct sparse_clear_state : public release_pages_state_t {
+        std::vector<std::uint64_t> dirty_groups_;
+    };
+
+    using sparse_clear_state_t = typename std::conditional<kSparseClear, sparse_clear_state,
+                                                           release_pages_state_t>::type;
+
+    using table_state = sparse_clear_state_t;
+
+    using snapshot_t = std::integral_constant<bool, kSnapshot>;
+    using release_pages_t = std::integral_constant<bool, kReleasePages>;
+    using sparse_clear_t = std::integral_constant<bool, kSparseClear>;
+
 private:
     group_type *    groups_;
     slot_type *     slots_;
@@ -273,6 +360,8 @@ private:
     group_allocator_type    group_allocator_;
     slot_allocator_type     slot_allocator_;
 
+    table_state             state_;
+
     static constexpr bool kIsKeyExists = false;
     static constexpr bool kNeedInsert = true;
 
@@ -300,7 +389,8 @@ public:
           hash_policy_(),
 #endif
           hasher_(hash), key_equal_(pred),
-          allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator)
+          allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator),
+          state_()
     {
         if (capacity != 0) {
             this->reserve_for_insert(capacity);
@@ -331,7 +421,8 @@ public:
         hash_policy_(),
 #endif
         hasher_(other.hash_function_ref()), key_equal_(other.key_eq_ref()),
-        allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator)
+        allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator),
+        state_()
     {
         // Prepare enough space to ensure that no expansion is required during the insertion process.
         size_type other_size = other.size();
@@ -366,8 +457,9 @@ public:
         hasher_(std::move(other.hash_function_ref())),
         key_equal_(std::move(other.key_eq_ref())),
         allocator_(std::move(other.get_allocator_ref())),
-        group_allocator_(std::move(other.get_ctrl_allocator_ref())),
-        slot_allocator_(std::move(other.get_slot_allocator_ref())) {
+        group_allocator_(std::move(other.get_group_allocator_ref())),
+        slot_allocator_(std::move(other.get_slot_allocator_ref())),
+        state_(jstd::exchange(other.state_, table_state())) {
     }
 
     group15_flat_table(group15_flat_table && other, allocator_type const & allocator) :
@@ -390,7 +482,8 @@ public:
 #endif
         hasher_(std::move(other.hash_function_ref())),
         key_equal_(std::move(other.key_eq_ref())),
-        allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator) {
+        allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator),
+        state_() {
         if (this->get_allocator_ref() == other.get_allocator_ref()) {
             // Swap content only
             this->swap_content(other);
@@ -409,6 +502,7 @@ public:
 
     ~group15_flat_table() {
         this->destroy<true>();
+        this->deallocate_released_slots();
     }
 
     group15_flat_table & operator = (const group15_flat_table & other) {
@@ -504,7 +598,7 @@ public:
     }
 
     static const char * name() noexcept {
-        return "jstd::group15_flat_map";
+        return (kIsNodeBased ? "jstd::group15_node_map" : "jstd::group15_flat_map");
     }
 
     ///
@@ -757,6 +851,30 @@ public:
         }
     }
 
+    //
+    // Same as reserve() and rehash(), but the old slots are reinserted by
+    // thread_count threads, thread_count = 0 means std::thread::hardware_concurrency().
+    // It's used to cut the pause of growing a very large table.
+    //
+    void reserve(size_type new_capacity, size_type thread_count) {
+        if (JSTD_LIKELY(new_capacity != 0)) {
+            new_capacity = this->shrink_to_fit_capacity(new_capacity);
+            this->rehash_impl<false>(new_capacity, thread_count);
+        } else {
+            this->destroy<true>();
+        }
+    }
+
+    void rehash(size_type new_capacity, size_type thread_count) {
+        size_type fit_to_now = this->shrink_to_fit_capacity(this->size());
+        new_capacity = (std::max)(fit_to_now, new_capacity);
+        if (JSTD_LIKELY(new_capacity != 0)) {
+            this->rehash_impl<false>(new_capacity, thread_count);
+        } else {
+            this->destroy<true>();
+        }
+    }
+
     JSTD_FORCED_INLINE
     void shrink_to_fit(bool read_only = false) {
         size_type new_capacity;
@@ -767,8 +885,128 @@ public:
         if (JSTD_LIKELY(new_capacity != 0)) {
             this->rehash_impl<true>(new_capacity);
         } else {
+            this->destroy<true, true>();
+        }
+    }
+
+    ///
+    /// Sparse clear
+    ///
+    /// When TablePolicy enables it, the inserts mark the groups they have written in
+    /// a bitmap of one bit per group, and clear() only resets the marked groups, instead
+    /// of all of the groups. For a big table that holds only a few elements between
+    /// two clear(), the cost of clear() is in proportion to the elements, not to
+    /// the capacity. Costs one bit test and set per insert.
+    ///
+    static constexpr bool sparse_clear() noexcept {
+        return kSparseClear;
+    }
+
+    ///
+    /// Snapshot
+    ///
+    /// save() writes the groups and slots arrays as they are, open_mapped() maps
+    /// a saved file and serves the lookups from the mapped pages directly,
+    /// without any deserialization. The pages are copy-on-write, so the mapped table
+    /// can still be modified, a grow moves it into the allocated arrays.
+    ///
+    /// Only for the trivially copyable slots, and the hasher must be the same one
+    /// (including it's seed) as the table was saved with. open_mapped() needs
+    /// the Snapshot mode of TablePolicy, any table can save().
+    ///
+    bool save(const char * path) const {
+        static_assert(is_slot_trivial_copyable,
+                      "jstd::group15_flat_table::save(): the slot must be trivially copyable.");
+        jstd::detail::flat_snapshot_header header;
+        size_type slot_capacity = this->safe_slot_capacity();
+        size_type group_capacity = (slot_capacity != 0) ? this->group_capacity() : 0;
+        jstd::detail::init_snapshot_header(header, this_type::snapshot_layout(),
+                                           group_capacity, slot_capacity);
+        header.slot_size = this->slot_size();
+        header.slot_threshold = this->slot_threshold();
+        header.max_load_factor = this->mlf_;
+        if (this->slot_size() != 0) {
+            const group_type * group = this->groups();
+            for (size_type group_index = 0; group_index < group_capacity; group_index++, group++) {
+                std::uint32_t used_mask = group->match_used();
+                if (used_mask != 0) {
+                    std::uint32_t used_pos = BitUtils::bsf32(used_mask);
+                    if (!group->is_sentinel(used_pos)) {
+                        size_type check_index = group_index * kGroupSize + used_pos;
+                        header.check_index = check_index;
+                        header.hash_check = this->hash_for(this->slots()[check_index].get_key());
+                        break;
+                    }
+                }
+            }
+        }
+        return jstd::detail::write_snapshot_file(path, header, this->groups(), this->slots());
+    }
+
+    bool open_mapped(const char * path) {
+        static_assert(is_slot_trivial_copyable,
+                      "jstd::group15_flat_table::open_mapped(): the slot must be trivially copyable.");
+        static_assert(kSnapshot,
+                      "jstd::group15_flat_table::open_mapped(): TablePolicy must enable the snapshot.");
+        jstd::mapped_file file;
+        if (!file.open(path))
+            return false;
+
+        const jstd::detail::flat_snapshot_header * header =
+            jstd::detail::check_snapshot_header(file, this_type::snapshot_layout());
+        if (header == nullptr)
+            return false;
+
+        size_type new_group_capacity = static_cast<size_type>(header->group_capacity);
+        if (new_group_capacity == 0) {
             this->destroy<true>();
+            return true;
+        }
+        size_type new_capacity = new_group_capacity * kGroupWidth;
+        size_type new_slot_capacity = static_cast<size_type>(header->slot_capacity);
+        if (!this->is_valid_capacity(new_capacity) ||
+            (new_slot_capacity != this_type::calc_slot_capacity(new_group_capacity)) ||
+            (header->slot_threshold > new_slot_capacity))
+            return false;
+
+        group_type * new_groups = reinterpret_cast<group_type *>(file.data() + header->groups_offset);
+        slot_type * new_slots = reinterpret_cast<slot_type *>(file.data() + header->slots_offset);
+        if (header->slot_size != 0) {
+            size_type check_index = static_cast<size_type>(header->check_index);
+            if ((check_index >= new_slot_capacity) ||
+                !new_groups[check_index / kGroupSize].is_used(check_index % kGroupSize) ||
+                (this->hash_for(new_slots[check_index].get_key()) != header->hash_check))
+                return false;
         }
+
+        this->destroy<true>();
+
+#if GROUP15_USE_HASH_POLICY
+        auto hash_policy_setting = this->hash_policy_.calc_next_capacity(new_capacity);
+        this->hash_policy_.commit(hash_policy_setting);
+#endif
+        this->groups_ = new_groups;
+        this->slots_ = new_slots;
+        this->slot_size_ = static_cast<size_type>(header->slot_size);
+        this->slot_threshold_ = static_cast<size_type>(header->slot_threshold);
+#if GROUP15_USE_INDEX_SHIFT && (GROUP15_USE_HASH_POLICY == 0)
+        this->group_mask_ = this_type::calc_group_mask(new_group_capacity, new_capacity);
+        this->index_shift_ = this_type::calc_index_shift(new_capacity);
+#else
+        this->ctrl_mask_ = new_capacity - 1;
+        this->slot_capacity_ = new_slot_capacity;
+#endif
+        this->mlf_ = static_cast<size_type>(header->max_load_factor);
+#if GROUP15_USE_SEPARATE_SLOTS
+        this->groups_alloc_ = nullptr;
+#endif
+        this->state_.mapped_.swap(file);
+        this->reset_dirty_groups(true);
+        return true;
+    }
+
+    bool is_mapped() const noexcept {
+        return this->is_mapped(snapshot_t{});
     }
 
     ///
@@ -819,12 +1057,20 @@ public:
     ///
     /// Modifiers
     ///
+    //
+    // clear(true) frees the arrays. With the ReleasePages mode of TablePolicy, the pages
+    // of a huge slot array are returned to the OS instead, and the array is reused
+    // by the next growth to the same capacity.
+    //
     JSTD_FORCED_INLINE
     void clear(bool need_destroy = false) noexcept {
         if (!need_destroy) {
-            this->clear_data();
+            if (kSparseClear && this->has_dirty_groups())
+                this->clear_dirty_groups();
+            else
+                this->clear_data();
         } else {
-            this->destroy<true>();
+            this->destroy<true, true>();
         }
         assert(this->slot_size() == 0);
     }
@@ -843,12 +1089,12 @@ public:
     }
 
     JSTD_FORCED_INLINE
-    std::pair<iterator, bool> insert(const init_type & value) {
+    std::pair<iterator, bool> insert(const init_arg_type & value) {
         return this->emplace_impl<false>(value);
     }
 
     JSTD_FORCED_INLINE
-    std::pair<iterator, bool> insert(init_type && value) {
+    std::pair<iterator, bool> insert(init_arg_type && value) {
         return this->emplace_impl<false>(std::move(value));
     }
 
@@ -873,12 +1119,12 @@ public:
     }
 
     JSTD_FORCED_INLINE
-    iterator insert(const_iterator hint, const init_type & value) {
+    iterator insert(const_iterator hint, const init_arg_type & value) {
         return this->emplace_impl<false>(value).first;
     }
 
     JSTD_FORCED_INLINE
-    iterator insert(const_iterator hint, init_type && value) {
+    iterator insert(const_iterator hint, init_arg_type && value) {
         return this->emplace_impl<false>(std::move(value)).first;
     }
 
@@ -904,6 +1150,19 @@ public:
         this->insert(ilist.begin(), ilist.end());
     }
 
+    //
+    // Bulk insert [first, last) by thread_count threads, thread_count = 0 means
+    // std::thread::hardware_concurrency(). The table is sized once, the keys are
+    // hashed in parallel and partitioned by the destination group range, and then
+    // each thread fills its own group range. Like insert(first, last), the first one
+    // of the duplicate keys is kept. Non random access iterators use insert(first, last).
+    //
+    template <typename InputIter>
+    void build_from(InputIter first, InputIter last, size_type thread_count = 0) {
+        this->build_from_impl(first, last, thread_count,
+                              typename std::iterator_traits<InputIter>::iterator_category());
+    }
+
     ///
     /// insert_or_assign(key, value)
     ///
@@ -928,19 +1187,19 @@ public:
     template <typename MappedT>
     JSTD_FORCED_INLINE
     iterator insert_or_assign(const_iterator hint, const key_type & key, MappedT && value) {
-        return this->emplace_impl<true>(key, std::forward<MappedT>(value))->first;
+        return this->emplace_impl<true>(key, std::forward<MappedT>(value)).first;
     }
 
     template <typename MappedT>
     JSTD_FORCED_INLINE
     iterator insert_or_assign(const_iterator hint, key_type && key, MappedT && value) {
-        return this->emplace_impl<true>(std::move(key), std::forward<MappedT>(value))->first;
+        return this->emplace_impl<true>(std::move(key), std::forward<MappedT>(value)).first;
     }
 
     template <typename KeyT, typename MappedT>
     JSTD_FORCED_INLINE
     iterator insert_or_assign(const_iterator hint, KeyT && key, MappedT && value) {
-        return this->emplace_impl<true>(std::move(key), std::forward<MappedT>(value))->first;
+        return this->emplace_impl<true>(std::move(key), std::forward<MappedT>(value)).first;
     }
 
     ///
@@ -997,6 +1256,68 @@ public:
         return this->try_emplace_impl(std::forward<KeyT>(key), std::forward<Args>(args)...);
     }
 
+    ///
+    /// insert_batch(values, count)
+    ///
+    template <typename ValueT>
+    size_type insert_batch(const ValueT * values, size_type count) {
+        std::size_t key_hashs[kBatchPrefetchSize];
+        size_type num_inserted = 0;
+
+        this->reserve_for_batch(count);
+        for (size_type offset = 0; offset < count; offset += kBatchPrefetchSize) {
+            size_type batch_size = (std::min)(count - offset, kBatchPrefetchSize);
+            const ValueT * batch = values + offset;
+            for (size_type i = 0; i < batch_size; i++) {
+                key_hashs[i] = this->prefetch_hash_for(type_policy::extract(batch[i]));
+            }
+            for (size_type i = 0; i < batch_size; i++) {
+                auto find_info = this->find_or_insert(type_policy::extract(batch[i]), key_hashs[i]);
+                if (find_info.second) {
+                    // The key to be inserted is not exists.
+                    slot_type * slot = find_info.first.slot();
+                    assert(slot != nullptr);
+                    assert(slot < this->last_slot());
+                    SlotPolicyTraits::construct(&this->slot_allocator_, slot, batch[i]);
+                    this->slot_size_++;
+                    num_inserted++;
+                }
+            }
+        }
+        return num_inserted;
+    }
+
+    ///
+    /// try_emplace_batch(keys, values, count)
+    ///
+    template <typename KeyT, typename MappedT>
+    size_type try_emplace_batch(const KeyT * keys, const MappedT * values, size_type count) {
+        std::size_t key_hashs[kBatchPrefetchSize];
+        size_type num_inserted = 0;
+
+        this->reserve_for_batch(count);
+        for (size_type offset = 0; offset < count; offset += kBatchPrefetchSize) {
+            size_type batch_size = (std::min)(count - offset, kBatchPrefetchSize);
+            for (size_type i = 0; i < batch_size; i++) {
+                key_hashs[i] = this->prefetch_hash_for(keys[offset + i]);
+            }
+            for (size_type i = 0; i < batch_size; i++) {
+                auto find_info = this->find_or_insert(keys[offset + i], key_hashs[i]);
+                if (find_info.second) {
+                    // The key to be inserted is not exists.
+                    slot_type * slot = find_info.first.slot();
+                    assert(slot != nullptr);
+                    assert(slot < this->last_slot());
+                    SlotPolicyTraits::construct(&this->slot_allocator_, slot,
+                                                keys[offset + i], values[offset + i]);
+                    this->slot_size_++;
+                    num_inserted++;
+                }
+            }
+        }
+        return num_inserted;
+    }
+
     ///
     /// erase(key)
     ///
@@ -1008,10 +1329,19 @@ public:
 
     JSTD_FORCED_INLINE
     iterator erase(iterator pos) {
+#if ITERATOR15_USE_LOCATOR
         locator_t & locator = pos.locator();
         this->erase_slot(locator);
         locator.increment();
         return { locator };
+#else
+        std::uintptr_t ctrl_addr = reinterpret_cast<std::uintptr_t>(pos.ctrl());
+        locator_t locator(reinterpret_cast<const group_type *>(ctrl_addr & ~std::uintptr_t(kGroupWidth - 1)),
+                          static_cast<size_type>(ctrl_addr % kGroupWidth), pos.slot());
+        ++pos;
+        this->erase_slot(locator);
+        return pos;
+#endif
     }
 
     JSTD_FORCED_INLINE
@@ -1187,6 +1517,10 @@ public:
     }
 
 private:
+    static inline jstd::detail::flat_snapshot_layout snapshot_layout() noexcept {
+        return { "JSTDG15", sizeof(group_type), sizeof(slot_type), sizeof(key_type), sizeof(mapped_type) };
+    }
+
     static inline group_type * default_empty_groups() noexcept {
         alignas(16) static const ctrl_type s_empty_ctrls[kGroupWidth * 2] = {
             // Group 0
@@ -1438,7 +1772,7 @@ private:
             return iter.index(this);
         } else {
             const slot_type * slot = iter.slot();
-            size_type ctrl_index = this->bucket(slot->key);
+            size_type ctrl_index = this->bucket(slot->get_key());
             return ctrl_index;
         }
     }
@@ -1448,7 +1782,7 @@ private:
             return iter.index(this);
         } else {
             const slot_type * slot = iter.slot();
-            size_type ctrl_index = this->bucket(slot->key);
+            size_type ctrl_index = this->bucket(slot->get_key());
             return ctrl_index;
         }
     }
@@ -1487,20 +1821,108 @@ private:
         return const_cast<const char *>(reinterpret_cast<char *>(ptr) + offset);
     }
 
-    template <bool NeedClearSlots>
+    template <bool NeedClearSlots, bool ReleaseSlots = false>
     void destroy() {
-        this->destroy_data<NeedClearSlots>();
+        this->destroy_data<NeedClearSlots, ReleaseSlots>();
     }
 
-    template <bool NeedClearSlots>
+    template <bool NeedClearSlots, bool ReleaseSlots = false>
     JSTD_NO_INLINE
     void destroy_data() {
+        this->drop_dirty_groups();
+        if (JSTD_UNLIKELY(this->is_mapped())) {
+            this->destroy_mapped();
+            return;
+        }
         // Note!!: destroy_slots() need use this->ctrls(), so must destroy slots first.
         size_type group_capacity = this->group_capacity();
-        this->destroy_slots<NeedClearSlots>();
+        this->destroy_slots<NeedClearSlots, ReleaseSlots>();
         this->destroy_groups(group_capacity);
     }
 
+    //
+    // The slots are trivially destructible, so just unmap the arrays.
+    //
+    void destroy_mapped() noexcept {
+        this->groups_ = this_type::default_empty_groups();
+        this->slots_ = nullptr;
+        this->slot_size_ = 0;
+        this->slot_threshold_ = 0;
+#if GROUP15_USE_INDEX_SHIFT && (GROUP15_USE_HASH_POLICY == 0)
+        this->group_mask_ = 0;
+        this->index_shift_ = kWordLength - 1;
+#else
+        this->ctrl_mask_ = size_type(-1);
+        this->slot_capacity_ = 0;
+#endif
+#if GROUP15_USE_HASH_POLICY
+        this->hash_policy_.reset();
+#endif
+#if GROUP15_USE_SEPARATE_SLOTS
+        this->groups_alloc_ = nullptr;
+#endif
+        this->close_mapped();
+    }
+
+    bool is_mapped(std::false_type) const noexcept {
+        return false;
+    }
+
+    bool is_mapped(std::true_type) const noexcept {
+        return this->state_.mapped_.is_open();
+    }
+
+    void close_mapped() noexcept {
+        this->close_mapped(snapshot_t{});
+    }
+
+    void close_mapped(std::false_type) noexcept {
+    }
+
+    void close_mapped(std::true_type) noexcept {
+        this->state_.mapped_.close();
+    }
+
+    slot_type * allocate_slots(size_type slot_count) {
+        return this->allocate_slots(slot_count, release_pages_t{});
+    }
+
+    slot_type * allocate_slots(size_type slot_count, std::false_type) {
+        return SlotAllocTraits::allocate(this->slot_allocator_, slot_count);
+    }
+
+    slot_type * allocate_slots(size_type slot_count, std::true_type) {
+        return this->state_.released_slots_.allocate(this->slot_allocator_, slot_count);
+    }
+
+    //
+    // Returns false if the array is not kept, then the caller frees it.
+    //
+    bool retain_slots(slot_type * slots, size_type slot_count) noexcept {
+        return this->retain_slots(slots, slot_count, release_pages_t{});
+    }
+
+    bool retain_slots(slot_type * slots, size_type slot_count, std::false_type) noexcept {
+        JSTD_UNUSED(slots);
+        JSTD_UNUSED(slot_count);
+        return false;
+    }
+
+    bool retain_slots(slot_type * slots, size_type slot_count, std::true_type) noexcept {
+        return this->state_.released_slots_.retain(this->slot_allocator_, slots, slot_count);
+    }
+
+    void deallocate_released_slots() noexcept {
+        this->deallocate_released_slots(release_pages_t{});
+    }
+
+    void deallocate_released_slots(std::false_type) noexcept {
+    }
+
+    void deallocate_released_slots(std::true_type) noexcept {
+        this->state_.released_slots_.deallocate(this->slot_allocator_);
+    }
+
     JSTD_FORCED_INLINE
     void destroy_groups(size_type group_capacity) noexcept {
         JSTD_UNUSED(group_capacity);
@@ -1515,7 +1937,7 @@ private:
         }
     }
 
-    template <bool NeedClearSlots>
+    template <bool NeedClearSlots, bool ReleaseSlots = false>
     JSTD_FORCED_INLINE
     void destroy_slots() {
         if (NeedClearSlots) {
@@ -1524,12 +1946,15 @@ private:
 
         if (this->slots_ != nullptr) {
 #if GROUP15_USE_SEPARATE_SLOTS
-            SlotAllocTraits::deallocate(this->slot_allocator_, this->slots_, this->slot_capacity());
+            size_type total_slot_alloc_size = this->slot_capacity();
 #else
             size_type total_slot_alloc_size = this->TotalSlotAllocCount<kGroupAlignment>(
                                                     this->group_capacity(), this->slot_capacity());
-            SlotAllocTraits::deallocate(this->slot_allocator_, this->slots_, total_slot_alloc_size);
 #endif
+            if (!ReleaseSlots ||
+                !this->retain_slots(this->slots_, total_slot_alloc_size)) {
+                SlotAllocTraits::deallocate(this->slot_allocator_, this->slots_, total_slot_alloc_size);
+            }
             // Reset slots state
             this->slots_ = nullptr;
             this->slot_size_ = 0;
@@ -1590,6 +2015,109 @@ private:
         this_type::set_sentinel_mark(this->groups(), this->group_capacity());
     }
 
+    void reset_dirty_groups(bool all_dirty) {
+        this->reset_dirty_groups(all_dirty, sparse_clear_t{});
+    }
+
+    void reset_dirty_groups(bool all_dirty, std::false_type) noexcept {
+        JSTD_UNUSED(all_dirty);
+    }
+
+    void reset_dirty_groups(bool all_dirty, std::true_type) {
+        if (this->slots_ != nullptr) {
+            size_type word_count = (this->group_capacity() + 63) / 64;
+            try {
+                this->state_.dirty_groups_.assign(word_count, all_dirty ? ~std::uint64_t(0) : std::uint64_t(0));
+            } catch (const std::bad_alloc &) {
+                // Without the bitmap, clear() resets all of the groups.
+                this->state_.dirty_groups_.clear();
+            }
+        } else {
+            this->state_.dirty_groups_.clear();
+        }
+    }
+
+    void drop_dirty_groups() noexcept {
+        this->drop_dirty_groups(sparse_clear_t{});
+    }
+
+    void drop_dirty_groups(std::false_type) noexcept {
+    }
+
+    void drop_dirty_groups(std::true_type) noexcept {
+        this->state_.dirty_groups_.clear();
+    }
+
+    bool has_dirty_groups() const noexcept {
+        return this->has_dirty_groups(sparse_clear_t{});
+    }
+
+    bool has_dirty_groups(std::false_type) const noexcept {
+        return false;
+    }
+
+    bool has_dirty_groups(std::true_type) const noexcept {
+        return !this->state_.dirty_groups_.empty();
+    }
+
+    JSTD_FORCED_INLINE
+    void mark_dirty_group(size_type group_index) noexcept {
+        this->mark_dirty_group(group_index, sparse_clear_t{});
+    }
+
+    JSTD_FORCED_INLINE
+    void mark_dirty_group(size_type group_index, std::false_type) noexcept {
+        JSTD_UNUSED(group_index);
+    }
+
+    JSTD_FORCED_INLINE
+    void mark_dirty_group(size_type group_index, std::true_type) noexcept {
+        size_type word_index = group_index / 64;
+        if (JSTD_LIKELY(word_index < this->state_.dirty_groups_.size())) {
+            this->state_.dirty_groups_[word_index] |= std::uint64_t(1) << (group_index % 64);
+        }
+    }
+
+    void clear_dirty_groups() noexcept {
+        this->clear_dirty_groups(sparse_clear_t{});
+    }
+
+    void clear_dirty_groups(std::false_type) noexcept {
+    }
+
+    void clear_dirty_groups(std::true_type) noexcept {
+        assert(!this->state_.dirty_groups_.empty());
+        group_type * groups = this->groups();
+        size_type group_capacity = this->group_capacity();
+        for (size_type word_index = 0; word_index < this->state_.dirty_groups_.size(); word_index++) {
+            std::uint64_t dirty_bits = this->state_.dirty_groups_[word_index];
+            while (dirty_bits != 0) {
+                size_type group_index = word_index * 64 + BitUtils::bsf64(dirty_bits);
+                dirty_bits = BitUtils::clearLowBit64(dirty_bits);
+                if (group_index >= group_capacity)
+                    break;
+                group_type * group = groups + group_index;
+                if (!is_slot_trivial_destructor) {
+                    slot_type * slot_base = this->slots() + group_index * kGroupSize;
+                    std::uint32_t used_mask = group->match_used();
+                    while (used_mask != 0) {
+                        std::uint32_t used_pos = BitUtils::bsf32(used_mask);
+                        if (JSTD_UNLIKELY(group->is_sentinel(used_pos)))
+                            break;
+                        this->destroy_slot(slot_base + used_pos);
+                        used_mask = BitUtils::clearLowBit32(used_mask);
+                    }
+                }
+                group->init();
+            }
+            this->state_.dirty_groups_[word_index] = 0;
+        }
+
+        // Set the sentinel mark
+        this_type::set_sentinel_mark(groups, group_capacity);
+        this->slot_size_ = 0;
+    }
+
     JSTD_FORCED_INLINE
     void clear_groups(group_type * groups, size_type group_capacity) {
         this_type::init_groups(groups, group_capacity, std::is_trivially_default_constructible<group_type>{});
@@ -1675,6 +2203,8 @@ private:
         if (this->slots() != nullptr && other.slots() != nullptr) {
             copy_groups_array_from(other);
             copy_slots_array_from(other);
+            this->slot_size_ = other.slot_size();
+            this->reset_dirty_groups(true);
         } else {
             assert(false);
         }
@@ -1708,7 +2238,8 @@ private:
     void copy_slots_array_from(group15_flat_table const & other) {
         this->copy_slots_array_from(
             other,
-            std::integral_constant<bool, std::is_trivially_copy_constructible<element_type>::value &&
+            std::integral_constant<bool, !kIsNodeBased &&
+                                         std::is_trivially_copy_constructible<element_type>::value &&
                                         (jstd::is_std_allocator<Allocator>::value ||
                                         !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value)>{}
         );
@@ -1722,7 +2253,7 @@ private:
          */
         std::memcpy(
             reinterpret_cast<unsigned char *>(this->slots()),
-            reinterpret_cast<unsigned char *>(other.slots()),
+            reinterpret_cast<const unsigned char *>(other.slots()),
             other.slot_capacity() * sizeof(slot_type));
     }
 
@@ -1822,6 +2353,8 @@ private:
         if (this->slots() != nullptr && other.slots() != nullptr) {
             move_groups_array_from(other);
             move_slots_array_from(other);
+            this->slot_size_ = other.slot_size();
+            this->reset_dirty_groups(true);
         } else {
             assert(false);
         }
@@ -1860,9 +2393,7 @@ private:
     void move_slots_array_from(group15_flat_table & other) {
         this->move_slots_array_from(
             other,
-            std::integral_constant<bool, std::is_trivially_copy_constructible<element_type>::value &&
-                                        (jstd::is_std_allocator<Allocator>::value ||
-                                        !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value)>{}
+            std::integral_constant<bool, kIsRelocatableSlot>{}
         );
     }
 
@@ -1870,15 +2401,18 @@ private:
     void move_slots_array_from(group15_flat_table & other, std::true_type /* -> memcpy */) {
         /*
          * reinterpret_cast: GCC may complain about value_type not being trivially
-         * copy-assignable when we're relying on trivial copy constructibility.
+         * copy-assignable when we're relying on trivial copy constructibility
+         * or the trivial relocatability.
          */
         std::memcpy(
             reinterpret_cast<unsigned char *>(this->slots()),
-            reinterpret_cast<unsigned char *>(other.slots()),
+            reinterpret_cast<const unsigned char *>(other.slots()),
             other.slot_capacity() * sizeof(slot_type));
 
-        // Reset all of other slots
-        std::fill_n(other.slots(), other.slot_capacity(), slot_type());
+        // move_groups_array_from() only copies the groups, the other groups still mark
+        // the relocated elements as used, they must not be destroyed there. The caller
+        // releases the other table by destroy<false>(), it frees the arrays without
+        // destroying the slots.
     }
 
     JSTD_FORCED_INLINE
@@ -2069,11 +2603,11 @@ private:
             group_type * new_groups_alloc = GroupAllocTraits::allocate(this->group_allocator_, total_group_alloc_count);
             group_type * new_groups = this->AlignedGroups<kGroupAlignment>(new_groups_alloc);
 
-            slot_type * new_slots = SlotAllocTraits::allocate(this->slot_allocator_, new_slot_capacity);
+            slot_type * new_slots = this->allocate_slots(new_slot_capacity);
 #else
             size_type total_slot_alloc_count = this->TotalSlotAllocCount<kGroupAlignment>(new_group_capacity, new_slot_capacity);
 
-            slot_type * new_slots = SlotAllocTraits::allocate(this->slot_allocator_, total_slot_alloc_count);
+            slot_type * new_slots = this->allocate_slots(total_slot_alloc_count);
             group_type * new_groups = this->AlignedSlotsAndGroups<kGroupAlignment>(new_slots, new_slot_capacity);
             assert((void *)new_slots != (void *)new_groups);
 #endif
@@ -2099,6 +2633,7 @@ private:
 #if GROUP15_USE_SEPARATE_SLOTS
             this->groups_alloc_ = new_groups_alloc;
 #endif
+            this->reset_dirty_groups(false);
         } else {
             this->destroy<true>();
         }
@@ -2106,7 +2641,7 @@ private:
 
     template <bool AllowShrink>
     JSTD_NO_INLINE
-    void rehash_impl(size_type new_capacity) {
+    void rehash_impl(size_type new_capacity, size_type thread_count = 1) {
         new_capacity = this->calc_capacity(new_capacity);
         assert(new_capacity > 0);
         assert(new_capacity >= kMinCapacity);
@@ -2123,10 +2658,16 @@ private:
             slot_type * old_slots = this->slots();
             slot_type * old_last_slot = this->safe_last_slot();
             size_type old_slot_size = this->slot_size();
+            bool old_is_mapped = this->is_mapped();
 
             this->create_slots<false>(new_capacity);
 
-            if (old_groups != this_type::default_empty_groups()) {
+            if ((old_groups != this_type::default_empty_groups()) &&
+                !this->try_parallel_transfer(old_groups, old_group_capacity, old_slots,
+                                             old_slot_size, thread_count)) {
+                // With GROUP15_USE_INDEX_SHIFT, the home index is the high bits of the hash,
+                // so the old groups are scanned in the order of their new home regions, and
+                // this loop already writes the new arrays region by region, except the probed slots.
                 assert(old_groups != nullptr);
                 assert(old_slots != nullptr);
                 assert(old_group_capacity > 0);
@@ -2158,27 +2699,356 @@ private:
 
             assert(this->slot_size() == old_slot_size);
 
+            if (JSTD_UNLIKELY(old_is_mapped)) {
+                // The old arrays are in the mapped file.
+                this->close_mapped();
+                return;
+            }
+
 #if GROUP15_USE_SEPARATE_SLOTS
             if (old_groups != this_type::default_empty_groups()) {
                 assert(old_groups_alloc != nullptr);
                 size_type total_group_alloc_count = this->TotalGroupAllocCount<kGroupAlignment>(old_group_capacity);
                 GroupAllocTraits::deallocate(this->group_allocator_, old_groups_alloc, total_group_alloc_count);
             }
+#endif
             if (old_slots != nullptr) {
                 size_type old_slot_capacity = this_type::calc_slot_capacity(old_group_capacity);
                 assert(old_slot_capacity != 0);
-                SlotAllocTraits::deallocate(this->slot_allocator_, old_slots, old_slot_capacity);
-            }
+#if GROUP15_USE_SEPARATE_SLOTS
+                size_type total_slot_alloc_count = old_slot_capacity;
 #else
-            if (old_slots != nullptr) {
-                size_type old_slot_capacity = this_type::calc_slot_capacity(old_group_capacity);
-                assert(old_slot_capacity != 0);
                 size_type total_slot_alloc_count = this->TotalSlotAllocCount<kGroupAlignment>(
                                                          old_group_capacity, old_slot_capacity);
-                SlotAllocTraits::deallocate(this->slot_allocator_, old_slots, total_slot_alloc_count);
-            }
 #endif
+                // Shrinking, keep the old slots for the next growth, but return it's pages.
+                bool is_shrink = AllowShrink && (this->slot_capacity() < old_slot_capacity);
+                if (!is_shrink ||
+                    !this->retain_slots(old_slots, total_slot_alloc_count)) {
+                    SlotAllocTraits::deallocate(this->slot_allocator_, old_slots, total_slot_alloc_count);
+                }
+            }
+        }
+    }
+
+    struct build_item {
+        size_type    index;
+        std::size_t  key_hash;
+    };
+
+    template <typename InputIter>
+    void build_from_impl(InputIter first, InputIter last, size_type thread_count,
+                         std::input_iterator_tag) {
+        JSTD_UNUSED(thread_count);
+        this->insert(first, last);
+    }
+
+    //
+    // Same three phases as try_parallel_transfer(), but the partition threads
+    // also look up the duplicate keys, and the phase 2 can be failed by
+    // the constructor of value_type, the elements inserted so far are kept.
+    //
+    template <typename RandomIter>
+    JSTD_NO_INLINE
+    void build_from_impl(RandomIter first, RandomIter last, size_type thread_count,
+                         std::random_access_iterator_tag) {
+        size_type count = static_cast<size_type>(std::distance(first, last));
+        if (count == 0)
+            return;
+
+        thread_count = jstd::detail::clamp_rehash_threads(thread_count);
+        // The node allocator (eg. the pool) may be not thread-safe, so the node maps are built serially.
+        if ((thread_count <= 1) || (count < kMinParallelRehashSize) || kIsNodeBased) {
+            this->reserve(this->size() + count);
+            this->insert(first, last);
+            return;
+        }
+
+        // Size the table once.
+        this->reserve(this->size() + count, thread_count);
+
+        size_type group_capacity = this->group_capacity();
+        thread_count = (std::min)(thread_count, group_capacity);
+        size_type part_groups = (group_capacity + thread_count - 1) / thread_count;
+
+        std::vector<std::vector<build_item>> buckets(thread_count * thread_count);
+        std::vector<size_type> inserted_counts(thread_count, 0);
+        std::vector<std::exception_ptr> exceptions(thread_count);
+
+        // Phase 1: hash and partition
+        jstd::detail::parallel_run(thread_count, [&](size_type index) {
+            size_type first_index = count * index / thread_count;
+            size_type last_index  = count * (index + 1) / thread_count;
+            std::vector<build_item> * part_buckets = &buckets[index * thread_count];
+            try {
+                for (size_type i = first_index; i < last_index; i++) {
+                    std::size_t key_hash = this->hash_for(type_policy::extract(*(first + i)));
+                    size_type part = this->index_for_hash(key_hash) / part_groups;
+                    assert(part < thread_count);
+                    part_buckets[part].push_back({ i, key_hash });
+                }
+            } catch (...) {
+                exceptions[index] = std::current_exception();
+            }
+        });
+
+        for (size_type i = 0; i < thread_count; i++) {
+            if (exceptions[i])
+                std::rethrow_exception(exceptions[i]);
+        }
+
+        // Phase 2: fill the group range of each partition
+        jstd::detail::parallel_run(thread_count, [&](size_type part) {
+            size_type first_group = part * part_groups;
+            size_type last_group  = (std::min)(first_group + part_groups, group_capacity);
+            size_type inserted = 0;
+            try {
+                for (size_type i = 0; i < thread_count; i++) {
+                    std::vector<build_item> & bucket = buckets[i * thread_count + part];
+                    size_type remain = 0;
+                    for (size_type n = 0; n < bucket.size(); n++) {
+                        const build_item & item = bucket[n];
+                        const auto & value = *(first + item.index);
+                        auto find_info = this->find_or_insert_in_range(type_policy::extract(value), item.key_hash,
+                                                                       first_group, last_group);
+                        slot_type * slot = find_info.first;
+                        if (find_info.second == kIsKeyExists)
+                            continue;
+                        if (JSTD_LIKELY(slot != nullptr)) {
+                            try {
+                                SlotPolicyTraits::construct(&this->slot_allocator_, slot, value);
+                            } catch (...) {
+                                size_type slot_index = static_cast<size_type>(slot - this->slots());
+                                group_type * group = this->groups() + slot_index / kGroupSize;
+                                group->set_empty(slot_index % kGroupSize);
+                                throw;
+                            }
+                            inserted++;
+                        } else {
+                            bucket[remain++] = item;
+                        }
+                    }
+                    bucket.resize(remain);
+                }
+            } catch (...) {
+                exceptions[part] = std::current_exception();
+            }
+            inserted_counts[part] = inserted;
+        });
+
+        // find_or_insert_in_range() doesn't mark the dirty groups.
+        this->reset_dirty_groups(true);
+
+        for (size_type i = 0; i < thread_count; i++) {
+            this->slot_size_ += inserted_counts[i];
+        }
+        assert(this->slot_size() <= this->slot_capacity());
+
+        for (size_type i = 0; i < thread_count; i++) {
+            if (exceptions[i])
+                std::rethrow_exception(exceptions[i]);
+        }
+
+        // Phase 3: the remaining elements
+        for (size_type i = 0; i < buckets.size(); i++) {
+            for (const build_item & item : buckets[i]) {
+                this->emplace_impl<false>(*(first + item.index));
+            }
+        }
+    }
+
+    //
+    // Same as find_or_insert(), but only probe the groups in [first_group, last_group),
+    // returns { nullptr, kNeedInsert } if the probe leaves the range.
+    //
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    std::pair<slot_type *, bool> find_or_insert_in_range(const KeyT & key, std::size_t key_hash,
+                                                         size_type first_group, size_type last_group) {
+        size_type group_index = this->index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
+        auto hash_bits = group_type::make_hash_bits(ctrl_hash);
+        prober_type prober(group_index);
+
+        do {
+            group_index = prober.get();
+            if ((group_index < first_group) || (group_index >= last_group))
+                return { nullptr, kNeedInsert };
+            const group_type * group = this->groups() + group_index;
+            std::uint32_t match_mask = group->match_hash(hash_bits);
+            if (match_mask != 0) {
+                slot_type * slot_base = this->slots() + group_index * kGroupSize;
+                do {
+                    std::uint32_t match_pos = BitUtils::bsf32(match_mask);
+                    slot_type * slot = slot_base + match_pos;
+                    if (bool(this->key_equal_(key, slot->get_key()))) {
+                        return { slot, kIsKeyExists };
+                    }
+                    match_mask = BitUtils::clearLowBit32(match_mask);
+                } while (match_mask != 0);
+            }
+            if (JSTD_LIKELY(group->is_not_overflow(ctrl_hash)))
+                break;
+        } while (prober.next_bucket(this->group_mask()));
+
+        slot_type * slot = this->find_empty_in_range(key_hash, first_group, last_group);
+        return { slot, kNeedInsert };
+    }
+
+    struct rehash_item {
+        slot_type *  slot;
+        std::size_t  key_hash;
+    };
+
+    //
+    // Transfer the old slots by several threads, in three phases:
+    //
+    //   1. Each thread hashes a range of the old groups, and scatters the slots
+    //      into the buckets of the new group partition where their home group is.
+    //   2. Each thread inserts the slots of one partition, the probe never leaves
+    //      the partition, so the threads never write the same group. The slots
+    //      whose probe would leave the partition are kept in the buckets.
+    //   3. The calling thread inserts the remaining slots.
+    //
+    // Returns false if it isn't worth it or the buckets can't be allocated,
+    // the old slots are untouched then. A transfer mustn't throw in the threads,
+    // so the slots whose move may throw always take the serial loop.
+    //
+    JSTD_NO_INLINE
+    bool try_parallel_transfer(group_type * old_groups, size_type old_group_capacity,
+                               slot_type * old_slots, size_type old_slot_size,
+                               size_type thread_count) {
+        if (!kIsNothrowTransfer || (thread_count == 1) || (old_slot_size < kMinParallelRehashSize))
+            return false;
+
+        size_type new_group_capacity = this->group_capacity();
+        thread_count = jstd::detail::clamp_rehash_threads(thread_count);
+        thread_count = (std::min)(thread_count, new_group_capacity);
+        if (thread_count <= 1)
+            return false;
+
+        size_type part_groups = (new_group_capacity + thread_count - 1) / thread_count;
+
+        std::vector<std::vector<rehash_item>> buckets;
+        std::vector<size_type> inserted_counts;
+        std::vector<std::uint8_t> is_failed;
+        try {
+            buckets.resize(thread_count * thread_count);
+            inserted_counts.resize(thread_count, 0);
+            is_failed.resize(thread_count, 0);
+        } catch (...) {
+            return false;
+        }
+
+        // Phase 1: scatter
+        jstd::detail::parallel_run(thread_count, [&](size_type index) {
+            size_type first_group = old_group_capacity * index / thread_count;
+            size_type last_group  = old_group_capacity * (index + 1) / thread_count;
+            std::vector<rehash_item> * part_buckets = &buckets[index * thread_count];
+            try {
+                for (size_type group_index = first_group; group_index < last_group; group_index++) {
+                    const group_type * group = old_groups + group_index;
+                    slot_type * slot_base = old_slots + group_index * kGroupSize;
+                    std::uint32_t used_mask = group->match_used();
+                    while (used_mask != 0) {
+                        std::uint32_t used_pos = BitUtils::bsf32(used_mask);
+                        if (JSTD_UNLIKELY(group->is_sentinel(used_pos)))
+                            break;
+                        used_mask = BitUtils::clearLowBit32(used_mask);
+                        slot_type * old_slot = slot_base + used_pos;
+                        std::size_t key_hash = this->hash_for(old_slot->get_key());
+                        size_type part = this->index_for_hash(key_hash) / part_groups;
+                        assert(part < thread_count);
+                        part_buckets[part].push_back({ old_slot, key_hash });
+                    }
+                }
+            } catch (...) {
+                is_failed[index] = 1;
+            }
+        });
+
+        for (size_type i = 0; i < thread_count; i++) {
+            if (is_failed[i] != 0)
+                return false;
         }
+
+        // Phase 2: insert by partition
+        jstd::detail::parallel_run(thread_count, [&](size_type part) {
+            size_type first_group = part * part_groups;
+            size_type last_group  = (std::min)(first_group + part_groups, new_group_capacity);
+            size_type inserted = 0;
+            for (size_type i = 0; i < thread_count; i++) {
+                std::vector<rehash_item> & bucket = buckets[i * thread_count + part];
+                size_type remain = 0;
+                for (size_type n = 0; n < bucket.size(); n++) {
+                    const rehash_item & item = bucket[n];
+                    slot_type * new_slot = this->find_empty_in_range(item.key_hash, first_group, last_group);
+                    if (JSTD_LIKELY(new_slot != nullptr)) {
+                        this->transfer_slot(new_slot, item.slot);
+                        inserted++;
+                    } else {
+                        bucket[remain++] = item;
+                    }
+                }
+                bucket.resize(remain);
+            }
+            inserted_counts[part] = inserted;
+        });
+
+        // find_empty_in_range() doesn't mark the dirty groups.
+        this->reset_dirty_groups(true);
+
+        // Phase 3: the remaining slots
+        for (size_type i = 0; i < buckets.size(); i++) {
+            for (const rehash_item & item : buckets[i]) {
+                size_type group_index = this->index_for_hash(item.key_hash);
+                std::size_t ctrl_hash = this->ctrl_for_hash(item.key_hash);
+                locator_t locator = this->find_empty_to_insert<true, key_type>(
+                                          item.slot->get_key(), group_index, ctrl_hash);
+                assert(locator.slot() != nullptr);
+                this->transfer_slot(locator.slot(), item.slot);
+                this->slot_size_++;
+            }
+        }
+
+        for (size_type i = 0; i < thread_count; i++) {
+            this->slot_size_ += inserted_counts[i];
+        }
+        assert(this->slot_size() <= this->slot_capacity());
+        return true;
+    }
+
+    //
+    // Same as find_empty_to_insert<true>(), but only probe the groups in [first_group, last_group),
+    // returns nullptr if the probe leaves the range.
+    //
+    JSTD_FORCED_INLINE
+    slot_type * find_empty_in_range(std::size_t key_hash, size_type first_group, size_type last_group) {
+        size_type group_index = this->index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
+        prober_type prober(group_index);
+
+        do {
+            group_index = prober.get();
+            if ((group_index < first_group) || (group_index >= last_group))
+                break;
+            group_type * group = this->groups() + group_index;
+            std::uint32_t empty_mask = group->match_empty();
+            if (JSTD_LIKELY(empty_mask != 0)) {
+                std::uint32_t empty_pos = BitUtils::bsf32(empty_mask);
+                group->set_used(empty_pos, ctrl_hash);
+                return (this->slots() + group_index * kGroupSize + empty_pos);
+            } else {
+                group->set_overflow(ctrl_hash);
+            }
+        } while (prober.next_bucket(this->group_mask()));
+
+        return nullptr;
+    }
+
+    JSTD_FORCED_INLINE
+    void transfer_slot(slot_type * new_slot, slot_type * old_slot) {
+        SlotPolicyTraits::transfer(&this->slot_allocator_, new_slot, old_slot);
     }
 
     JSTD_FORCED_INLINE
@@ -2345,6 +3215,7 @@ private:
                 const slot_type * slot = slot_base + empty_pos;
                 assert(group->is_empty(empty_pos));
                 group->set_used(empty_pos, ctrl_hash);
+                this->mark_dirty_group(group_index);
                 if (!IsNoCheck) {
 #if GROUP15_USE_NEW_OVERFLOW
                     // If any overflow bit is not 0, it means that the group was once full.
@@ -2392,6 +3263,12 @@ private:
     JSTD_FORCED_INLINE
     std::pair<locator_t, bool> find_or_insert(const KeyT & key) {
         std::size_t key_hash = this->hash_for(key);
+        return this->find_or_insert(key, key_hash);
+    }
+
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    std::pair<locator_t, bool> find_or_insert(const KeyT & key, std::size_t key_hash) {
         size_type group_index = this->index_for_hash(key_hash);
         std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
 
@@ -2426,6 +3303,35 @@ private:
         }
     }
 
+    //
+    // Reserve the room for the whole batch at once, so that the batch insert
+    // won't rehash repeatedly while the table is growing.
+    //
+    JSTD_FORCED_INLINE
+    void reserve_for_batch(size_type count) {
+        size_type new_size = this->size() + count;
+        if (JSTD_UNLIKELY(new_size > this->slot_threshold())) {
+            this->reserve(new_size);
+        }
+    }
+
+    //
+    // Hash the key and prefetch it's home group and slots for the coming insertion.
+    //
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    std::size_t prefetch_hash_for(const KeyT & key) const {
+        std::size_t key_hash = this->hash_for(key);
+        size_type group_index = this->index_for_hash(key_hash);
+        const group_type * group = this->groups() + group_index;
+        jstd::CPU_Prefetch_Write_T0((const void *)group);
+        const slot_type * slot_start = this->slots();
+        if (JSTD_LIKELY(slot_start != nullptr)) {
+            jstd::CPU_Prefetch_Write_T0((const void *)(slot_start + group_index * kGroupSize));
+        }
+        return key_hash;
+    }
+
     JSTD_FORCED_INLINE
     locator_t no_grow_unique_insert(const key_type & key) {
         std::size_t key_hash = this->hash_for(key);
@@ -2446,8 +3352,7 @@ private:
         slot_type * new_slot = locator.slot();
         assert(new_slot != nullptr);
 
-        SlotPolicyTraits::construct(&this->slot_allocator_, new_slot, old_slot);
-        this->destroy_slot(old_slot);
+        SlotPolicyTraits::transfer(&this->slot_allocator_, new_slot, old_slot);
         this->slot_size_++;
         assert(this->slot_size() <= this->slot_capacity());
     }
@@ -2504,6 +3409,39 @@ private:
         }
     }
 
+    //
+    // Update the mapped value of an existing key, only the maps do it (AlwaysUpdate),
+    // the sets have no mapped value.
+    //
+    template <typename ValueT>
+    JSTD_FORCED_INLINE
+    void copy_assign_mapped(slot_type * slot, const ValueT & value, std::true_type) {
+        SlotPolicyTraits::element(slot).second = value.second;
+    }
+
+    template <typename ValueT>
+    JSTD_FORCED_INLINE
+    void copy_assign_mapped(slot_type * slot, const ValueT & value, std::false_type) {
+        /* Do nothing */
+    }
+
+    template <bool IsRvalueRef, typename ValueT>
+    JSTD_FORCED_INLINE
+    void move_assign_mapped(slot_type * slot, ValueT & value, std::true_type) {
+        if (IsRvalueRef) {
+            //slot->value.second = std::move(value.second);
+            jstd::move_assign_if<IsRvalueRef>(SlotPolicyTraits::element(slot).second, value.second);
+        } else {
+            SlotPolicyTraits::element(slot).second = value.second;
+        }
+    }
+
+    template <bool IsRvalueRef, typename ValueT>
+    JSTD_FORCED_INLINE
+    void move_assign_mapped(slot_type * slot, ValueT & value, std::false_type) {
+        /* Do nothing */
+    }
+
     template <bool AlwaysUpdate, typename ValueT, typename std::enable_if<
               (jstd::is_same_ex<ValueT, value_type>::value ||
                std::is_constructible<value_type, const ValueT &>::value) ||
@@ -2511,7 +3449,7 @@ private:
                std::is_constructible<init_type, const ValueT &>::value)>::type * = nullptr>
     JSTD_FORCED_INLINE
     std::pair<iterator, bool> emplace_impl(const ValueT & value) {
-        auto find_info = this->find_or_insert(value.first);
+        auto find_info = this->find_or_insert(type_policy::extract(value));
         locator_t & locator = find_info.first;
         bool need_insert = find_info.second;        
         if (need_insert) {
@@ -2524,7 +3462,7 @@ private:
             // The key to be inserted already exists.
             if (AlwaysUpdate) {
                 slot_type * slot = locator.slot();
-                slot->value.second = value.second;
+                this->copy_assign_mapped(slot, value, std::integral_constant<bool, AlwaysUpdate>());
             }
         }
         return { locator, need_insert };
@@ -2538,7 +3476,7 @@ private:
     JSTD_FORCED_INLINE
     std::pair<iterator, bool> emplace_impl(ValueT && value) {
         static constexpr bool is_rvalue_ref = std::is_rvalue_reference<decltype(value)>::value;
-        auto find_info = this->find_or_insert(value.first);
+        auto find_info = this->find_or_insert(type_policy::extract(value));
         locator_t & locator = find_info.first;
         bool need_insert = find_info.second;
         if (need_insert) {
@@ -2546,21 +3484,13 @@ private:
             slot_type * slot = locator.slot();
             assert(slot != nullptr);
             assert(slot < this->last_slot());
-            SlotPolicyTraits::construct(&this->slot_allocator_, slot, std::move(value));
+            SlotPolicyTraits::construct(&this->slot_allocator_, slot, std::forward<ValueT>(value));
             this->slot_size_++;
         } else {
             // The key to be inserted already exists.
             if (AlwaysUpdate) {
                 slot_type * slot = locator.slot();
-                if (is_rvalue_ref) {
-                    //slot->value.second = std::move(value.second);
-                    if (kIsLayoutCompatible)
-                        jstd::move_assign_if<is_rvalue_ref>(slot->mutable_value.second, value.second);
-                    else
-                        jstd::move_assign_if<is_rvalue_ref>(slot->value.second, value.second);
-                } else {
-                    slot->value.second = value.second;
-                }
+                this->move_assign_mapped<is_rvalue_ref>(slot, value, std::integral_constant<bool, AlwaysUpdate>());
             }
         }
         return { locator, need_insert };
@@ -2596,10 +3526,10 @@ private:
             if (AlwaysUpdate) {
                 slot_type * slot = locator.slot();
                 if (isMappedType) {
-                    slot->value.second = std::forward<MappedT>(value);
+                    SlotPolicyTraits::element(slot).second = std::forward<MappedT>(value);
                 } else {
                     mapped_type mapped_value(std::forward<MappedT>(value));
-                    slot->value.second = std::move(mapped_value);
+                    SlotPolicyTraits::element(slot).second = std::move(mapped_value);
                 }
             }
         }
@@ -2635,7 +3565,7 @@ private:
             if (AlwaysUpdate) {
                 slot_type * slot = locator.slot();
                 mapped_type mapped_value(std::forward<Args>(args)...);
-                slot->value.second = std::move(mapped_value);
+                SlotPolicyTraits::element(slot).second = std::move(mapped_value);
             }
         }
         return { locator, need_insert };
@@ -2673,7 +3603,7 @@ private:
             if (AlwaysUpdate) {
                 jstd::tuple_wrapper2<mapped_type> mapped_wrapper(std::move(second));
                 slot_type * slot = locator.slot();
-                slot->value.second = std::move(mapped_wrapper.value());
+                SlotPolicyTraits::element(slot).second = std::move(mapped_wrapper.value());
             }
         }
         return { locator, need_insert };
@@ -2711,10 +3641,10 @@ private:
             // The key to be inserted already exists.
             if (AlwaysUpdate) {
                 slot_type * slot = locator.slot();
-                slot->value.second = std::move(tmp_slot->value.second);
+                SlotPolicyTraits::element(slot).second = std::move(SlotPolicyTraits::element(tmp_slot).second);
             }
+            SlotPolicyTraits::destroy(&this->slot_allocator_, tmp_slot);
         }
-        SlotPolicyTraits::destroy(&this->slot_allocator_, tmp_slot);
         return { locator, need_insert };
     }
 
@@ -2852,6 +3782,7 @@ private:
 #if GROUP15_USE_SEPARATE_SLOTS
         swap(this->groups_alloc_, other.groups_alloc_);
 #endif
+        swap(this->state_, other.state_);
     }
 
     JSTD_FORCED_INLINE
@@ -0,0 +1,84 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2024-2025 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+*************************************************************************************
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+  You are free to:
+
+    1. Share -- copy and redistribute the material in any medium or format.
+
+    2. Adapt -- remix, transforn, and build upon the material for any purpose,
+    even commerically.
+
+    The licensor cannot revoke these freedoms as long as you follow the license terms.
+
+  Under the following terms:
+
+    * Attribution -- You must give appropriate credit, provide a link to the license,
+    and indicate if changes were made. You may do so in any reasonable manner,
+    but not in any way that suggests the licensor endorses you or your use.
+
+    * ShareAlike -- If you remix, transform, or build upon the material, you must
+    distribute your contributions under the same license as the original.
+
+    * No additional restrictions -- You may not apply legal terms or technological
+    measures that legally restrict others from doing anything the license permits.
+
+  Notices:
+
+    * You do not have to comply with the license for elements of the material
+    in the public domain or where your use is permitted by an applicable exception
+    or limitation.
+
+    * No warranties are given. The license may not give you all of the permissions
+    necessary for your intended use. For example, other rights such as publicity,
+    privacy, or moral rights may limit how you use the material.
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_GROUP15_NODE_MAP_HPP
+#define JSTD_HASHMAP_GROUP15_NODE_MAP_HPP
+
+#pragma once
+
+#include <memory>               // For std::allocator<T>
+#include <functional>           // For std::hash<Key>
+#include <type_traits>
+#include <utility>              // For std::pair<F, S>
+
+#include "jstd/memory/pool_allocator.h"
+#include "jstd/hashmap/node_map_type_policy.hpp"
+#include "jstd/hashmap/group15_flat_map.hpp"
+
+namespace jstd {
+
+//
+// The same interface as group15_flat_map, but the slots only store the pointers of
+// the nodes, the nodes are allocated by Allocator (a pool by default). The references
+// and the pointers of the elements stay valid when the table grows, and the rehash
+// only moves the pointers, so the cost of it doesn't depend on the size of the values.
+//
+// save() and open_mapped() are not supported.
+//
+template <typename Key, typename Value,
+          typename Hash = std::hash< typename std::remove_const<Key>::type >,
+          typename KeyEqual = std::equal_to< typename std::remove_const<Key>::type >,
+          typename Allocator = jstd::pool_allocator< std::pair<const typename std::remove_const<Key>::type,
+                                                               typename std::remove_const<Value>::type> >,
+          typename TablePolicy = jstd::flat_table_policy<> >
+using group15_node_map = group15_flat_map<Key, Value, Hash, KeyEqual, Allocator,
+                                          jstd::node_map_type_policy<Key, Value>, TablePolicy>;
+
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_GROUP15_NODE_MAP_HPP
@@ -0,0 +1,563 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2024-2025 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+*************************************************************************************
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+  You are free to:
+
+    1. Share -- copy and redistribute the material in any medium or format.
+
+    2. Adapt -- remix, transforn, and build upon the material for any purpose,
+    even commerically.
+
+    The licensor cannot revoke these freedoms as long as you follow the license terms.
+
+  Under the following terms:
+
+    * Attribution -- You must give appropriate credit, provide a link to the license,
+    and indicate if changes were made. You may do so in any reasonable manner,
+    but not in any way that suggests the licensor endorses you or your use.
+
+    * ShareAlike -- If you remix, transform, or build upon the material, you must
+    distribute your contributions under the same license as the original.
+
+    * No additional restrictions -- You may not apply legal terms or technological
+    measures that legally restrict others from doing anything the license permits.
+
+  Notices:
+
+    * You do not have to comply with the license for elements of the material
+    in the public domain or where your use is permitted by an applicable exception
+    or limitation.
+
+    * No warranties are given. The license may not give you all of the permissions
+    necessary for your intended use. For example, other rights such as publicity,
+    privacy, or moral rights may limit how you use the material.
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_GROUP16_FLAT_SET_HPP
+#define JSTD_HASHMAP_GROUP16_FLAT_SET_HPP
+
+#pragma once
+
+#include <stdint.h>
+
+#include <cstdint>
+#include <memory>               // For std::allocator<T>
+#include <functional>           // For std::hash<Key>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>              // For std::pair<F, S>
+
+#include "jstd/hashmap/detail/hashmap_traits.h"
+#include "jstd/hashmap/flat_set_type_policy.hpp"
+#include "jstd/hashmap/flat_table_policy.hpp"
+#include "jstd/hashmap/group16_flat_table.hpp"
+
+namespace jstd {
+
+template <typename TypePolicy, typename Hash,
+          typename KeyEqual, typename Allocator,
+          typename TablePolicy>
+class group16_flat_table;
+
+//
+// The slots of the set only store the keys, the elements can't be modified,
+// so iterator and const_iterator are the same. TablePolicy enables the optional
+// modes of the table, see jstd::flat_table_policy.
+//
+template <typename Key,
+          typename Hash = std::hash< typename std::remove_const<Key>::type >,
+          typename KeyEqual = std::equal_to< typename std::remove_const<Key>::type >,
+          typename Allocator = std::allocator< typename std::remove_const<Key>::type >,
+          typename TablePolicy = jstd::flat_table_policy<> >
+class JSTD_DLL group16_flat_set
+{
+public:
+    typedef jstd::flat_set_type_policy<Key>     type_policy;
+    typedef TablePolicy                         table_policy;
+    typedef std::size_t                         size_type;
+    typedef std::intptr_t                       ssize_type;
+    typedef std::ptrdiff_t                      difference_type;
+
+    typedef typename type_policy::key_type      key_type;
+    typedef typename type_policy::value_type    value_type;
+    typedef typename type_policy::init_type     init_type;
+    typedef typename type_policy::element_type  element_type;
+    typedef Hash                                hasher;
+    typedef KeyEqual                            key_equal;
+    typedef Allocator                           allocator_type;
+
+    typedef value_type &                        reference;
+    typedef value_type const &                  const_reference;
+
+    typedef typename std::allocator_traits<allocator_type>::pointer         pointer;
+    typedef typename std::allocator_traits<allocator_type>::const_pointer   const_pointer;
+
+    typedef jstd::group16_flat_table<type_policy, Hash, KeyEqual,
+        typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>, table_policy>
+                                                table_type;
+
+    typedef typename table_type::ctrl_type      ctrl_type;
+    typedef typename table_type::slot_type      slot_type;
+
+    typedef typename table_type::const_iterator iterator;
+    typedef typename table_type::const_iterator const_iterator;
+
+    using this_type = jstd::group16_flat_set<Key, Hash, KeyEqual, Allocator, TablePolicy>;
+
+private:
+    table_type table_;
+
+public:
+    ///
+    /// Constructors
+    ///
+    group16_flat_set() : group16_flat_set(0) {}
+
+    explicit group16_flat_set(size_type capacity, hasher const & hash = hasher(),
+                              key_equal const & pred = key_equal(),
+                              allocator_type const & allocator = allocator_type())
+        : table_(capacity, hash, pred, allocator) {
+    }
+
+    group16_flat_set(size_type capacity, allocator_type const & allocator)
+        : group16_flat_set(capacity, hasher(), key_equal(), allocator) {
+    }
+
+    group16_flat_set(size_type capacity, hasher const & hash, allocator_type const & allocator)
+        : group16_flat_set(capacity, hash, key_equal(), allocator) {
+    }
+
+    template <typename InputIterator>
+    group16_flat_set(InputIterator first, InputIterator last, allocator_type const & allocator)
+        : group16_flat_set(first, last, size_type(0), hasher(), key_equal(), allocator) {
+    }
+
+    explicit group16_flat_set(allocator_type const & allocator)
+        : group16_flat_set(0, allocator) {
+    }
+
+    template <typename Iterator>
+    group16_flat_set(Iterator first, Iterator last, size_type capacity = 0,
+                     hasher const & hash = hasher(), key_equal const & pred = key_equal(),
+                     allocator_type const & allocator = allocator_type())
+        : group16_flat_set(capacity, hash, pred, allocator) {
+        this->insert(first, last);
+    }
+
+    template <typename Iterator>
+    group16_flat_set(Iterator first, Iterator last, size_type capacity, allocator_type const & allocator)
+        : group16_flat_set(first, last, capacity, hasher(), key_equal(), allocator) {
+    }
+
+    template <typename Iterator>
+    group16_flat_set(Iterator first, Iterator last, size_type capacity,
+                     hasher const & hash, allocator_type const & allocator)
+        : group16_flat_set(first, last, capacity, hash, key_equal(), allocator) {
+    }
+
+    group16_flat_set(group16_flat_set const & other) : table_(other.table_) {
+    }
+
+    group16_flat_set(group16_flat_set const & other, allocator_type const & allocator)
+        : table_(other.table_, allocator) {
+    }
+
+    group16_flat_set(group16_flat_set && other)
+        noexcept(std::is_nothrow_move_constructible<table_type>::value)
+        : table_(std::move(other.table_)) {
+    }
+
+    group16_flat_set(group16_flat_set && other, allocator_type const & allocator)
+        : table_(std::move(other.table_), allocator) {
+    }
+
+    group16_flat_set(std::initializer_list<value_type> ilist,
+                     size_type capacity = 0, hasher const & hash = hasher(),
+                     key_equal const & pred = key_equal(),
+                     allocator_type const & allocator = allocator_type())
+        : group16_flat_set(ilist.begin(), ilist.end(), capacity, hash, pred, allocator) {
+    }
+
+    group16_flat_set(std::initializer_list<value_type> ilist, allocator_type const & allocator)
+        : group16_flat_set(ilist, size_type(0), hasher(), key_equal(), allocator) {
+    }
+
+    group16_flat_set(std::initializer_list<value_type> init, size_type capacity,
+                     allocator_type const & allocator)
+        : group16_flat_set(init, capacity, hasher(), key_equal(), allocator) {
+    }
+
+    group16_flat_set(std::initializer_list<value_type> init, size_type capacity,
+                     hasher const & hash, allocator_type const & allocator)
+        : group16_flat_set(init, capacity, hash, key_equal(), allocator) {
+    }
+
+    ~group16_flat_set() = default;
+
+    group16_flat_set & operator = (group16_flat_set const & other) {
+        table_ = other.table_;
+        return *this;
+    }
+
+    group16_flat_set & operator = (group16_flat_set && other) noexcept(
+        noexcept(std::declval<table_type &>() = std::declval<table_type &&>())) {
+        table_ = std::move(other.table_);
+        return *this;
+    }
+
+    group16_flat_set & operator = (std::initializer_list<value_type> il) {
+        this->clear();
+        this->insert(il.begin(), il.end());
+        return *this;
+    }
+
+    ///
+    /// Observers
+    ///
+    allocator_type get_allocator() const noexcept {
+        return table_.get_allocator();
+    }
+
+    hasher hash_function() const noexcept {
+        return table_.hash_function();
+    }
+
+    key_equal key_eq() const noexcept {
+        return table_.key_eq();
+    }
+
+    static const char * name() noexcept {
+        return table_type::name();
+    }
+
+    ///
+    /// Iterators
+    ///
+    iterator begin() const noexcept { return table_.begin(); }
+    iterator end() const noexcept { return table_.end(); }
+
+    const_iterator cbegin() const noexcept { return table_.cbegin(); }
+    const_iterator cend() const noexcept { return table_.cend(); }
+
+    ///
+    /// Capacity
+    ///
+    bool empty() const noexcept { return table_.empty(); }
+    size_type size() const noexcept { return table_.size(); }
+    size_type capacity() const noexcept { return table_.capacity(); }
+    size_type max_size() const noexcept { return table_.max_size(); }
+
+    size_type slot_size() const noexcept { return table_.slot_size(); }
+    size_type slot_mask() const noexcept { return table_.slot_mask(); }
+    size_type slot_capacity() const noexcept { return table_.slot_capacity(); }
+    size_type slot_threshold() const noexcept { return table_.slot_threshold(); }
+
+    size_type group_mask() const noexcept { return table_.group_mask(); }
+    size_type group_capacity() const noexcept { return table_.group_capacity(); }
+
+    bool is_valid() const noexcept { return table_.is_valid(); }
+    bool is_empty() const noexcept { return table_.is_empty(); }
+
+    ///
+    /// Bucket interface
+    ///
+    size_type bucket_size(size_type n) const noexcept {
+        return table_.bucket_size(n);
+    }
+    size_type bucket_count() const noexcept {
+        return table_.bucket_count();
+    }
+    size_type max_bucket_count() const noexcept {
+        return table_.max_bucket_count();
+    }
+
+    size_type bucket(const key_type & key) const {
+        return table_.bucket(key);
+    }
+
+    ///
+    /// Hash policy
+    ///
+    float load_factor() const { return table_.load_factor(); }
+    float max_load_factor() const { return table_.max_load_factor(); }
+
+    void max_load_factor(float mlf) { table_.max_load_factor(mlf); }
+
+    ///
+    /// Hash policy
+    ///
+    void reserve(size_type new_capacity) {
+        table_.reserve(new_capacity);
+    }
+
+    void rehash(size_type new_capacity) {
+        table_.rehash(new_capacity);
+    }
+
+    // Reinsert the old elements by thread_count threads, 0 is hardware_concurrency().
+    void reserve(size_type new_capacity, size_type thread_count) {
+        table_.reserve(new_capacity, thread_count);
+    }
+
+    void rehash(size_type new_capacity, size_type thread_count) {
+        table_.rehash(new_capacity, thread_count);
+    }
+
+    void shrink_to_fit(bool read_only = false) {
+        table_.shrink_to_fit(read_only);
+    }
+
+    ///
+    /// Incremental rehash
+    ///
+    static constexpr bool incremental_rehash() noexcept {
+        return table_type::incremental_rehash();
+    }
+
+    bool is_migrating() const noexcept {
+        return table_.is_migrating();
+    }
+
+    void finish_migration() {
+        table_.finish_migration();
+    }
+
+    ///
+    /// Generation clear
+    ///
+    static constexpr bool generation_clear() noexcept {
+        return table_type::generation_clear();
+    }
+
+    bool has_stale_groups() const noexcept {
+        return table_.has_stale_groups();
+    }
+
+    ///
+    /// Overflow purge
+    ///
+    void purge_overflow() {
+        table_.purge_overflow();
+    }
+
+    ///
+    /// Snapshot
+    ///
+    bool save(const char * path) const {
+        return table_.save(path);
+    }
+
+    bool open_mapped(const char * path) {
+        return table_.open_mapped(path);
+    }
+
+    bool is_mapped() const noexcept {
+        return table_.is_mapped();
+    }
+
+    ///
+    /// Lookup
+    ///
+    size_type count(const key_type & key) const {
+        return table_.count(key);
+    }
+
+    bool contains(const key_type & key) const {
+        return table_.contains(key);
+    }
+
+    ///
+    /// find(key)
+    ///
+    JSTD_FORCED_INLINE
+    const_iterator find(const key_type & key) const {
+        return table_.find(key);
+    }
+
+    template <typename KeyT, typename std::enable_if<
+              (!jstd::is_same_ex<KeyT, key_type>::value) &&
+                std::is_constructible<key_type, const KeyT &>::value>::type * = nullptr>
+    JSTD_FORCED_INLINE
+    const_iterator find(const KeyT & key) const {
+        return table_.find(key);
+    }
+
+    ///
+    /// find_batch(keys, count, out_iters)
+    ///
+    template <typename KeyT>
+    void find_batch(const KeyT * keys, size_type count, const_iterator * out_iters) const {
+        table_.find_batch(keys, count, out_iters);
+    }
+
+    template <typename KeyT>
+    size_type contains_batch(const KeyT * keys, size_type count, bool * out_results) const {
+        return table_.contains_batch(keys, count, out_results);
+    }
+    ///
+    /// Modifiers
+    ///
+    JSTD_FORCED_INLINE
+    void clear(bool need_destroy = false) noexcept {
+        table_.clear(need_destroy);
+    }
+
+    ///
+    /// insert(value)
+    ///
+    JSTD_FORCED_INLINE
+    std::pair<iterator, bool> insert(const value_type & value) {
+        return table_.emplace(value);
+    }
+
+    JSTD_FORCED_INLINE
+    std::pair<iterator, bool> insert(value_type && value) {
+        return table_.emplace(std::move(value));
+    }
+
+    JSTD_FORCED_INLINE
+    iterator insert(const_iterator hint, const value_type & value) {
+        return table_.emplace(value).first;
+    }
+
+    JSTD_FORCED_INLINE
+    iterator insert(const_iterator hint, value_type && value) {
+        return table_.emplace(std::move(value)).first;
+    }
+
+    template <typename InputIter>
+    JSTD_FORCED_INLINE
+    void insert(InputIter first, InputIter last) {
+        for (InputIter pos = first; pos != last; ++pos) {
+            table_.emplace(*pos);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> ilist) {
+        this->insert(ilist.begin(), ilist.end());
+    }
+    template <typename InputIter>
+    void build_from(InputIter first, InputIter last, size_type thread_count = 0) {
+        table_.build_from(first, last, thread_count);
+    }
+
+    ///
+    /// emplace(args...)
+    ///
+    template <typename ... Args>
+    JSTD_FORCED_INLINE
+    std::pair<iterator, bool> emplace(Args && ... args) {
+        return table_.emplace(value_type(std::forward<Args>(args)...));
+    }
+
+    template <typename ... Args>
+    JSTD_FORCED_INLINE
+    iterator emplace_hint(const_iterator hint, Args && ... args) {
+        return table_.emplace(value_type(std::forward<Args>(args)...)).first;
+    }
+
+    ///
+    /// erase(key)
+    ///
+    JSTD_FORCED_INLINE
+    size_type erase(const key_type & key) {
+        return table_.erase(key);
+    }
+
+    JSTD_FORCED_INLINE
+    iterator erase(const_iterator pos) {
+        return table_.erase(pos);
+    }
+
+    JSTD_FORCED_INLINE
+    iterator erase(const_iterator first, const_iterator last) {
+        for (const_iterator iter = first; iter != last; ++iter) {
+            table_.erase(iter);
+        }
+        return last;
+    }
+
+    template <typename InputIter, typename std::enable_if<
+              !jstd::is_same_ex<InputIter, const_iterator>::value>::type * = nullptr>
+    JSTD_FORCED_INLINE
+    size_type erase(InputIter first, InputIter last) {
+        size_type num_deleted = 0;
+        for (InputIter iter = first; iter != last; ++iter) {
+            num_deleted += static_cast<size_type>(this->erase(*iter));
+        }
+        return num_deleted;
+    }
+
+    JSTD_FORCED_INLINE
+    void swap(this_type & other) noexcept(
+        noexcept(std::declval<table_type &>().swap(std::declval<table_type &>()))) {
+        table_.swap(other.table_);
+    }
+
+    JSTD_FORCED_INLINE
+    friend void swap(this_type & lhs, this_type & rhs)
+        noexcept(noexcept(lhs.swap(rhs))) {
+        lhs.swap(rhs);
+    }
+};
+
+template <typename Key, typename Hash, typename KeyEqual, typename Alloc, typename TablePolicy>
+inline
+void swap(group16_flat_set<Key, Hash, KeyEqual, Alloc, TablePolicy> & lhs,
+          group16_flat_set<Key, Hash, KeyEqual, Alloc, TablePolicy> & rhs)
+          noexcept(noexcept(lhs.swap(rhs)))
+{
+    lhs.swap(rhs);
+}
+
+} // namespace jstd
+
+///////////////////////////////////////////////////////////
+// std extensions: std::erase_if()
+///////////////////////////////////////////////////////////
+
+namespace std {
+
+template <typename Key, typename Hash, typename KeyEqual, typename Alloc, typename TablePolicy>
+inline
+void swap(jstd::group16_flat_set<Key, Hash, KeyEqual, Alloc, TablePolicy> & lhs,
+          jstd::group16_flat_set<Key, Hash, KeyEqual, Alloc, TablePolicy> & rhs)
+          noexcept(noexcept(lhs.swap(rhs)))
+{
+    lhs.swap(rhs);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Alloc, typename TablePolicy, typename Pred>
+typename jstd::group16_flat_set<Key, Hash, KeyEqual, Alloc, TablePolicy>::size_type
+inline
+erase_if(jstd::group16_flat_set<Key, Hash, KeyEqual, Alloc, TablePolicy> & hash_set, Pred pred)
+{
+    auto old_size = hash_set.size();
+
+    auto first = hash_set.begin();
+    auto last = hash_set.end();
+    for (auto iter = first; iter != last; ++iter) {
+        if (pred(*iter)) {
+            hash_set.erase(iter);
+        }
+    }
+
+    return (old_size - hash_set.size());
+}
+
+} // namespace std
+
+#endif // JSTD_HASHMAP_GROUP16_FLAT_SET_HPP
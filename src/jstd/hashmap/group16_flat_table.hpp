@@ -63,6 +63,9 @@
 #include <type_traits>
 #include <algorithm>        // For std::max()
 #include <utility>          // For std::pair<F, S>
+#include <iterator>         // For std::iterator_traits<T>
+#include <vector>
+#include <exception>        // For std::exception_ptr
 
 #include <assert.h>
 
@@ -75,14 +78,18 @@
 #include "jstd/traits/type_traits.h"    // For jstd::narrow_cast<T>()
 #include "jstd/hasher/hashes.h"
 #include "jstd/utility/utility.h"
+#include "jstd/memory/released_array.h"
 
 #include "jstd/hashmap/flat_map_iterator.hpp"
 #include "jstd/hashmap/flat_map_group16.hpp"
 #include "jstd/hashmap/group_quadratic_prober.hpp"
 
 #include "jstd/hashmap/detail/hashmap_traits.h"
+#include "jstd/hashmap/detail/parallel_run.h"
+#include "jstd/hashmap/detail/flat_snapshot.h"
 
 #include "jstd/hashmap/flat_map_type_policy.hpp"
+#include "jstd/hashmap/flat_table_policy.hpp"
 #include "jstd/hashmap/flat_map_slot_policy.hpp"
 #include "jstd/hashmap/slot_policy_traits.h"
 
@@ -94,6 +101,19 @@
 
 #define GROUP16_USE_NEW_OVERFLOW    1
 
+// Keep a dense copy of the small keys beside the groups when the mapped type is large,
+// it costs sizeof(key_type) more bytes per slot, so it's off by default.
+#ifndef GROUP16_USE_KEY_ARRAY
+#define GROUP16_USE_KEY_ARRAY       0
+#endif
+
+// Keep the hash codes beside the groups when the keys are expensive to hash and compare
+// (eg. std::string), the rehash reuses them, and the probes compare them before the keys.
+// It costs sizeof(std::size_t) more bytes per slot and changes the layout, so it's off by default.
+#ifndef GROUP16_USE_HASH_ARRAY
+#define GROUP16_USE_HASH_ARRAY      0
+#endif
+
 #ifdef _DEBUG
 #define GROUP16_DISPLAY_DEBUG_INFO  0
 #endif
@@ -101,11 +121,13 @@
 namespace jstd {
 
 template <typename TypePolicy, typename Hash,
-          typename KeyEqual, typename Allocator>
+          typename KeyEqual, typename Allocator,
+          typename TablePolicy = jstd::flat_table_policy<>>
 class JSTD_DLL group16_flat_table
 {
 public:
     typedef TypePolicy                          type_policy;
+    typedef TablePolicy                         table_policy;
     typedef std::size_t                         size_type;
     typedef std::intptr_t                       ssize_type;
     typedef std::ptrdiff_t                      difference_type;
@@ -124,10 +146,13 @@ public:
     typedef value_type &                        reference;
     typedef value_type const &                  const_reference;
 
+    // For the sets, init_type is the same as value_type.
+    typedef jstd::detail::init_arg_type<value_type, init_type>  init_arg_type;
+
     typedef typename std::allocator_traits<allocator_type>::pointer         pointer;
     typedef typename std::allocator_traits<allocator_type>::const_pointer   const_pointer;
 
-    using this_type = jstd::group16_flat_table<TypePolicy, Hash, KeyEqual, Allocator>;
+    using this_type = jstd::group16_flat_table<TypePolicy, Hash, KeyEqual, Allocator, TablePolicy>;
 
     static constexpr bool kUseIndexSalt = false;
     static constexpr bool kEnableExchange = true;
@@ -162,19 +187,37 @@ public:
     static constexpr bool kIsMoveAssignKey    = std::is_move_assignable<key_type>::value;
     static constexpr bool kIsMoveAssignMapped = std::is_move_assignable<mapped_type>::value;
 
-    static constexpr bool is_slot_trivial_copyable =
+    // The slots only hold the pointers of the nodes, see node_map_slot_policy.
+    static constexpr bool kIsNodeBased =
+            jstd::slot_policy_traits<typename type_policy::slot_policy>::node_based::value;
+
+    static constexpr bool is_slot_trivial_copyable = !kIsNodeBased &&
             (std::is_trivially_copyable<value_type>::value ||
             (std::is_trivially_copyable<key_type>::value &&
              std::is_trivially_copyable<mapped_type>::value) ||
             (std::is_scalar<key_type>::value && std::is_scalar<mapped_type>::value));
 
-    static constexpr bool is_slot_trivial_destructor =
+    static constexpr bool is_slot_trivial_destructor = !kIsNodeBased &&
             (std::is_trivially_destructible<value_type>::value ||
             (std::is_trivially_destructible<key_type>::value &&
              std::is_trivially_destructible<mapped_type>::value) ||
             (jstd::is_plain_type<key_type>::value &&
              jstd::is_plain_type<mapped_type>::value));
 
+    // The slots can be moved to the new place by memcpy, and the old ones are not destroyed.
+    static constexpr bool kIsRelocatableSlot = !kIsNodeBased &&
+            (std::is_trivially_copy_constructible<element_type>::value ||
+             jstd::is_trivially_relocatable<element_type>::value) &&
+            (jstd::is_std_allocator<Allocator>::value ||
+            !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value);
+
+    // The slots are transferred without any exception, the parallel rehash relies on it.
+    static constexpr bool kIsNothrowTransfer = kIsRelocatableSlot || kIsNodeBased ||
+            (std::is_nothrow_move_constructible<typename std::conditional<kIsLayoutCompatible,
+                                                std::pair<key_type, mapped_type>, value_type>::type>::value &&
+            (jstd::is_std_allocator<Allocator>::value ||
+            !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value));
+
     static constexpr size_type kWordLength = sizeof(std::size_t) * CHAR_BIT;
     static constexpr size_type kSizeTypeLength = sizeof(std::size_t);
 
@@ -194,10 +237,12 @@ public:
     static constexpr bool kIsIndirectKey = false;
     static constexpr bool kIsIndirectValue = false;
     static constexpr bool kIsIndirectKV = kIsIndirectKey | kIsIndirectValue;
-    static constexpr bool kNeedStoreHash = true;
+    static constexpr bool kDetectStoreHash = !(jstd::is_plain_type<key_type>::value ||
+                                               (sizeof(key_type) <= kSizeTypeLength * 2));
+    static constexpr bool kNeedStoreHash = (GROUP16_USE_HASH_ARRAY != 0) && kDetectStoreHash;
 
-    using slot_type = jstd::map_slot_type<key_type, mapped_type>;
-    using slot_policy_t = jstd::flat_map_slot_policy<slot_type>;
+    using slot_type = typename type_policy::slot_type;
+    using slot_policy_t = typename type_policy::slot_policy;
     using SlotPolicyTraits = jstd::slot_policy_traits<slot_policy_t>;
 
     //using slot_type = flat_map_slot_storage<type_policy, kIsIndirectKey, kIsIndirectValue>;
@@ -212,6 +257,19 @@ public:
                                                  kSlotAlignment_ :
                                                  compile_time::round_up_pow2<kSlotAlignment_>::value;
 
+    //
+    // The probes compare the keys in a dense key array (placed right after the groups),
+    // instead of the keys in the slots, and only touch the slot on a hit. The slots still
+    // hold the whole value_type, so the iterators and references are unchanged.
+    //
+    static constexpr bool kUseKeyArray = (GROUP16_USE_KEY_ARRAY != 0) &&
+                                         std::is_trivially_copyable<key_type>::value &&
+                                         (alignof(key_type) <= kGroupAlignment) &&
+                                         kIsSmallKeyType && !kIsSmallValueType;
+    static constexpr size_type kKeyArrayBytes = kUseKeyArray ? (sizeof(key_type) * kGroupWidth) : 0;
+    // The hash array is placed right after the key array.
+    static constexpr size_type kHashArrayBytes = kNeedStoreHash ? (sizeof(std::size_t) * kGroupWidth) : 0;
+
     using iterator       = jstd::flat_map_iterator<this_type, value_type, kIsIndirectKV>;
     using const_iterator = jstd::flat_map_iterator<this_type, const value_type, kIsIndirectKV>;
 
@@ -233,6 +291,27 @@ public:
 
     static constexpr size_type kSkipGroupsLimit = 5;
 
+    // The number of keys hashed and prefetched ahead in find_batch().
+    static constexpr size_type kBatchPrefetchSize = 16;
+
+    // The parallel rehash is only used when the old table has at least so many elements.
+    static constexpr size_type kMinParallelRehashSize = 65536;
+
+    // In the incremental rehash mode, the number of old groups migrated by each insert, find or erase.
+    static constexpr size_type kMigrateGroupsPerStep = 4;
+    // The smaller table is always rehashed at once.
+    static constexpr size_type kMinIncrementalRehashSize = 4096;
+    static constexpr bool kSupportIncrementalRehash = (GROUP16_USE_HASH_POLICY == 0);
+    static constexpr bool kIncrementalRehash = kSupportIncrementalRehash && table_policy::incremental_rehash;
+    // The stale slots are dropped without calling the destructors.
+    static constexpr bool kSupportGenerationClear = is_slot_trivial_destructor && !kIsIndirectKV;
+    static constexpr bool kGenerationClear = kSupportGenerationClear && table_policy::generation_clear;
+    // save() writes any table, but only open_mapped() needs the member of the mapped file.
+    static constexpr bool kSnapshot = table_policy::snapshot;
+    static constexpr bool kReleasePages = table_policy::release_pages;
+    // A grow purges the overflow bits instead, if the erases have taken 1/8 of the threshold.
+    static constexpr size_type kPurgeOverflowRatio = 8;
+
     using group_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<group_type>;
     using slot_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<slot_type>;
 
@@ -244,6 +323,76 @@ public:
     using hash_policy_t = typename jstd::hash_policy_selector<Hash>::type;
 
 private:
+    //
+    // The old arrays in the incremental rehash, the groups in [0, migrate_index)
+    // have been migrated to the new arrays.
+    //
+    struct old_table_type {
+        group_type *    groups;
+        slot_type *     slots;
+        size_type       slot_size;
+        size_type       slot_mask;
+        size_type       group_mask;
+        size_type       index_shift;
+        size_type       migrate_index;
+        group_type *    groups_alloc;
+
+        old_table_type() noexcept
+            : groups(nullptr), slots(nullptr), slot_size(0), slot_mask(0),
+              group_mask(0), index_shift(0), migrate_index(0), groups_alloc(nullptr) {}
+    };
+
+    //
+    // The members of the modes enabled by TablePolicy, see jstd::flat_table_policy.
+    //
+    struct incremental_rehash_state : public jstd::detail::empty_table_state {
+        old_table_type  old_;
+    };
+
+    using incremental_state_t = typename std::conditional<kIncrementalRehash, incremental_rehash_state,
+                                                          jstd::detail::empty_table_state>::type;
+
+    //
+    // The generation each group was last reset in, see clear_generation().
+    //
+    struct generation_clear_state : public incremental_state_t {
+        bool            has_stale_groups_;
+        std::uint8_t    generation_;
+        std::vector<std::uint8_t> group_epochs_;
+
+        generation_clear_state() : has_stale_groups_(false), generation_(0), group_epochs_() {}
+    };
+
+    using generation_state_t = typename std::conditional<kGenerationClear, generation_clear_state,
+                                                         incremental_state_t>::type;
+
+    //
+    // The snapshot file which the arrays are mapped from, see open_mapped().
+    //
+    struct snapshot_state : public generation_state_t {
+        jstd::mapped_file   mapped_;
+    };
+
+    using snapshot_state_t = typename std::conditional<kSnapshot, snapshot_state,
+                                                       generation_state_t>::type;
+
+    //
+    // The slot array given up by clear(true) or a shrink, see jstd::detail::released_array.
+    //
+    struct release_pages_state : public snapshot_state_t {
+        jstd::detail::released_array<slot_type> released_slots_;
+    };
+
+    using release_pages_state_t = typename std::conditional<kReleasePages, release_pages_state,
+                                                            snapshot_state_t>::type;
+
+    using table_state = release_pages_state_t;
+
+    using incremental_rehash_t = std::integral_constant<bool, kIncrementalRehash>;
+    using generation_clear_t = std::integral_constant<bool, kGenerationClear>;
+    using snapshot_t = std::integral_constant<bool, kSnapshot>;
+    using release_pages_t = std::integral_constant<bool, kReleasePages>;
+
     group_type *    groups_;
     slot_type *     slots_;
     size_type       slot_size_;
@@ -268,6 +417,8 @@ private:
     group_allocator_type    group_allocator_;
     slot_allocator_type     slot_allocator_;
 
+    table_state             state_;
+
     static constexpr bool kIsKeyExists = false;
     static constexpr bool kNeedInsert = true;
 
@@ -293,7 +444,8 @@ public:
           hash_policy_(),
 #endif
           hasher_(hash), key_equal_(pred),
-          allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator)
+          allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator),
+          state_()
     {
         if (capacity != 0) {
             this->reserve_for_insert(capacity);
@@ -322,7 +474,8 @@ public:
         hash_policy_(),
 #endif
         hasher_(other.hash_function_ref()), key_equal_(other.key_eq_ref()),
-        allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator)
+        allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator),
+        state_()
     {
         // Prepare enough space to ensure that no expansion is required during the insertion process.
         size_type other_size = other.size();
@@ -355,8 +508,9 @@ public:
         hasher_(std::move(other.hash_function_ref())),
         key_equal_(std::move(other.key_eq_ref())),
         allocator_(std::move(other.get_allocator_ref())),
-        group_allocator_(std::move(other.get_ctrl_allocator_ref())),
-        slot_allocator_(std::move(other.get_slot_allocator_ref())) {
+        group_allocator_(std::move(other.get_group_allocator_ref())),
+        slot_allocator_(std::move(other.get_slot_allocator_ref())),
+        state_(jstd::exchange(other.state_, table_state())) {
     }
 
     group16_flat_table(group16_flat_table && other, allocator_type const & allocator) :
@@ -377,7 +531,8 @@ public:
 #endif
         hasher_(std::move(other.hash_function_ref())),
         key_equal_(std::move(other.key_eq_ref())),
-        allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator) {
+        allocator_(allocator), group_allocator_(allocator), slot_allocator_(allocator),
+        state_() {
         if (this->get_allocator_ref() == other.get_allocator_ref()) {
             // Swap content only
             this->swap_content(other);
@@ -396,6 +551,7 @@ public:
 
     ~group16_flat_table() {
         this->destroy<true>();
+        this->deallocate_released_slots();
     }
 
     group16_flat_table & operator = (const group16_flat_table & other) {
@@ -491,15 +647,14 @@ public:
     }
 
     static const char * name() noexcept {
-        return "jstd::group16_flat_map";
+        return (kIsNodeBased ? "jstd::group16_node_map" : "jstd::group16_flat_map");
     }
 
     ///
     /// Iterators
     ///
     iterator begin() noexcept {
-        size_type slot_index = this->find_first_used_index();
-        return this->iterator_at(slot_index);
+        return this->iterator_at(this->begin_index());
     }
 
     iterator end() noexcept {
@@ -507,10 +662,10 @@ public:
     }
 
     const_iterator begin() const noexcept {
-        return const_cast<this_type *>(this)->begin();
+        return this->iterator_at(this->begin_index());
     }
     const_iterator end() const noexcept {
-        return const_cast<this_type *>(this)->end();
+        return this->iterator_at(this->slot_capacity());
     }
 
     const_iterator cbegin() const noexcept { return this->begin(); }
@@ -703,6 +858,30 @@ public:
         }
     }
 
+    //
+    // Same as reserve() and rehash(), but the old slots are reinserted by
+    // thread_count threads, thread_count = 0 means std::thread::hardware_concurrency().
+    // It's used to cut the pause of growing a very large table.
+    //
+    void reserve(size_type new_capacity, size_type thread_count) {
+        if (JSTD_LIKELY(new_capacity != 0)) {
+            new_capacity = this->shrink_to_fit_capacity(new_capacity);
+            this->rehash_impl<false>(new_capacity, thread_count);
+        } else {
+            this->destroy<true>();
+        }
+    }
+
+    void rehash(size_type new_capacity, size_type thread_count) {
+        size_type fit_to_now = this->shrink_to_fit_capacity(this->size());
+        new_capacity = (std::max)(fit_to_now, new_capacity);
+        if (JSTD_LIKELY(new_capacity != 0)) {
+            this->rehash_impl<true>(new_capacity, thread_count);
+        } else {
+            this->destroy<true>();
+        }
+    }
+
     JSTD_FORCED_INLINE
     void shrink_to_fit(bool read_only = false) {
         size_type new_capacity;
@@ -713,8 +892,220 @@ public:
         if (JSTD_LIKELY(new_capacity != 0)) {
             this->rehash_impl<true>(new_capacity);
         } else {
+            this->destroy<true, true>();
+        }
+    }
+
+    ///
+    /// Incremental rehash
+    ///
+    /// When TablePolicy enables it, a grow only allocates the new arrays, and then each insert,
+    /// find or erase migrates kMigrateGroupsPerStep old groups, the lookups consult
+    /// both arrays until the migration is finished. So the worst-case cost of an insert
+    /// is bounded, instead of a whole rehash_impl().
+    ///
+    /// reserve() and rehash() finish the pending migration first. The const lookups,
+    /// the iterators and copying read the both arrays, they never migrate.
+    ///
+    static constexpr bool incremental_rehash() noexcept {
+        return kIncrementalRehash;
+    }
+
+    bool is_migrating() const noexcept {
+        return this->is_migrating(incremental_rehash_t{});
+    }
+
+    void finish_migration() {
+        this->finish_migration(incremental_rehash_t{});
+    }
+
+    ///
+    /// Generation clear
+    ///
+    /// When TablePolicy enables it, clear() only bumps the generation of the table, instead of
+    /// resetting all the groups. Each group carries the generation it was last reset in,
+    /// the groups of an older generation are read as empty, and are reset by the first
+    /// insert that touches them. The iterators and copying skip the stale groups, the rehash
+    /// resets all of them first. Only for the trivially destructible slots.
+    ///
+    static constexpr bool generation_clear() noexcept {
+        return kGenerationClear;
+    }
+
+    bool has_stale_groups() const noexcept {
+        return this->has_stale_groups(generation_clear_t{});
+    }
+
+    void reset_stale_groups() {
+        this->reset_stale_groups(generation_clear_t{});
+    }
+
+    ///
+    /// Overflow purge
+    ///
+    /// An erase leaves the overflow bits of the groups behind, and lowers the slot
+    /// threshold if it leaves a deleted slot in an overflowed group. So a table with
+    /// a constant insert and erase churn keeps growing, even if it's size doesn't.
+    /// purge_overflow() moves the elements back to the first empty slots on their
+    /// probe sequences, recomputes the overflow bits and resets the threshold, all in
+    /// place, without allocating the new arrays. A grow does it instead when the erases
+    /// have taken 1/kPurgeOverflowRatio of the threshold.
+    ///
+    void purge_overflow() {
+        if (JSTD_UNLIKELY(this->slots_ == nullptr))
+            return;
+        this->finish_migration();
+        this->reset_stale_groups();
+
+        group_type * groups = this->groups();
+        size_type group_capacity = this->group_capacity();
+        for (size_type group_index = 0; group_index < group_capacity; group_index++) {
+            groups[group_index].clear_overflow();
+        }
+
+        auto mask_bits = group_type::make_mask_bits();
+        for (size_type group_index = 0; group_index < group_capacity; group_index++) {
+            std::uint32_t used_mask = groups[group_index].match_used(mask_bits);
+            while (used_mask != 0) {
+                std::uint32_t used_pos = BitUtils::bsf32(used_mask);
+                used_mask = BitUtils::clearLowBit32(used_mask);
+                size_type slot_index = group_index * kGroupWidth + used_pos;
+                const key_type & key = this->key_at(slot_index);
+                std::size_t key_hash = this->stored_hash_for(groups, group_capacity, slot_index, key);
+                std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
+                // Move it to the first group which has an empty slot on it's probe sequence,
+                // and set the overflow bit of the groups it skips.
+                prober_type prober(this->index_for_hash(key_hash));
+                while (prober.get() != group_index) {
+                    group_type * group = groups + prober.get();
+                    std::uint32_t empty_mask = group->match_empty(mask_bits);
+                    if (empty_mask != 0) {
+                        std::uint32_t empty_pos = BitUtils::bsf32(empty_mask);
+                        size_type new_slot_index = prober.get() * kGroupWidth + empty_pos;
+                        group->set_used(empty_pos, ctrl_hash);
+                        this->store_key(new_slot_index, key);
+                        this->store_hash(new_slot_index, key_hash);
+                        this->transfer_slot(new_slot_index, this->slot_at(slot_index));
+                        groups[group_index].set_empty(used_pos);
+                        break;
+                    }
+                    group->set_overflow(ctrl_hash);
+                    if (!prober.next_bucket(this->group_mask()))
+                        break;
+                }
+            }
+        }
+
+        // The empty slots in the overflowed groups are the deleted slots.
+        size_type deleted_slots = 0;
+        for (size_type group_index = 0; group_index < group_capacity; group_index++) {
+            const group_type * group = groups + group_index;
+            if (group->match_overflow() != 0) {
+                deleted_slots += BitUtils::popcnt32(group->match_empty(mask_bits));
+            }
+        }
+        size_type slot_threshold = this->calc_slot_threshold(this->slot_capacity());
+        slot_threshold = (slot_threshold > deleted_slots) ? (slot_threshold - deleted_slots) : 0;
+        this->slot_threshold_ = (std::max)(slot_threshold, this->slot_size());
+    }
+
+    ///
+    /// Snapshot
+    ///
+    /// save() writes the groups and slots arrays as they are, open_mapped() maps
+    /// a saved file and serves the lookups from the mapped pages directly,
+    /// without any deserialization. The pages are copy-on-write, so the mapped table
+    /// can still be modified, a grow moves it into the allocated arrays.
+    ///
+    /// Only for the trivially copyable slots, and the hasher must be the same one
+    /// (including it's seed) as the table was saved with. open_mapped() needs
+    /// the Snapshot mode of TablePolicy, any table can save().
+    ///
+    bool save(const char * path) const {
+        static_assert(is_slot_trivial_copyable,
+                      "jstd::group16_flat_table::save(): the slot must be trivially copyable.");
+        // The elements in migration are still in the old arrays, and the stale groups
+        // must not be saved, so save a settled copy of the table instead.
+        if (JSTD_UNLIKELY(this->is_migrating() || this->has_stale_groups())) {
+            this_type settled(*this);
+            return settled.save(path);
+        }
+
+        jstd::detail::flat_snapshot_header header;
+        size_type group_capacity = (this->slot_capacity() != 0) ? this->group_capacity() : 0;
+        jstd::detail::init_snapshot_header(header, this_type::snapshot_layout(),
+                                           group_capacity, this->slot_capacity());
+        header.slot_size = this->slot_size();
+        header.slot_threshold = this->slot_threshold();
+        header.max_load_factor = this->mlf_;
+        if (this->slot_size() != 0) {
+            const_iterator iter = this->cbegin();
+            size_type check_index = this->index_of(iter);
+            header.check_index = check_index;
+            header.hash_check = this->hash_for(this->slot_at(check_index)->get_key());
+        }
+        return jstd::detail::write_snapshot_file(path, header, this->groups(), this->slots());
+    }
+
+    bool open_mapped(const char * path) {
+        static_assert(is_slot_trivial_copyable,
+                      "jstd::group16_flat_table::open_mapped(): the slot must be trivially copyable.");
+        static_assert(kSnapshot,
+                      "jstd::group16_flat_table::open_mapped(): TablePolicy must enable the snapshot.");
+        jstd::mapped_file file;
+        if (!file.open(path))
+            return false;
+
+        const jstd::detail::flat_snapshot_header * header =
+            jstd::detail::check_snapshot_header(file, this_type::snapshot_layout());
+        if (header == nullptr)
+            return false;
+
+        size_type new_capacity = static_cast<size_type>(header->slot_capacity);
+        if (new_capacity == 0) {
             this->destroy<true>();
+            return true;
         }
+        if (!this->is_valid_capacity(new_capacity) ||
+            (header->group_capacity != new_capacity / kGroupWidth) ||
+            (header->slot_threshold > new_capacity))
+            return false;
+
+        group_type * new_groups = reinterpret_cast<group_type *>(file.data() + header->groups_offset);
+        slot_type * new_slots = reinterpret_cast<slot_type *>(file.data() + header->slots_offset);
+        if (header->slot_size != 0) {
+            size_type check_index = static_cast<size_type>(header->check_index);
+            if ((check_index >= new_capacity) ||
+                !reinterpret_cast<ctrl_type *>(new_groups)[check_index].is_used() ||
+                (this->hash_for(new_slots[check_index].get_key()) != header->hash_check))
+                return false;
+        }
+
+        this->destroy<true>();
+
+#if GROUP16_USE_HASH_POLICY
+        auto hash_policy_setting = this->hash_policy_.calc_next_capacity(new_capacity);
+        this->hash_policy_.commit(hash_policy_setting);
+#endif
+        this->groups_ = new_groups;
+        this->slots_ = new_slots;
+        this->slot_size_ = static_cast<size_type>(header->slot_size);
+        this->slot_mask_ = new_capacity - 1;
+        this->slot_threshold_ = static_cast<size_type>(header->slot_threshold);
+        this->group_mask_ = this_type::calc_group_mask(new_capacity);
+#if GROUP16_USE_INDEX_SHIFT
+        this->index_shift_ = this_type::calc_index_shift(new_capacity);
+#endif
+        this->mlf_ = static_cast<size_type>(header->max_load_factor);
+#if GROUP16_USE_SEPARATE_SLOTS
+        this->groups_alloc_ = nullptr;
+#endif
+        this->state_.mapped_.swap(file);
+        return true;
+    }
+
+    bool is_mapped() const noexcept {
+        return this->is_mapped(snapshot_t{});
     }
 
     ///
@@ -722,14 +1113,17 @@ public:
     ///
     JSTD_FORCED_INLINE
     size_type count(const key_type & key) const {
-        size_type slot_index = this->find_index(key);
-        return (slot_index != this->slot_capacity()) ? 1 : 0;
+        return (this->contains(key) ? 1 : 0);
     }
 
     JSTD_FORCED_INLINE
     bool contains(const key_type & key) const {
         size_type slot_index = this->find_index(key);
-        return (slot_index != this->slot_capacity());
+        if (JSTD_LIKELY(slot_index != this->slot_capacity()))
+            return true;
+        if (JSTD_LIKELY(!this->is_migrating()))
+            return false;
+        return (this->find_in_old_table(key, this->hash_for(key)) != nullptr);
     }
 
     ///
@@ -737,13 +1131,26 @@ public:
     ///
     JSTD_FORCED_INLINE
     iterator find(const key_type & key) {
+        if (JSTD_UNLIKELY(this->is_migrating())) {
+            return make_iterator(this->find_index_migrating(key));
+        }
         size_type slot_index = this->find_index(key);
         return make_iterator(slot_index);
     }
 
+    //
+    // The const find() doesn't migrate, a hit in the old arrays has a negative index.
+    //
     JSTD_FORCED_INLINE
     const_iterator find(const key_type & key) const {
-        return const_cast<this_type *>(this)->find(key);
+        size_type slot_index = this->find_index(key);
+        if (JSTD_UNLIKELY((slot_index == this->slot_capacity()) && this->is_migrating())) {
+            const slot_type * old_slot = this->find_in_old_table(key, this->hash_for(key));
+            if (old_slot != nullptr) {
+                slot_index = static_cast<size_type>(this->old_index_of(old_slot));
+            }
+        }
+        return this->iterator_at(slot_index);
     }
 
     template <typename KeyT, typename std::enable_if<
@@ -752,27 +1159,86 @@ public:
     JSTD_FORCED_INLINE
     iterator find(const KeyT & key_t) {
         key_type key(key_t);
-        size_type slot_index = this->find_index(key);
-        return make_iterator(slot_index);
+        return this->find(key);
     }
 
     template <typename KeyT, typename std::enable_if<
               (!jstd::is_same_ex<KeyT, key_type>::value) &&
                 std::is_constructible<key_type, const KeyT &>::value>::type * = nullptr>
     JSTD_FORCED_INLINE
-    const_iterator find(const KeyT & key) const {
-        return const_cast<this_type *>(this)->find(key);
+    const_iterator find(const KeyT & key_t) const {
+        key_type key(key_t);
+        return this->find(key);
+    }
+
+    ///
+    /// find_batch(keys, count, out_iters)
+    ///
+    template <typename KeyT>
+    void find_batch(const KeyT * keys, size_type count, iterator * out_iters) {
+        size_type slot_indexs[kBatchPrefetchSize];
+        for (size_type offset = 0; offset < count; offset += kBatchPrefetchSize) {
+            size_type batch_size = (std::min)(count - offset, kBatchPrefetchSize);
+            this->find_index_batch(keys + offset, batch_size, slot_indexs);
+            for (size_type i = 0; i < batch_size; i++) {
+                if (JSTD_LIKELY(slot_indexs[i] != this->slot_capacity() || !this->is_migrating()))
+                    out_iters[offset + i] = this->make_iterator(slot_indexs[i]);
+                else
+                    out_iters[offset + i] = this->find(keys[offset + i]);
+            }
+        }
+    }
+
+    template <typename KeyT>
+    void find_batch(const KeyT * keys, size_type count, const_iterator * out_iters) const {
+        size_type slot_indexs[kBatchPrefetchSize];
+        for (size_type offset = 0; offset < count; offset += kBatchPrefetchSize) {
+            size_type batch_size = (std::min)(count - offset, kBatchPrefetchSize);
+            this->find_index_batch(keys + offset, batch_size, slot_indexs);
+            for (size_type i = 0; i < batch_size; i++) {
+                if (JSTD_LIKELY(slot_indexs[i] != this->slot_capacity() || !this->is_migrating()))
+                    out_iters[offset + i] = this->make_iterator(slot_indexs[i]);
+                else
+                    out_iters[offset + i] = this->find(keys[offset + i]);
+            }
+        }
+    }
+
+    template <typename KeyT>
+    size_type contains_batch(const KeyT * keys, size_type count, bool * out_results) const {
+        size_type slot_indexs[kBatchPrefetchSize];
+        size_type found = 0;
+        for (size_type offset = 0; offset < count; offset += kBatchPrefetchSize) {
+            size_type batch_size = (std::min)(count - offset, kBatchPrefetchSize);
+            this->find_index_batch(keys + offset, batch_size, slot_indexs);
+            for (size_type i = 0; i < batch_size; i++) {
+                bool is_exists = (slot_indexs[i] != this->slot_capacity());
+                if (JSTD_UNLIKELY(!is_exists && this->is_migrating()))
+                    is_exists = this->contains(keys[offset + i]);
+                out_results[offset + i] = is_exists;
+                found += is_exists;
+            }
+        }
+        return found;
     }
 
     ///
     /// Modifiers
     ///
+    //
+    // clear(true) frees the arrays. With the ReleasePages mode of TablePolicy, the pages
+    // of a huge slot array are returned to the OS instead, and the array is reused
+    // by the next growth to the same capacity.
+    //
     JSTD_FORCED_INLINE
     void clear(bool need_destroy = false) noexcept {
         if (!need_destroy) {
-            this->clear_data();
+            if (kGenerationClear && (this->slots_ != nullptr) && !this->is_migrating())
+                this->clear_generation();
+            else
+                this->clear_data();
         } else {
-            this->destroy<true>();
+            this->destroy<true, true>();
         }
         assert(this->slot_size() == 0);
     }
@@ -791,12 +1257,12 @@ public:
     }
 
     JSTD_FORCED_INLINE
-    std::pair<iterator, bool> insert(const init_type & value) {
+    std::pair<iterator, bool> insert(const init_arg_type & value) {
         return this->emplace_impl<false>(value);
     }
 
     JSTD_FORCED_INLINE
-    std::pair<iterator, bool> insert(init_type && value) {
+    std::pair<iterator, bool> insert(init_arg_type && value) {
         return this->emplace_impl<false>(std::move(value));
     }
 
@@ -821,12 +1287,12 @@ public:
     }
 
     JSTD_FORCED_INLINE
-    iterator insert(const_iterator hint, const init_type & value) {
+    iterator insert(const_iterator hint, const init_arg_type & value) {
         return this->emplace_impl<false>(value).first;
     }
 
     JSTD_FORCED_INLINE
-    iterator insert(const_iterator hint, init_type && value) {
+    iterator insert(const_iterator hint, init_arg_type && value) {
         return this->emplace_impl<false>(std::move(value)).first;
     }
 
@@ -852,6 +1318,19 @@ public:
         this->insert(ilist.begin(), ilist.end());
     }
 
+    //
+    // Bulk insert [first, last) by thread_count threads, thread_count = 0 means
+    // std::thread::hardware_concurrency(). The table is sized once, the keys are
+    // hashed in parallel and partitioned by the destination group range, and then
+    // each thread fills its own group range. Like insert(first, last), the first one
+    // of the duplicate keys is kept. Non random access iterators use insert(first, last).
+    //
+    template <typename InputIter>
+    void build_from(InputIter first, InputIter last, size_type thread_count = 0) {
+        this->build_from_impl(first, last, thread_count,
+                              typename std::iterator_traits<InputIter>::iterator_category());
+    }
+
     ///
     /// insert_or_assign(key, value)
     ///
@@ -876,19 +1355,19 @@ public:
     template <typename MappedT>
     JSTD_FORCED_INLINE
     iterator insert_or_assign(const_iterator hint, const key_type & key, MappedT && value) {
-        return this->emplace_impl<true>(key, std::forward<MappedT>(value))->first;
+        return this->emplace_impl<true>(key, std::forward<MappedT>(value)).first;
     }
 
     template <typename MappedT>
     JSTD_FORCED_INLINE
     iterator insert_or_assign(const_iterator hint, key_type && key, MappedT && value) {
-        return this->emplace_impl<true>(std::move(key), std::forward<MappedT>(value))->first;
+        return this->emplace_impl<true>(std::move(key), std::forward<MappedT>(value)).first;
     }
 
     template <typename KeyT, typename MappedT>
     JSTD_FORCED_INLINE
     iterator insert_or_assign(const_iterator hint, KeyT && key, MappedT && value) {
-        return this->emplace_impl<true>(std::move(key), std::forward<MappedT>(value))->first;
+        return this->emplace_impl<true>(std::move(key), std::forward<MappedT>(value)).first;
     }
 
     ///
@@ -956,6 +1435,11 @@ public:
 
     JSTD_FORCED_INLINE
     iterator erase(iterator pos) {
+        if (JSTD_UNLIKELY(kIncrementalRehash && (pos.index() < 0))) {
+            // The slot is in the old arrays, see the iterators.
+            this->erase_old_slot(pos.slot());
+            return ++pos;
+        }
         size_type slot_index = pos.index();
         this->erase_slot(slot_index);
         ctrl_type * ctrl = this->ctrl_at(slot_index);
@@ -1023,6 +1507,52 @@ public:
         return (this->slots() + std::ptrdiff_t(slot_index));
     }
 
+    // Only valid when kUseKeyArray is true.
+    key_type * keys() noexcept {
+        return reinterpret_cast<key_type *>(this->groups() + this->group_capacity());
+    }
+    const key_type * keys() const noexcept {
+        return reinterpret_cast<const key_type *>(this->groups() + this->group_capacity());
+    }
+
+    // Only valid when kNeedStoreHash is true.
+    static std::size_t * hash_array(group_type * groups, size_type group_capacity) noexcept {
+        return reinterpret_cast<std::size_t *>(reinterpret_cast<char *>(groups + group_capacity) +
+                                               group_capacity * kKeyArrayBytes);
+    }
+    std::size_t * hashes() noexcept {
+        return this_type::hash_array(this->groups(), this->group_capacity());
+    }
+    const std::size_t * hashes() const noexcept {
+        return this_type::hash_array(const_cast<group_type *>(this->groups()), this->group_capacity());
+    }
+
+    //
+    // The hash code of the key in the slot_index of the groups, it's read from
+    // the hash array if there is, instead of hashing the key again.
+    //
+    JSTD_FORCED_INLINE
+    std::size_t stored_hash_for(group_type * groups, size_type group_capacity,
+                                size_type slot_index, const key_type & key) const {
+        if (kNeedStoreHash)
+            return this_type::hash_array(groups, group_capacity)[slot_index];
+        else
+            return this->hash_for(key);
+    }
+
+    JSTD_FORCED_INLINE
+    bool is_hash_equals(size_type slot_index, std::size_t key_hash) const noexcept {
+        return (!kNeedStoreHash || (this->hashes()[slot_index] == key_hash));
+    }
+
+    JSTD_FORCED_INLINE
+    const key_type & key_at(size_type slot_index) const noexcept {
+        if (kUseKeyArray)
+            return this->keys()[slot_index];
+        else
+            return this->slot_at(slot_index)->get_key();
+    }
+
     JSTD_FORCED_INLINE
     const slot_type * slot_at(size_type slot_index) const noexcept {
         assert(slot_index <= this->slot_capacity());
@@ -1049,6 +1579,75 @@ public:
         return (this->slots() + std::ptrdiff_t(slot_index));
     }
 
+    //
+    // The iterators neither migrate the old arrays nor reset the stale groups. While
+    // migrating, they walk the remaining old slots first, an old slot has a negative
+    // index, it's (old_index - old_slot_capacity). The stale groups are read as empty.
+    //
+    JSTD_FORCED_INLINE
+    ssize_type first_slot_index() const noexcept {
+        return this->first_slot_index(incremental_rehash_t{});
+    }
+
+    inline const ctrl_type * old_ctrl_at(ssize_type slot_index) const noexcept {
+        return this->old_ctrl_at(slot_index, incremental_rehash_t{});
+    }
+
+    inline const slot_type * old_slot_at(ssize_type slot_index) const noexcept {
+        return this->old_slot_at(slot_index, incremental_rehash_t{});
+    }
+
+    JSTD_FORCED_INLINE
+    size_type begin_index() const noexcept {
+        if (JSTD_LIKELY(!this->is_migrating() && !this->has_stale_groups()))
+            return this->find_first_used_index();
+        else
+            return static_cast<size_type>(this->next_used_index(this->first_slot_index() - 1));
+    }
+
+    JSTD_NO_INLINE
+    ssize_type next_used_index(ssize_type slot_index) const noexcept {
+        ssize_type max_index = static_cast<ssize_type>(this->slot_capacity());
+        slot_index++;
+        if (slot_index < 0) {
+            const ctrl_type * ctrl = this->old_ctrl_at(slot_index);
+            for (; slot_index < 0; ++slot_index, ++ctrl) {
+                if (ctrl->is_used())
+                    return slot_index;
+            }
+        }
+        while (slot_index < max_index) {
+            if (JSTD_UNLIKELY(this->is_stale_group(static_cast<size_type>(slot_index) / kGroupWidth))) {
+                slot_index = (slot_index | static_cast<ssize_type>(kGroupWidth - 1)) + 1;
+                continue;
+            }
+            if (this->ctrl_at(static_cast<size_type>(slot_index))->is_used())
+                return slot_index;
+            slot_index++;
+        }
+        return max_index;
+    }
+
+    JSTD_NO_INLINE
+    ssize_type prev_used_index(ssize_type slot_index) const noexcept {
+        while (slot_index > 0) {
+            --slot_index;
+            if (JSTD_UNLIKELY(this->is_stale_group(static_cast<size_type>(slot_index) / kGroupWidth))) {
+                slot_index &= ~static_cast<ssize_type>(kGroupWidth - 1);
+                continue;
+            }
+            if (this->ctrl_at(static_cast<size_type>(slot_index))->is_used())
+                return slot_index;
+        }
+        ssize_type min_index = this->first_slot_index();
+        while (slot_index > min_index) {
+            --slot_index;
+            if (this->old_ctrl_at(slot_index)->is_used())
+                return slot_index;
+        }
+        return slot_index;
+    }
+
     JSTD_FORCED_INLINE
     size_type find_first_used_index() const {
         if (JSTD_LIKELY(this->size() != 0)) {
@@ -1135,6 +1734,12 @@ public:
     }
 
 private:
+    static inline jstd::detail::flat_snapshot_layout snapshot_layout() noexcept {
+        // The key and hash arrays follow the groups, so they are saved as a part of the groups.
+        return { "JSTDG16", sizeof(group_type) + kKeyArrayBytes + kHashArrayBytes, sizeof(slot_type),
+                 sizeof(key_type), sizeof(mapped_type) };
+    }
+
     static inline group_type * default_empty_groups() noexcept {
         alignas(16) static const ctrl_type s_empty_ctrls[kGroupWidth * 2] = {
             // Group 0
@@ -1402,7 +2007,7 @@ private:
             return iter.index();
         } else {
             const slot_type * slot = iter.slot();
-            size_type ctrl_index = this->bucket(slot->key);
+            size_type ctrl_index = this->bucket(slot->get_key());
             return ctrl_index;
         }
     }
@@ -1412,7 +2017,7 @@ private:
             return iter.index();
         } else {
             const slot_type * slot = iter.slot();
-            size_type ctrl_index = this->bucket(slot->key);
+            size_type ctrl_index = this->bucket(slot->get_key());
             return ctrl_index;
         }
     }
@@ -1455,20 +2060,107 @@ private:
         return const_cast<const char *>(reinterpret_cast<char *>(ptr) + offset);
     }
 
-    template <bool NeedClearSlots>
+    template <bool NeedClearSlots, bool ReleaseSlots = false>
     void destroy() {
-        this->destroy_data<NeedClearSlots>();
+        this->destroy_data<NeedClearSlots, ReleaseSlots>();
     }
 
-    template <bool NeedClearSlots>
+    template <bool NeedClearSlots, bool ReleaseSlots = false>
     JSTD_NO_INLINE
     void destroy_data() {
+        this->destroy_old_table();
+        this->drop_stale_groups();
+        if (JSTD_UNLIKELY(this->is_mapped())) {
+            this->destroy_mapped();
+            return;
+        }
         // Note!!: destroy_slots() need use this->ctrls(), so must destroy slots first.
         size_type group_capacity = this->group_capacity();
-        this->destroy_slots<NeedClearSlots>();
+        this->destroy_slots<NeedClearSlots, ReleaseSlots>();
         this->destroy_groups(group_capacity);
     }
 
+    //
+    // The slots are trivially destructible, so just unmap the arrays.
+    //
+    void destroy_mapped() noexcept {
+        this->groups_ = this_type::default_empty_groups();
+        this->slots_ = nullptr;
+        this->slot_size_ = 0;
+        this->slot_mask_ = size_type(-1);
+        this->slot_threshold_ = 0;
+        this->group_mask_ = 0;
+#if GROUP16_USE_INDEX_SHIFT
+        this->index_shift_ = kWordLength - 1;
+#endif
+#if GROUP16_USE_HASH_POLICY
+        this->hash_policy_.reset();
+#endif
+#if GROUP16_USE_SEPARATE_SLOTS
+        this->groups_alloc_ = nullptr;
+#endif
+        this->close_mapped();
+    }
+
+    bool is_mapped(std::false_type) const noexcept {
+        return false;
+    }
+
+    bool is_mapped(std::true_type) const noexcept {
+        return this->state_.mapped_.is_open();
+    }
+
+    void close_mapped() noexcept {
+        this->close_mapped(snapshot_t{});
+    }
+
+    void close_mapped(std::false_type) noexcept {
+    }
+
+    void close_mapped(std::true_type) noexcept {
+        this->state_.mapped_.close();
+    }
+
+    slot_type * allocate_slots(size_type slot_count) {
+        return this->allocate_slots(slot_count, release_pages_t{});
+    }
+
+    slot_type * allocate_slots(size_type slot_count, std::false_type) {
+        return SlotAllocTraits::allocate(this->slot_allocator_, slot_count);
+    }
+
+    slot_type * allocate_slots(size_type slot_count, std::true_type) {
+        return this->state_.released_slots_.allocate(this->slot_allocator_, slot_count);
+    }
+
+    //
+    // Returns false if the array is not kept, then the caller frees it.
+    //
+    bool retain_slots(slot_type * slots, size_type slot_count) noexcept {
+        return this->retain_slots(slots, slot_count, release_pages_t{});
+    }
+
+    bool retain_slots(slot_type * slots, size_type slot_count, std::false_type) noexcept {
+        JSTD_UNUSED(slots);
+        JSTD_UNUSED(slot_count);
+        return false;
+    }
+
+    bool retain_slots(slot_type * slots, size_type slot_count, std::true_type) noexcept {
+        return this->state_.released_slots_.retain(this->slot_allocator_, slots, slot_count);
+    }
+
+    void deallocate_released_slots() noexcept {
+        this->deallocate_released_slots(release_pages_t{});
+    }
+
+    void deallocate_released_slots(std::false_type) noexcept {
+    }
+
+    void deallocate_released_slots(std::true_type) noexcept {
+        this->state_.released_slots_.deallocate(this->slot_allocator_);
+    }
+
     JSTD_FORCED_INLINE
     void destroy_groups(size_type group_capacity) noexcept {
         JSTD_UNUSED(group_capacity);
@@ -1483,7 +2175,7 @@ private:
         }
     }
 
-    template <bool NeedClearSlots>
+    template <bool NeedClearSlots, bool ReleaseSlots = false>
     JSTD_FORCED_INLINE
     void destroy_slots() {
         if (NeedClearSlots) {
@@ -1492,12 +2184,15 @@ private:
 
         if (this->slots_ != nullptr) {
 #if GROUP16_USE_SEPARATE_SLOTS
-            SlotAllocTraits::deallocate(this->slot_allocator_, this->slots_, this->slot_capacity());
+            size_type total_slot_alloc_size = this->slot_capacity();
 #else
             size_type total_slot_alloc_size = this->TotalSlotAllocCount<kGroupAlignment>(
                                                     this->group_capacity(), this->slot_capacity());
-            SlotAllocTraits::deallocate(this->slot_allocator_, this->slots_, total_slot_alloc_size);
 #endif
+            if (!ReleaseSlots ||
+                !this->retain_slots(this->slots_, total_slot_alloc_size)) {
+                SlotAllocTraits::deallocate(this->slot_allocator_, this->slots_, total_slot_alloc_size);
+            }
             // Reset slots state
             this->slots_ = nullptr;
             this->slot_size_ = 0;
@@ -1539,12 +2234,131 @@ private:
         }
     }
 
-    JSTD_FORCED_INLINE
-    void clear_data() {
-        // Note!!: clear_slots() need use this->ctrls(), so must clear slots first.
-        this->clear_slots();
-        this->clear_groups(this->groups(), this->group_capacity());
-    }
+    ///
+    /// Generation clear
+    ///
+    /// The same tag dispatch as the incremental rehash, the tables without
+    /// generation_clear_t never have the stale groups.
+    ///
+    bool has_stale_groups(std::false_type) const noexcept {
+        return false;
+    }
+
+    bool has_stale_groups(std::true_type) const noexcept {
+        return this->state_.has_stale_groups_;
+    }
+
+    void reset_stale_groups(std::false_type) noexcept {
+    }
+
+    void reset_stale_groups(std::true_type) {
+        if (JSTD_UNLIKELY(this->has_stale_groups())) {
+            group_type * groups = this->groups();
+            size_type group_capacity = this->group_capacity();
+            assert(this->state_.group_epochs_.size() == group_capacity);
+            for (size_type group_index = 0; group_index < group_capacity; group_index++) {
+                if (this->state_.group_epochs_[group_index] != this->state_.generation_) {
+                    groups[group_index].init();
+                    this->state_.group_epochs_[group_index] = this->state_.generation_;
+                }
+            }
+            this->state_.has_stale_groups_ = false;
+        }
+    }
+
+    //
+    // The arrays are freed, the stale groups go with them.
+    //
+    void drop_stale_groups() noexcept {
+        this->drop_stale_groups(generation_clear_t{});
+    }
+
+    void drop_stale_groups(std::false_type) noexcept {
+    }
+
+    void drop_stale_groups(std::true_type) noexcept {
+        if (JSTD_UNLIKELY(this->has_stale_groups())) {
+            this->state_.has_stale_groups_ = false;
+            this->state_.group_epochs_.clear();
+        }
+    }
+
+    JSTD_FORCED_INLINE
+    bool is_stale_group(size_type group_index) const noexcept {
+        return this->is_stale_group(group_index, generation_clear_t{});
+    }
+
+    bool is_stale_group(size_type group_index, std::false_type) const noexcept {
+        JSTD_UNUSED(group_index);
+        return false;
+    }
+
+    JSTD_FORCED_INLINE
+    bool is_stale_group(size_type group_index, std::true_type) const noexcept {
+        return (this->state_.has_stale_groups_ &&
+               (this->state_.group_epochs_[group_index] != this->state_.generation_));
+    }
+
+    JSTD_FORCED_INLINE
+    void reset_stale_group(size_type group_index) noexcept {
+        this->reset_stale_group(group_index, generation_clear_t{});
+    }
+
+    void reset_stale_group(size_type group_index, std::false_type) noexcept {
+        JSTD_UNUSED(group_index);
+    }
+
+    JSTD_FORCED_INLINE
+    void reset_stale_group(size_type group_index, std::true_type) noexcept {
+        this->group_at(group_index)->init();
+        this->state_.group_epochs_[group_index] = this->state_.generation_;
+    }
+
+    void clear_generation() noexcept {
+        this->clear_generation(generation_clear_t{});
+    }
+
+    void clear_generation(std::false_type) noexcept {
+        this->clear_data();
+    }
+
+    //
+    // All the groups that are not stale have the current generation.
+    //
+    JSTD_NO_INLINE
+    void clear_generation(std::true_type) noexcept {
+        size_type group_capacity = this->group_capacity();
+        if (this->state_.group_epochs_.size() != group_capacity) {
+            assert(!this->has_stale_groups());
+            try {
+                this->state_.group_epochs_.assign(group_capacity, this->state_.generation_);
+            } catch (const std::bad_alloc &) {
+                this->clear_data();
+                return;
+            }
+        }
+        this->state_.generation_++;
+        if (JSTD_LIKELY(this->state_.generation_ != 0)) {
+            this->state_.has_stale_groups_ = true;
+        } else {
+            // The generation is wrapped, the old epochs may be equal to it again.
+            this->clear_groups(this->groups(), group_capacity);
+            std::fill(this->state_.group_epochs_.begin(), this->state_.group_epochs_.end(),
+                      this->state_.generation_);
+            this->state_.has_stale_groups_ = false;
+        }
+        this->slot_size_ = 0;
+        // No group has the overflow bits now.
+        this->slot_threshold_ = this->calc_slot_threshold(this->slot_capacity());
+    }
+
+    JSTD_FORCED_INLINE
+    void clear_data() {
+        this->destroy_old_table();
+        // Note!!: clear_slots() need use this->ctrls(), so must clear slots first.
+        this->clear_slots();
+        this->clear_groups(this->groups(), this->group_capacity());
+    }
 
     JSTD_FORCED_INLINE
     void clear_groups(group_type * groups, size_type group_capacity) {
@@ -1599,7 +2413,10 @@ private:
         assert(this->empty());
         assert(this != std::addressof(other));
         assert(other.size() > 0);
-        if (this->slot_capacity() == other.slot_capacity()) {
+        // The other table is read as it is, a migrating or generation-cleared table
+        // is copied by it's iterators, they walk the both arrays and skip the stale groups.
+        if ((this->slot_capacity() == other.slot_capacity()) &&
+            !other.is_migrating() && !other.has_stale_groups()) {
             this->fast_copy_slots_from(other);
         } else {
             try {
@@ -1619,7 +2436,10 @@ private:
     void fast_copy_slots_from(group16_flat_table const & other) {
         if (this->slots() != nullptr && other.slots() != nullptr) {
             copy_groups_array_from(other);
+            copy_keys_array_from(other);
+            copy_hashes_array_from(other);
             copy_slots_array_from(other);
+            this->slot_size_ = other.slot_size();
         }
     }
 
@@ -1647,11 +2467,32 @@ private:
         }
     }
 
+    JSTD_FORCED_INLINE
+    void copy_keys_array_from(group16_flat_table const & other) {
+        if (kUseKeyArray) {
+            std::memcpy(
+                reinterpret_cast<unsigned char *>(this->keys()),
+                reinterpret_cast<const unsigned char *>(other.keys()),
+                other.slot_capacity() * sizeof(key_type));
+        }
+    }
+
+    JSTD_FORCED_INLINE
+    void copy_hashes_array_from(group16_flat_table const & other) {
+        if (kNeedStoreHash) {
+            std::memcpy(
+                reinterpret_cast<unsigned char *>(this->hashes()),
+                reinterpret_cast<const unsigned char *>(other.hashes()),
+                other.slot_capacity() * sizeof(std::size_t));
+        }
+    }
+
     JSTD_FORCED_INLINE
     void copy_slots_array_from(group16_flat_table const & other) {
         this->copy_slots_array_from(
             other,
-            std::integral_constant<bool, std::is_trivially_copy_constructible<element_type>::value &&
+            std::integral_constant<bool, !kIsNodeBased &&
+                                         std::is_trivially_copy_constructible<element_type>::value &&
                                         (jstd::is_std_allocator<Allocator>::value ||
                                         !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value)>{}
         );
@@ -1665,7 +2506,7 @@ private:
          */
         std::memcpy(
             reinterpret_cast<unsigned char *>(this->slots()),
-            reinterpret_cast<unsigned char *>(other.slots()),
+            reinterpret_cast<const unsigned char *>(other.slots()),
             other.slot_capacity() * sizeof(slot_type));
     }
 
@@ -1717,6 +2558,8 @@ private:
     //
     JSTD_FORCED_INLINE
     void move_slots_from(group16_flat_table & other) {
+        other.finish_migration();
+        other.reset_stale_groups();
         assert(this->empty());
         assert(this != std::addressof(other));
         assert(other.size() > 0);
@@ -1739,8 +2582,11 @@ private:
     JSTD_FORCED_INLINE
     void fast_move_slots_from(group16_flat_table & other) {
         if (this->slots() != nullptr && other.slots() != nullptr) {
+            copy_keys_array_from(other);
+            copy_hashes_array_from(other);
             move_groups_array_from(other);
             move_slots_array_from(other);
+            this->slot_size_ = other.slot_size();
         }
     }
 
@@ -1777,9 +2623,7 @@ private:
     void move_slots_array_from(group16_flat_table & other) {
         this->move_slots_array_from(
             other,
-            std::integral_constant<bool, std::is_trivially_copy_constructible<element_type>::value &&
-                                        (jstd::is_std_allocator<Allocator>::value ||
-                                        !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value)>{}
+            std::integral_constant<bool, kIsRelocatableSlot>{}
         );
     }
 
@@ -1787,15 +2631,18 @@ private:
     void move_slots_array_from(group16_flat_table & other, std::true_type /* -> memcpy */) {
         /*
          * reinterpret_cast: GCC may complain about value_type not being trivially
-         * copy-assignable when we're relying on trivial copy constructibility.
+         * copy-assignable when we're relying on trivial copy constructibility
+         * or the trivial relocatability.
          */
         std::memcpy(
             reinterpret_cast<unsigned char *>(this->slots()),
-            reinterpret_cast<unsigned char *>(other.slots()),
+            reinterpret_cast<const unsigned char *>(other.slots()),
             other.slot_capacity() * sizeof(slot_type));
 
-        // Reset all of other slots
-        std::fill_n(other.slots(), other.slot_capacity(), slot_type());
+        // move_groups_array_from() only copies the groups, the other groups still mark
+        // the relocated elements as used, they must not be destroyed there. The caller
+        // releases the other table by destroy<false>(), it frees the arrays without
+        // destroying the slots.
     }
 
     JSTD_FORCED_INLINE
@@ -1849,9 +2696,31 @@ private:
 
     JSTD_FORCED_INLINE
     void grow_if_necessary() {
+        if (JSTD_UNLIKELY(this->should_purge_overflow())) {
+            size_type lost_slots = this->calc_slot_threshold(this->slot_capacity()) - this->slot_size();
+            this->purge_overflow();
+            // Keep the table if the purge got back enough room, otherwise it's purged again soon.
+            if ((this->slot_threshold() - this->slot_size()) >= (lost_slots / 2))
+                return;
+        }
+
         // The growth rate is 2 times
         size_type new_capacity = this->ctrl_capacity() * 2;
-        this->rehash_impl<false>(new_capacity);
+        if (JSTD_UNLIKELY(kIncrementalRehash && (this->slot_size() >= kMinIncrementalRehashSize) &&
+                          !this->is_mapped()))
+            this->start_migration(new_capacity);
+        else
+            this->rehash_impl<false>(new_capacity);
+    }
+
+    //
+    // The table is not really full, the erases have lowered the threshold.
+    //
+    JSTD_FORCED_INLINE
+    bool should_purge_overflow() const noexcept {
+        size_type slot_threshold = this->calc_slot_threshold(this->slot_capacity());
+        return (!this->is_migrating() && (this->slot_size() < slot_threshold) &&
+                ((slot_threshold - this->slot_size()) >= (slot_threshold / kPurgeOverflowRatio)));
     }
 
     inline bool is_valid_capacity(size_type capacity) const noexcept {
@@ -1908,7 +2777,7 @@ private:
     template <size_type GroupAlignment>
     JSTD_FORCED_INLINE
     size_type TotalGroupAllocCount(size_type group_capacity) noexcept {
-        const size_type num_group_bytes = group_capacity * sizeof(group_type);
+        const size_type num_group_bytes = group_capacity * (sizeof(group_type) + kKeyArrayBytes + kHashArrayBytes);
         const size_type total_bytes = num_group_bytes + GroupAlignment;
         const size_type total_alloc_count = (total_bytes + sizeof(group_type) - 1) / sizeof(group_type);
         return total_alloc_count;
@@ -1921,7 +2790,7 @@ private:
     template <size_type GroupAlignment>
     JSTD_FORCED_INLINE
     size_type TotalSlotAllocCount(size_type group_capacity, size_type slot_capacity) noexcept {
-        const size_type num_group_bytes = group_capacity * sizeof(group_type);
+        const size_type num_group_bytes = group_capacity * (sizeof(group_type) + kKeyArrayBytes + kHashArrayBytes);
         const size_type num_slot_bytes = slot_capacity * sizeof(slot_type);
         const size_type total_bytes = num_slot_bytes + GroupAlignment + num_group_bytes;
         const size_type total_alloc_count = (total_bytes + sizeof(slot_type) - 1) / sizeof(slot_type);
@@ -1949,11 +2818,11 @@ private:
             group_type * new_groups_alloc = GroupAllocTraits::allocate(this->group_allocator_, total_group_alloc_count);
             group_type * new_groups = this->AlignedGroups<kGroupAlignment>(new_groups_alloc);
 
-            slot_type * new_slots = SlotAllocTraits::allocate(this->slot_allocator_, new_slot_capacity);
+            slot_type * new_slots = this->allocate_slots(new_slot_capacity);
 #else
             size_type total_slot_alloc_count = this->TotalSlotAllocCount<kGroupAlignment>(new_group_capacity, new_slot_capacity);
 
-            slot_type * new_slots = SlotAllocTraits::allocate(this->slot_allocator_, total_slot_alloc_count);
+            slot_type * new_slots = this->allocate_slots(total_slot_alloc_count);
             group_type * new_groups = this->AlignedSlotsAndGroups<kGroupAlignment>(new_slots, new_slot_capacity);
             assert((void *)new_slots != (void *)new_groups);
 #endif
@@ -1981,7 +2850,9 @@ private:
 
     template <bool AllowShrink>
     JSTD_NO_INLINE
-    void rehash_impl(size_type new_capacity) {
+    void rehash_impl(size_type new_capacity, size_type thread_count = 1) {
+        this->finish_migration();
+        this->reset_stale_groups();
         new_capacity = this->calc_capacity(new_capacity);
         assert(new_capacity > 0);
         assert(new_capacity >= kMinCapacity);
@@ -2001,10 +2872,16 @@ private:
             size_type old_slot_mask = this->slot_mask();
             size_type old_slot_capacity = this->slot_capacity();
             size_type old_slot_threshold = this->slot_threshold();
+            bool old_is_mapped = this->is_mapped();
 
             this->create_slots<false>(new_capacity);
 
-            if (old_groups != this_type::default_empty_groups()) {
+            if ((old_groups != this_type::default_empty_groups()) &&
+                !this->try_parallel_transfer(old_groups, old_group_capacity, old_slots,
+                                             old_slot_size, thread_count)) {
+                // With GROUP16_USE_INDEX_SHIFT, the home index is the high bits of the hash,
+                // so the old groups are scanned in the order of their new home regions, and
+                // this loop already writes the new arrays region by region, except the probed slots.
                 auto mask_bits = group_type::make_mask_bits();
                 group_type * group = old_groups;
                 group_type * last_group = old_groups + old_group_capacity;
@@ -2017,7 +2894,9 @@ private:
                         used_mask = BitUtils::clearLowBit32(used_mask);
                         slot_type * old_slot = slot_base + used_pos;
                         assert(old_slot < old_last_slot);
-                        this->no_grow_unique_transfer_insert(old_slot);
+                        std::size_t key_hash = this->stored_hash_for(old_groups, old_group_capacity,
+                                                                     old_slot - old_slots, old_slot->get_key());
+                        this->no_grow_unique_transfer_insert(old_slot, key_hash);
                         //this->destroy_slot(old_slot);
                     }
                     slot_base += kGroupWidth;
@@ -2026,25 +2905,388 @@ private:
 
             assert(this->slot_size() == old_slot_size);
 
+            if (JSTD_UNLIKELY(old_is_mapped)) {
+                // The old arrays are in the mapped file.
+                this->close_mapped();
+                return;
+            }
+
 #if GROUP16_USE_SEPARATE_SLOTS
             if (old_groups != this_type::default_empty_groups()) {
                 assert(old_groups_alloc != nullptr);
                 size_type total_group_alloc_count = this->TotalGroupAllocCount<kGroupAlignment>(old_group_capacity);
                 GroupAllocTraits::deallocate(this->group_allocator_, old_groups_alloc, total_group_alloc_count);
             }
-            if (old_slots != nullptr) {
-                SlotAllocTraits::deallocate(this->slot_allocator_, old_slots, old_slot_capacity);
-            }
+            size_type total_slot_alloc_count = old_slot_capacity;
 #else
+            size_type total_slot_alloc_count = this->TotalSlotAllocCount<kGroupAlignment>(
+                                                     old_group_capacity, old_slot_capacity);
+#endif
             if (old_slots != nullptr) {
-                size_type total_slot_alloc_count = this->TotalSlotAllocCount<kGroupAlignment>(
-                                                         old_group_capacity, old_slot_capacity);
-                SlotAllocTraits::deallocate(this->slot_allocator_, old_slots, total_slot_alloc_count);
+                // Shrinking, keep the old slots for the next growth, but return it's pages.
+                bool is_shrink = AllowShrink && (this->slot_capacity() < old_slot_capacity);
+                if (!is_shrink ||
+                    !this->retain_slots(old_slots, total_slot_alloc_count)) {
+                    SlotAllocTraits::deallocate(this->slot_allocator_, old_slots, total_slot_alloc_count);
+                }
             }
-#endif
         }
     }
 
+    struct build_item {
+        size_type    index;
+        std::size_t  key_hash;
+    };
+
+    template <typename InputIter>
+    void build_from_impl(InputIter first, InputIter last, size_type thread_count,
+                         std::input_iterator_tag) {
+        JSTD_UNUSED(thread_count);
+        this->insert(first, last);
+    }
+
+    //
+    // Same three phases as try_parallel_transfer(), but the partition threads
+    // also look up the duplicate keys, and the phase 2 can be failed by
+    // the constructor of value_type, the elements inserted so far are kept.
+    //
+    template <typename RandomIter>
+    JSTD_NO_INLINE
+    void build_from_impl(RandomIter first, RandomIter last, size_type thread_count,
+                         std::random_access_iterator_tag) {
+        size_type count = static_cast<size_type>(std::distance(first, last));
+        if (count == 0)
+            return;
+
+        thread_count = jstd::detail::clamp_rehash_threads(thread_count);
+        // The node allocator (eg. the pool) may be not thread-safe, so the node maps are built serially.
+        if ((thread_count <= 1) || (count < kMinParallelRehashSize) || kIsNodeBased) {
+            this->reserve(this->size() + count);
+            this->insert(first, last);
+            return;
+        }
+
+        // The partition threads don't look up the old table, and don't check the stale groups.
+        this->finish_migration();
+        this->reset_stale_groups();
+
+        // Size the table once.
+        this->reserve(this->size() + count, thread_count);
+
+        size_type group_capacity = this->group_capacity();
+        thread_count = (std::min)(thread_count, group_capacity);
+        size_type part_groups = (group_capacity + thread_count - 1) / thread_count;
+
+        std::vector<std::vector<build_item>> buckets(thread_count * thread_count);
+        std::vector<size_type> inserted_counts(thread_count, 0);
+        std::vector<std::exception_ptr> exceptions(thread_count);
+
+        // Phase 1: hash and partition
+        jstd::detail::parallel_run(thread_count, [&](size_type index) {
+            size_type first_index = count * index / thread_count;
+            size_type last_index  = count * (index + 1) / thread_count;
+            std::vector<build_item> * part_buckets = &buckets[index * thread_count];
+            try {
+                for (size_type i = first_index; i < last_index; i++) {
+                    std::size_t key_hash = this->hash_for(type_policy::extract(*(first + i)));
+                    size_type part = this->index_for_hash(key_hash) / part_groups;
+                    assert(part < thread_count);
+                    part_buckets[part].push_back({ i, key_hash });
+                }
+            } catch (...) {
+                exceptions[index] = std::current_exception();
+            }
+        });
+
+        for (size_type i = 0; i < thread_count; i++) {
+            if (exceptions[i])
+                std::rethrow_exception(exceptions[i]);
+        }
+
+        // Phase 2: fill the group range of each partition
+        jstd::detail::parallel_run(thread_count, [&](size_type part) {
+            size_type first_group = part * part_groups;
+            size_type last_group  = (std::min)(first_group + part_groups, group_capacity);
+            size_type inserted = 0;
+            try {
+                for (size_type i = 0; i < thread_count; i++) {
+                    std::vector<build_item> & bucket = buckets[i * thread_count + part];
+                    size_type remain = 0;
+                    for (size_type n = 0; n < bucket.size(); n++) {
+                        const build_item & item = bucket[n];
+                        const auto & value = *(first + item.index);
+                        auto find_info = this->find_or_insert_in_range(type_policy::extract(value), item.key_hash,
+                                                                       first_group, last_group);
+                        size_type slot_index = find_info.first;
+                        if (find_info.second == kIsKeyExists)
+                            continue;
+                        if (JSTD_LIKELY(slot_index != this->slot_capacity())) {
+                            slot_type * slot = this->slot_at(slot_index);
+                            try {
+                                SlotPolicyTraits::construct(&this->slot_allocator_, slot, value);
+                            } catch (...) {
+                                this->ctrl_at(slot_index)->set_empty();
+                                throw;
+                            }
+                            inserted++;
+                        } else {
+                            bucket[remain++] = item;
+                        }
+                    }
+                    bucket.resize(remain);
+                }
+            } catch (...) {
+                exceptions[part] = std::current_exception();
+            }
+            inserted_counts[part] = inserted;
+        });
+
+        for (size_type i = 0; i < thread_count; i++) {
+            this->slot_size_ += inserted_counts[i];
+        }
+        assert(this->slot_size() <= this->slot_capacity());
+
+        for (size_type i = 0; i < thread_count; i++) {
+            if (exceptions[i])
+                std::rethrow_exception(exceptions[i]);
+        }
+
+        // Phase 3: the remaining elements
+        for (size_type i = 0; i < buckets.size(); i++) {
+            for (const build_item & item : buckets[i]) {
+                this->emplace_impl<false>(*(first + item.index));
+            }
+        }
+    }
+
+    //
+    // Same as find_or_insert(), but only probe the groups in [first_group, last_group),
+    // returns { slot_capacity(), kNeedInsert } if the probe leaves the range.
+    //
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    std::pair<size_type, bool> find_or_insert_in_range(const KeyT & key, std::size_t key_hash,
+                                                       size_type first_group, size_type last_group) {
+        size_type group_index = this->index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
+        auto hash_bits = group_type::make_hash_bits(ctrl_hash);
+        auto mask_bits = group_type::make_mask_bits();
+        prober_type prober(group_index);
+
+        do {
+            group_index = prober.get();
+            if ((group_index < first_group) || (group_index >= last_group))
+                return { this->slot_capacity(), kNeedInsert };
+            const group_type * group = this->group_at(group_index);
+            std::uint32_t match_mask = group->match_hash(hash_bits, mask_bits);
+            if (match_mask != 0) {
+                size_type slot_base = group_index * kGroupWidth;
+                do {
+                    std::uint32_t match_pos = BitUtils::bsf32(match_mask);
+                    size_type slot_index = slot_base + match_pos;
+                    if (this->is_hash_equals(slot_index, key_hash) &&
+                        this->key_equal_(key, this->key_at(slot_index))) {
+                        return { slot_index, kIsKeyExists };
+                    }
+                    match_mask = BitUtils::clearLowBit32(match_mask);
+                } while (match_mask != 0);
+            }
+            if (JSTD_LIKELY(group->is_not_overflow(ctrl_hash)))
+                break;
+        } while (prober.next_bucket(this->group_mask()));
+
+        size_type slot_index = this->find_empty_in_range(key, key_hash, first_group, last_group);
+        return { slot_index, kNeedInsert };
+    }
+
+    struct rehash_item {
+        slot_type *  slot;
+        std::size_t  key_hash;
+    };
+
+    //
+    // Transfer the old slots by several threads, in three phases:
+    //
+    //   1. Each thread hashes a range of the old groups, and scatters the slots
+    //      into the buckets of the new group partition where their home group is.
+    //   2. Each thread inserts the slots of one partition, the probe never leaves
+    //      the partition, so the threads never write the same group. The slots
+    //      whose probe would leave the partition are kept in the buckets.
+    //   3. The calling thread inserts the remaining slots.
+    //
+    // Returns false if it isn't worth it or the buckets can't be allocated,
+    // the old slots are untouched then. A transfer mustn't throw in the threads,
+    // so the slots whose move may throw always take the serial loop.
+    //
+    JSTD_NO_INLINE
+    bool try_parallel_transfer(group_type * old_groups, size_type old_group_capacity,
+                               slot_type * old_slots, size_type old_slot_size,
+                               size_type thread_count) {
+        if (!kIsNothrowTransfer || (thread_count == 1) || (old_slot_size < kMinParallelRehashSize))
+            return false;
+
+        size_type new_group_capacity = this->group_capacity();
+        thread_count = jstd::detail::clamp_rehash_threads(thread_count);
+        thread_count = (std::min)(thread_count, new_group_capacity);
+        if (thread_count <= 1)
+            return false;
+
+        size_type part_groups = (new_group_capacity + thread_count - 1) / thread_count;
+
+        std::vector<std::vector<rehash_item>> buckets;
+        std::vector<size_type> inserted_counts;
+        std::vector<std::uint8_t> is_failed;
+        try {
+            buckets.resize(thread_count * thread_count);
+            inserted_counts.resize(thread_count, 0);
+            is_failed.resize(thread_count, 0);
+        } catch (...) {
+            return false;
+        }
+
+        // Phase 1: scatter
+        jstd::detail::parallel_run(thread_count, [&](size_type index) {
+            size_type first_group = old_group_capacity * index / thread_count;
+            size_type last_group  = old_group_capacity * (index + 1) / thread_count;
+            std::vector<rehash_item> * part_buckets = &buckets[index * thread_count];
+            auto mask_bits = group_type::make_mask_bits();
+            try {
+                for (size_type group_index = first_group; group_index < last_group; group_index++) {
+                    const group_type * group = old_groups + group_index;
+                    slot_type * slot_base = old_slots + group_index * kGroupWidth;
+                    std::uint32_t used_mask = group->match_used(mask_bits);
+                    while (used_mask != 0) {
+                        std::uint32_t used_pos = BitUtils::bsf32(used_mask);
+                        used_mask = BitUtils::clearLowBit32(used_mask);
+                        slot_type * old_slot = slot_base + used_pos;
+                        std::size_t key_hash = this->stored_hash_for(old_groups, old_group_capacity,
+                                                                     group_index * kGroupWidth + used_pos,
+                                                                     old_slot->get_key());
+                        size_type part = this->index_for_hash(key_hash) / part_groups;
+                        assert(part < thread_count);
+                        part_buckets[part].push_back({ old_slot, key_hash });
+                    }
+                }
+            } catch (...) {
+                is_failed[index] = 1;
+            }
+        });
+
+        for (size_type i = 0; i < thread_count; i++) {
+            if (is_failed[i] != 0)
+                return false;
+        }
+
+        // Phase 2: insert by partition
+        jstd::detail::parallel_run(thread_count, [&](size_type part) {
+            size_type first_group = part * part_groups;
+            size_type last_group  = (std::min)(first_group + part_groups, new_group_capacity);
+            size_type inserted = 0;
+            for (size_type i = 0; i < thread_count; i++) {
+                std::vector<rehash_item> & bucket = buckets[i * thread_count + part];
+                size_type remain = 0;
+                for (size_type n = 0; n < bucket.size(); n++) {
+                    const rehash_item & item = bucket[n];
+                    size_type slot_index = this->find_empty_in_range(item.slot->get_key(), item.key_hash,
+                                                                     first_group, last_group);
+                    if (JSTD_LIKELY(slot_index != this->slot_capacity())) {
+                        this->transfer_slot(slot_index, item.slot);
+                        inserted++;
+                    } else {
+                        bucket[remain++] = item;
+                    }
+                }
+                bucket.resize(remain);
+            }
+            inserted_counts[part] = inserted;
+        });
+
+        // Phase 3: the remaining slots
+        for (size_type i = 0; i < buckets.size(); i++) {
+            for (const rehash_item & item : buckets[i]) {
+                size_type group_index = this->index_for_hash(item.key_hash);
+                std::size_t ctrl_hash = this->ctrl_for_hash(item.key_hash);
+                size_type slot_index = this->find_empty_to_insert<true, key_type>(
+                                             item.slot->get_key(), group_index, ctrl_hash, item.key_hash);
+                this->transfer_slot(slot_index, item.slot);
+                this->slot_size_++;
+            }
+        }
+
+        for (size_type i = 0; i < thread_count; i++) {
+            this->slot_size_ += inserted_counts[i];
+        }
+        assert(this->slot_size() <= this->slot_capacity());
+        return true;
+    }
+
+    //
+    // Same as find_empty_to_insert<true>(), but only probe the groups in [first_group, last_group),
+    // returns slot_capacity() if the probe leaves the range.
+    //
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    size_type find_empty_in_range(const KeyT & key, std::size_t key_hash,
+                                  size_type first_group, size_type last_group) {
+        size_type group_index = this->index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
+        auto mask_bits = group_type::make_mask_bits();
+        prober_type prober(group_index);
+
+        do {
+            group_index = prober.get();
+            if ((group_index < first_group) || (group_index >= last_group))
+                break;
+            group_type * group = this->group_at(group_index);
+            std::uint32_t empty_mask = group->match_empty(mask_bits);
+            if (JSTD_LIKELY(empty_mask != 0)) {
+                std::uint32_t empty_pos = BitUtils::bsf32(empty_mask);
+                group->set_used(empty_pos, ctrl_hash);
+                size_type slot_index = group_index * kGroupWidth + empty_pos;
+                this->store_key(slot_index, key);
+                this->store_hash(slot_index, key_hash);
+                return slot_index;
+            } else {
+                group->set_overflow(ctrl_hash);
+            }
+        } while (prober.next_bucket(this->group_mask()));
+
+        return this->slot_capacity();
+    }
+
+    JSTD_FORCED_INLINE
+    void store_hash(size_type slot_index, std::size_t key_hash) noexcept {
+        if (kNeedStoreHash) {
+            this->hashes()[slot_index] = key_hash;
+        }
+    }
+
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    void store_key(size_type slot_index, const KeyT & key) {
+        this->store_key(slot_index, key, std::integral_constant<bool, kUseKeyArray>{});
+    }
+
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    void store_key(size_type slot_index, const KeyT & key, std::true_type) {
+        key_type * key_ptr = this->keys() + slot_index;
+        ::new ((void *)key_ptr) key_type(key);
+    }
+
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    void store_key(size_type slot_index, const KeyT & key, std::false_type) {
+        JSTD_UNUSED(slot_index);
+        JSTD_UNUSED(key);
+    }
+
+    JSTD_FORCED_INLINE
+    void transfer_slot(size_type slot_index, slot_type * old_slot) {
+        slot_type * new_slot = this->slot_at(slot_index);
+        SlotPolicyTraits::transfer(&this->slot_allocator_, new_slot, old_slot);
+    }
+
     JSTD_FORCED_INLINE
     void construct_slot(slot_type * slot) {
         SlotPolicyTraits::construct(&this->slot_allocator_, slot);
@@ -2117,32 +3359,42 @@ private:
         std::size_t key_hash = this->hash_for(key);
         size_type group_index = this->index_for_hash(key_hash);
         std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
-        return this->find_index(key, group_index, ctrl_hash);
+        return this->find_index(key, group_index, ctrl_hash, key_hash);
     }
 
     template <typename KeyT>
     JSTD_FORCED_INLINE
-    size_type find_index(const KeyT & key, size_type group_index, std::size_t ctrl_hash) const {
+    size_type find_index(const KeyT & key, size_type group_index, std::size_t ctrl_hash,
+                         std::size_t key_hash) const {
         auto hash_bits = group_type::make_hash_bits(ctrl_hash);
         auto mask_bits = group_type::make_mask_bits();
         prober_type prober(group_index);
 
         do {
             group_index = prober.get();
+            // A stale group is empty, and has no overflow.
+            if (JSTD_UNLIKELY(this->is_stale_group(group_index))) {
+                return this->slot_capacity();
+            }
             const group_type * group = this->group_at(group_index);
             std::uint32_t match_mask = group->match_hash(hash_bits, mask_bits);
             if (JSTD_LIKELY(match_mask != 0)) {
                 const slot_type * slot_start = this->slots();
                 JSTD_ASSUME(slot_start != nullptr);
-                const slot_type * slot_base = slot_start + group_index * kGroupWidth;
-                if (sizeof(value_type) <= 64) {
-                    jstd::CPU_Prefetch_Read_T0((const void *)slot_base);
+                size_type slot_base = group_index * kGroupWidth;
+                if (kUseKeyArray) {
+                    // Fetch the slot of the first match while the key is compared,
+                    // the first match is nearly always the hit.
+                    jstd::CPU_Prefetch_Read_T0((const void *)(slot_start + slot_base +
+                                                              BitUtils::bsf32(match_mask)));
+                } else if (sizeof(value_type) <= 64) {
+                    jstd::CPU_Prefetch_Read_T0((const void *)(slot_start + slot_base));
                 }
                 do {
                     std::uint32_t match_pos = BitUtils::bsf32(match_mask);
-                    const slot_type * slot = slot_base + match_pos;
-                    if (JSTD_LIKELY(this->key_equal_(key, slot->value.first))) {
-                        size_type slot_index = this->index_of(slot);
+                    size_type slot_index = slot_base + match_pos;
+                    if (JSTD_LIKELY(this->is_hash_equals(slot_index, key_hash) &&
+                                    this->key_equal_(key, this->key_at(slot_index)))) {
                         return slot_index;
                     }
                     match_mask = BitUtils::clearLowBit32(match_mask);
@@ -2166,9 +3418,43 @@ private:
         return this->slot_capacity();
     }
 
+    //
+    // Hash the whole batch first and prefetch the home group and slots of each key,
+    // so that the cache misses of the batch overlap, then run the match loop.
+    //
+    template <typename KeyT>
+    JSTD_NO_INLINE
+    void find_index_batch(const KeyT * keys, size_type count, size_type * out_indexs) const {
+        size_type   group_indexs[kBatchPrefetchSize];
+        std::size_t ctrl_hashs[kBatchPrefetchSize];
+        std::size_t key_hashs[kBatchPrefetchSize];
+
+        assert(count <= kBatchPrefetchSize);
+        const slot_type * slot_start = this->slots();
+        for (size_type i = 0; i < count; i++) {
+            std::size_t key_hash = this->hash_for(keys[i]);
+            size_type group_index = this->index_for_hash(key_hash);
+            group_indexs[i] = group_index;
+            ctrl_hashs[i] = this->ctrl_for_hash(key_hash);
+            key_hashs[i] = key_hash;
+            jstd::CPU_Prefetch_Read_T0((const void *)this->group_at(group_index));
+            if (JSTD_LIKELY(slot_start != nullptr)) {
+                if (kUseKeyArray)
+                    jstd::CPU_Prefetch_Read_T0((const void *)(this->keys() + group_index * kGroupWidth));
+                else
+                    jstd::CPU_Prefetch_Read_T0((const void *)(slot_start + group_index * kGroupWidth));
+            }
+        }
+
+        for (size_type i = 0; i < count; i++) {
+            out_indexs[i] = this->find_index(keys[i], group_indexs[i], ctrl_hashs[i], key_hashs[i]);
+        }
+    }
+
     template <bool IsNoCheck, typename KeyT = key_type>
     JSTD_FORCED_INLINE
-    size_type find_empty_to_insert(const KeyT & key, size_type group_index, std::size_t ctrl_hash) {
+    size_type find_empty_to_insert(const KeyT & key, size_type group_index, std::size_t ctrl_hash,
+                                   std::size_t key_hash) {
         static constexpr bool IsNoGrow = true;
         auto mask_bits = group_type::make_mask_bits();
         prober_type prober(group_index);
@@ -2176,6 +3462,9 @@ private:
         do {
             group_index = prober.get();
             group_type * group = this->group_at(group_index);
+            if (JSTD_UNLIKELY(this->is_stale_group(group_index))) {
+                this->reset_stale_group(group_index);
+            }
             std::uint32_t empty_mask = group->match_empty(mask_bits);
             if (JSTD_LIKELY(empty_mask != 0)) {
                 std::uint32_t empty_pos = BitUtils::bsf32(empty_mask);
@@ -2191,6 +3480,8 @@ private:
 #endif
                 }
                 size_type slot_index = slot_base + empty_pos;
+                this->store_key(slot_index, key);
+                this->store_hash(slot_index, key_hash);
                 return slot_index;
             } else {
                 // If it's not overflow, set the overflow bit.
@@ -2215,11 +3506,15 @@ private:
     template <typename KeyT>
     JSTD_FORCED_INLINE
     std::pair<size_type, bool> find_or_insert(const KeyT & key) {
+        if (JSTD_UNLIKELY(this->is_migrating())) {
+            return this->find_or_insert_migrating(key);
+        }
+
         std::size_t key_hash = this->hash_for(key);
         size_type group_index = this->index_for_hash(key_hash);
         std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
 
-        size_type slot_index = this->find_index(key, group_index, ctrl_hash);
+        size_type slot_index = this->find_index(key, group_index, ctrl_hash, key_hash);
         if (slot_index != this->slot_capacity()) {
             return { slot_index, kIsKeyExists };
         }
@@ -2233,7 +3528,7 @@ private:
             // ctrl_hash = this->ctrl_for_hash(key_hash);
         }
 
-        slot_index = this->find_empty_to_insert<false, KeyT>(key, group_index, ctrl_hash);
+        slot_index = this->find_empty_to_insert<false, KeyT>(key, group_index, ctrl_hash, key_hash);
         if (JSTD_LIKELY(true || (slot_index != this->slot_capacity()))) {
             return { slot_index, kNeedInsert };
         }
@@ -2244,7 +3539,7 @@ private:
             this->grow_if_necessary();
 
             group_index = this->index_for_hash(key_hash);
-            slot_index = this->find_empty_to_insert<false, KeyT>(key, group_index, ctrl_hash);
+            slot_index = this->find_empty_to_insert<false, KeyT>(key, group_index, ctrl_hash, key_hash);
             assert(slot_index < this->slot_capacity());
             return { slot_index, kNeedInsert };
         }
@@ -2253,10 +3548,15 @@ private:
     JSTD_FORCED_INLINE
     size_type no_grow_unique_insert(const key_type & key) {
         std::size_t key_hash = this->hash_for(key);
+        return this->no_grow_unique_insert(key, key_hash);
+    }
+
+    JSTD_FORCED_INLINE
+    size_type no_grow_unique_insert(const key_type & key, std::size_t key_hash) {
         size_type group_index = this->index_for_hash(key_hash);
         std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
 
-        size_type slot_index = this->find_empty_to_insert<true, key_type>(key, group_index, ctrl_hash);
+        size_type slot_index = this->find_empty_to_insert<true, key_type>(key, group_index, ctrl_hash, key_hash);
         return slot_index;
     }
 
@@ -2266,12 +3566,17 @@ private:
     JSTD_FORCED_INLINE
     void no_grow_unique_transfer_insert(slot_type * old_slot) {
         assert(old_slot != nullptr);
-        size_type slot_index = this->no_grow_unique_insert(old_slot->value.first);
+        this->no_grow_unique_transfer_insert(old_slot, this->hash_for(old_slot->get_key()));
+    }
+
+    JSTD_FORCED_INLINE
+    void no_grow_unique_transfer_insert(slot_type * old_slot, std::size_t key_hash) {
+        assert(old_slot != nullptr);
+        size_type slot_index = this->no_grow_unique_insert(old_slot->get_key(), key_hash);
         slot_type * new_slot = this->slot_at(slot_index);
         assert(new_slot != nullptr);
 
-        SlotPolicyTraits::construct(&this->slot_allocator_, new_slot, old_slot);
-        this->destroy_slot(old_slot);
+        SlotPolicyTraits::transfer(&this->slot_allocator_, new_slot, old_slot);
         this->slot_size_++;
         assert(this->slot_size() <= this->slot_capacity());
     }
@@ -2279,7 +3584,7 @@ private:
     JSTD_FORCED_INLINE
     void no_grow_unique_transfer_insert(group16_flat_table * other, slot_type * old_slot) {
         assert(old_slot != nullptr);
-        size_type slot_index = this->no_grow_unique_insert(old_slot->value.first);
+        size_type slot_index = this->no_grow_unique_insert(old_slot->get_key());
         slot_type * new_slot = this->slot_at(slot_index);
         assert(new_slot != nullptr);
 
@@ -2295,7 +3600,7 @@ private:
     JSTD_FORCED_INLINE
     void no_grow_unique_insert(const slot_type * old_slot) {
         assert(old_slot != nullptr);
-        size_type slot_index = this->no_grow_unique_insert(old_slot->value.first);
+        size_type slot_index = this->no_grow_unique_insert(old_slot->get_key());
         slot_type * new_slot = this->slot_at(slot_index);
         assert(new_slot != nullptr);
 
@@ -2334,6 +3639,39 @@ private:
         }
     }
 
+    //
+    // Update the mapped value of an existing key, only the maps do it (AlwaysUpdate),
+    // the sets have no mapped value.
+    //
+    template <typename ValueT>
+    JSTD_FORCED_INLINE
+    void copy_assign_mapped(slot_type * slot, const ValueT & value, std::true_type) {
+        SlotPolicyTraits::element(slot).second = value.second;
+    }
+
+    template <typename ValueT>
+    JSTD_FORCED_INLINE
+    void copy_assign_mapped(slot_type * slot, const ValueT & value, std::false_type) {
+        /* Do nothing */
+    }
+
+    template <bool IsRvalueRef, typename ValueT>
+    JSTD_FORCED_INLINE
+    void move_assign_mapped(slot_type * slot, ValueT & value, std::true_type) {
+        if (IsRvalueRef) {
+            //slot->value.second = std::move(value.second);
+            jstd::move_assign_if<IsRvalueRef>(SlotPolicyTraits::element(slot).second, value.second);
+        } else {
+            SlotPolicyTraits::element(slot).second = value.second;
+        }
+    }
+
+    template <bool IsRvalueRef, typename ValueT>
+    JSTD_FORCED_INLINE
+    void move_assign_mapped(slot_type * slot, ValueT & value, std::false_type) {
+        /* Do nothing */
+    }
+
     template <bool AlwaysUpdate, typename ValueT, typename std::enable_if<
               (jstd::is_same_ex<ValueT, value_type>::value ||
                std::is_constructible<value_type, const ValueT &>::value) ||
@@ -2341,7 +3679,7 @@ private:
                std::is_constructible<init_type, const ValueT &>::value)>::type * = nullptr>
     JSTD_FORCED_INLINE
     std::pair<iterator, bool> emplace_impl(const ValueT & value) {
-        auto find_info = this->find_or_insert(value.first);
+        auto find_info = this->find_or_insert(type_policy::extract(value));
         size_type slot_index = find_info.first;
         bool need_insert = find_info.second;        
         if (need_insert) {
@@ -2354,7 +3692,7 @@ private:
             // The key to be inserted already exists.
             if (AlwaysUpdate) {
                 slot_type * slot = this->slot_at(slot_index);
-                slot->value.second = value.second;
+                this->copy_assign_mapped(slot, value, std::integral_constant<bool, AlwaysUpdate>());
             }
         }
         return { this->iterator_at(slot_index), need_insert };
@@ -2368,7 +3706,7 @@ private:
     JSTD_FORCED_INLINE
     std::pair<iterator, bool> emplace_impl(ValueT && value) {
         static constexpr bool is_rvalue_ref = std::is_rvalue_reference<decltype(value)>::value;
-        auto find_info = this->find_or_insert(value.first);
+        auto find_info = this->find_or_insert(type_policy::extract(value));
         size_type slot_index = find_info.first;
         bool need_insert = find_info.second;
         if (need_insert) {
@@ -2376,21 +3714,13 @@ private:
             slot_type * slot = this->slot_at(slot_index);
             assert(slot != nullptr);
             assert(slot_index < this->slot_capacity());
-            SlotPolicyTraits::construct(&this->slot_allocator_, slot, std::move(value));
+            SlotPolicyTraits::construct(&this->slot_allocator_, slot, std::forward<ValueT>(value));
             this->slot_size_++;
         } else {
             // The key to be inserted already exists.
             if (AlwaysUpdate) {
                 slot_type * slot = this->slot_at(slot_index);
-                if (is_rvalue_ref) {
-                    //slot->value.second = std::move(value.second);
-                    if (kIsLayoutCompatible)
-                        jstd::move_assign_if<is_rvalue_ref>(slot->mutable_value.second, value.second);
-                    else
-                        jstd::move_assign_if<is_rvalue_ref>(slot->value.second, value.second);
-                } else {
-                    slot->value.second = value.second;
-                }
+                this->move_assign_mapped<is_rvalue_ref>(slot, value, std::integral_constant<bool, AlwaysUpdate>());
             }
         }
         return { this->iterator_at(slot_index), need_insert };
@@ -2425,10 +3755,10 @@ private:
             if (AlwaysUpdate) {
                 slot_type * slot = this->slot_at(slot_index);
                 if (isMappedType) {
-                    slot->value.second = std::forward<MappedT>(value);
+                    SlotPolicyTraits::element(slot).second = std::forward<MappedT>(value);
                 } else {
                     mapped_type mapped_value(std::forward<MappedT>(value));
-                    slot->value.second = std::move(mapped_value);
+                    SlotPolicyTraits::element(slot).second = std::move(mapped_value);
                 }
             }
         }
@@ -2463,7 +3793,7 @@ private:
             if (AlwaysUpdate) {
                 slot_type * slot = this->slot_at(slot_index);
                 mapped_type mapped_value(std::forward<Args>(args)...);
-                slot->value.second = std::move(mapped_value);
+                SlotPolicyTraits::element(slot).second = std::move(mapped_value);
             }
         }
         return { this->iterator_at(slot_index), need_insert };
@@ -2500,7 +3830,7 @@ private:
             if (AlwaysUpdate) {
                 tuple_wrapper2<mapped_type> mapped_wrapper(std::move(second));
                 slot_type * slot = this->slot_at(slot_index);
-                slot->value.second = std::move(mapped_wrapper.value());
+                SlotPolicyTraits::element(slot).second = std::move(mapped_wrapper.value());
             }
         }
         return { this->iterator_at(slot_index), need_insert };
@@ -2524,7 +3854,7 @@ private:
                                     std::forward<First>(first),
                                     std::forward<Args>(args)...);
 
-        auto find_info = this->find_or_insert(tmp_slot->value.first);
+        auto find_info = this->find_or_insert(tmp_slot->get_key());
         size_type slot_index = find_info.first;
         bool need_insert = find_info.second;
         if (need_insert) {
@@ -2538,10 +3868,10 @@ private:
             // The key to be inserted already exists.
             if (AlwaysUpdate) {
                 slot_type * slot = this->slot_at(slot_index);
-                slot->value.second = std::move(tmp_slot->value.second);
+                SlotPolicyTraits::element(slot).second = std::move(SlotPolicyTraits::element(tmp_slot).second);
             }
+            SlotPolicyTraits::destroy(&this->slot_allocator_, tmp_slot);
         }
-        SlotPolicyTraits::destroy(&this->slot_allocator_, tmp_slot);
         return { this->iterator_at(slot_index), need_insert };
     }
 
@@ -2585,6 +3915,376 @@ private:
         return { this->iterator_at(slot_index), need_insert };
     }
 
+    ///
+    /// Incremental rehash
+    ///
+    /// Each entry has a std::true_type overload which does the work, and
+    /// a std::false_type one for the tables without incremental_rehash_t,
+    /// so the disabled mode doesn't instantiate the code using state_.old_.
+    ///
+    bool is_migrating(std::false_type) const noexcept {
+        return false;
+    }
+
+    bool is_migrating(std::true_type) const noexcept {
+        return (this->state_.old_.groups != nullptr);
+    }
+
+    void finish_migration(std::false_type) noexcept {
+    }
+
+    void finish_migration(std::true_type) {
+        if (JSTD_UNLIKELY(this->is_migrating())) {
+            this->migrate_groups(this->state_.old_.group_mask + 1, std::true_type{});
+        }
+    }
+
+    ssize_type first_slot_index(std::false_type) const noexcept {
+        return 0;
+    }
+
+    ssize_type first_slot_index(std::true_type) const noexcept {
+        if (JSTD_LIKELY(!this->is_migrating()))
+            return 0;
+        else
+            return -static_cast<ssize_type>(this->state_.old_.slot_mask + 1);
+    }
+
+    const ctrl_type * old_ctrl_at(ssize_type slot_index, std::false_type) const noexcept {
+        JSTD_UNUSED(slot_index);
+        return nullptr;
+    }
+
+    const ctrl_type * old_ctrl_at(ssize_type slot_index, std::true_type) const noexcept {
+        assert(slot_index >= this->first_slot_index() && slot_index < 0);
+        const ctrl_type * old_ctrls = reinterpret_cast<const ctrl_type *>(this->state_.old_.groups);
+        return (old_ctrls + std::ptrdiff_t(slot_index - this->first_slot_index()));
+    }
+
+    const slot_type * old_slot_at(ssize_type slot_index, std::false_type) const noexcept {
+        JSTD_UNUSED(slot_index);
+        return nullptr;
+    }
+
+    const slot_type * old_slot_at(ssize_type slot_index, std::true_type) const noexcept {
+        assert(slot_index >= this->first_slot_index() && slot_index < 0);
+        return (this->state_.old_.slots + std::ptrdiff_t(slot_index - this->first_slot_index()));
+    }
+
+    //
+    // The negative index of an old slot, see first_slot_index().
+    //
+    ssize_type old_index_of(const slot_type * old_slot) const noexcept {
+        return this->old_index_of(old_slot, incremental_rehash_t{});
+    }
+
+    ssize_type old_index_of(const slot_type * old_slot, std::false_type) const noexcept {
+        JSTD_UNUSED(old_slot);
+        return 0;
+    }
+
+    ssize_type old_index_of(const slot_type * old_slot, std::true_type) const noexcept {
+        return (this->first_slot_index() + (old_slot - this->state_.old_.slots));
+    }
+
+    void start_migration(size_type new_capacity) {
+        this->start_migration(new_capacity, incremental_rehash_t{});
+    }
+
+    void start_migration(size_type new_capacity, std::false_type) {
+        this->rehash_impl<false>(new_capacity);
+    }
+
+    JSTD_NO_INLINE
+    void start_migration(size_type new_capacity, std::true_type) {
+        this->finish_migration();
+        this->reset_stale_groups();
+
+        new_capacity = this->calc_capacity(new_capacity);
+        assert(new_capacity > this->ctrl_capacity());
+
+        old_table_type old_table;
+        old_table.groups = this->groups();
+        old_table.slots = this->slots();
+        old_table.slot_size = this->slot_size();
+        old_table.slot_mask = this->slot_mask();
+        old_table.group_mask = this->group_mask();
+#if GROUP16_USE_INDEX_SHIFT
+        old_table.index_shift = this->index_shift_;
+#endif
+        old_table.migrate_index = 0;
+        old_table.groups_alloc = this->groups_alloc();
+        assert(old_table.groups != this_type::default_empty_groups());
+
+        this->create_slots<false>(new_capacity);
+
+        // slot_size() is still the total size of the both arrays.
+        this->slot_size_ = old_table.slot_size;
+        this->state_.old_ = old_table;
+    }
+
+    void migrate_groups(size_type max_groups) {
+        this->migrate_groups(max_groups, incremental_rehash_t{});
+    }
+
+    void migrate_groups(size_type max_groups, std::false_type) noexcept {
+        JSTD_UNUSED(max_groups);
+    }
+
+    JSTD_NO_INLINE
+    void migrate_groups(size_type max_groups, std::true_type) {
+        assert(this->is_migrating());
+        auto mask_bits = group_type::make_mask_bits();
+        size_type old_group_capacity = this->state_.old_.group_mask + 1;
+        size_type group_index = this->state_.old_.migrate_index;
+        size_type last_index = (max_groups < (old_group_capacity - group_index)) ?
+                               (group_index + max_groups) : old_group_capacity;
+
+        for (; group_index < last_index; group_index++) {
+            if (JSTD_UNLIKELY(this->state_.old_.slot_size == 0)) {
+                break;
+            }
+            group_type * group = this->state_.old_.groups + group_index;
+            slot_type * slot_base = this->state_.old_.slots + group_index * kGroupWidth;
+            std::uint32_t used_mask = group->match_used(mask_bits);
+            while (used_mask != 0) {
+                std::uint32_t used_pos = BitUtils::bsf32(used_mask);
+                used_mask = BitUtils::clearLowBit32(used_mask);
+                this->migrate_slot(group, used_pos, slot_base + used_pos);
+            }
+        }
+
+        this->state_.old_.migrate_index = group_index;
+        if ((this->state_.old_.slot_size == 0) || (group_index >= old_group_capacity)) {
+            assert(this->state_.old_.slot_size == 0);
+            this->free_old_table();
+        }
+    }
+
+    JSTD_FORCED_INLINE
+    size_type migrate_slot(group_type * old_group, size_type pos, slot_type * old_slot) {
+        std::size_t key_hash = this->stored_hash_for(this->state_.old_.groups, this->state_.old_.group_mask + 1,
+                                                     old_slot - this->state_.old_.slots, old_slot->get_key());
+        size_type slot_index = this->no_grow_unique_insert(old_slot->get_key(), key_hash);
+        slot_type * new_slot = this->slot_at(slot_index);
+        SlotPolicyTraits::transfer(&this->slot_allocator_, new_slot, old_slot);
+        // The overflow bit is kept, so the probe chains of the old arrays are still valid.
+        old_group->set_empty(pos);
+        assert(this->state_.old_.slot_size > 0);
+        this->state_.old_.slot_size--;
+        return slot_index;
+    }
+
+    JSTD_FORCED_INLINE
+    size_type migrate_old_slot(slot_type * old_slot) {
+        size_type old_index = static_cast<size_type>(old_slot - this->state_.old_.slots);
+        group_type * old_group = this->state_.old_.groups + old_index / kGroupWidth;
+        return this->migrate_slot(old_group, old_index % kGroupWidth, old_slot);
+    }
+
+    void erase_old_slot(slot_type * old_slot) {
+        this->erase_old_slot(old_slot, incremental_rehash_t{});
+    }
+
+    void erase_old_slot(slot_type * old_slot, std::false_type) noexcept {
+        JSTD_UNUSED(old_slot);
+    }
+
+    JSTD_FORCED_INLINE
+    void erase_old_slot(slot_type * old_slot, std::true_type) {
+        size_type old_index = static_cast<size_type>(old_slot - this->state_.old_.slots);
+        group_type * old_group = this->state_.old_.groups + old_index / kGroupWidth;
+        this->destroy_slot(old_slot);
+        old_group->set_empty(old_index % kGroupWidth);
+        assert(this->state_.old_.slot_size > 0);
+        this->state_.old_.slot_size--;
+        assert(this->slot_size_ > 0);
+        this->slot_size_--;
+    }
+
+    void free_old_table() noexcept {
+        size_type old_group_capacity = this->state_.old_.group_mask + 1;
+        size_type old_slot_capacity = this->state_.old_.slot_mask + 1;
+#if GROUP16_USE_SEPARATE_SLOTS
+        size_type total_group_alloc_count = this->TotalGroupAllocCount<kGroupAlignment>(old_group_capacity);
+        GroupAllocTraits::deallocate(this->group_allocator_, this->state_.old_.groups_alloc, total_group_alloc_count);
+        SlotAllocTraits::deallocate(this->slot_allocator_, this->state_.old_.slots, old_slot_capacity);
+#else
+        size_type total_slot_alloc_count = this->TotalSlotAllocCount<kGroupAlignment>(
+                                                 old_group_capacity, old_slot_capacity);
+        SlotAllocTraits::deallocate(this->slot_allocator_, this->state_.old_.slots, total_slot_alloc_count);
+#endif
+        this->state_.old_ = old_table_type();
+    }
+
+    void destroy_old_table() {
+        this->destroy_old_table(incremental_rehash_t{});
+    }
+
+    void destroy_old_table(std::false_type) noexcept {
+    }
+
+    void destroy_old_table(std::true_type) {
+        if (JSTD_LIKELY(!this->is_migrating())) {
+            return;
+        }
+        if (!is_slot_trivial_destructor) {
+            auto mask_bits = group_type::make_mask_bits();
+            size_type old_group_capacity = this->state_.old_.group_mask + 1;
+            for (size_type group_index = this->state_.old_.migrate_index;
+                 group_index < old_group_capacity; group_index++) {
+                const group_type * group = this->state_.old_.groups + group_index;
+                slot_type * slot_base = this->state_.old_.slots + group_index * kGroupWidth;
+                std::uint32_t used_mask = group->match_used(mask_bits);
+                while (used_mask != 0) {
+                    std::uint32_t used_pos = BitUtils::bsf32(used_mask);
+                    used_mask = BitUtils::clearLowBit32(used_mask);
+                    this->destroy_slot(slot_base + used_pos);
+                }
+            }
+        }
+        assert(this->slot_size_ >= this->state_.old_.slot_size);
+        this->slot_size_ -= this->state_.old_.slot_size;
+        this->free_old_table();
+    }
+
+    JSTD_FORCED_INLINE
+    size_type old_index_for_hash(std::size_t key_hash) const noexcept {
+        if (kUseIndexSalt) {
+            key_hash ^= (size_type)((std::uintptr_t)this->state_.old_.groups >> 12);
+        }
+#if GROUP16_USE_INDEX_SHIFT
+        return static_cast<size_type>(key_hash >> this->state_.old_.index_shift);
+#else
+        return (((size_type)key_hash & this->state_.old_.slot_mask) / kGroupWidth);
+#endif
+    }
+
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    slot_type * find_in_old_table(const KeyT & key, std::size_t key_hash) const {
+        return this->find_in_old_table(key, key_hash, incremental_rehash_t{});
+    }
+
+    template <typename KeyT>
+    slot_type * find_in_old_table(const KeyT & key, std::size_t key_hash, std::false_type) const noexcept {
+        JSTD_UNUSED(key);
+        JSTD_UNUSED(key_hash);
+        return nullptr;
+    }
+
+    template <typename KeyT>
+    JSTD_NO_INLINE
+    slot_type * find_in_old_table(const KeyT & key, std::size_t key_hash, std::true_type) const {
+        assert(this->is_migrating());
+        size_type group_index = this->old_index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
+        auto hash_bits = group_type::make_hash_bits(ctrl_hash);
+        auto mask_bits = group_type::make_mask_bits();
+        prober_type prober(group_index);
+
+        do {
+            group_index = prober.get();
+            const group_type * group = this->state_.old_.groups + group_index;
+            std::uint32_t match_mask = group->match_hash(hash_bits, mask_bits);
+            if (match_mask != 0) {
+                slot_type * slot_base = this->state_.old_.slots + group_index * kGroupWidth;
+                do {
+                    std::uint32_t match_pos = BitUtils::bsf32(match_mask);
+                    slot_type * slot = slot_base + match_pos;
+                    if (this->key_equal_(key, slot->get_key())) {
+                        return slot;
+                    }
+                    match_mask = BitUtils::clearLowBit32(match_mask);
+                } while (match_mask != 0);
+            }
+
+            // If it's not overflow, means it hasn't been found.
+            if (group->is_not_overflow(ctrl_hash)) {
+                return nullptr;
+            }
+        } while (prober.next_bucket(this->state_.old_.group_mask));
+
+        return nullptr;
+    }
+
+    //
+    // A hit in the old arrays is migrated at once, so the index always refers to the new arrays.
+    //
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    size_type find_index_migrating(const KeyT & key) {
+        return this->find_index_migrating(key, incremental_rehash_t{});
+    }
+
+    template <typename KeyT>
+    size_type find_index_migrating(const KeyT & key, std::false_type) {
+        return this->find_index(key);
+    }
+
+    template <typename KeyT>
+    JSTD_NO_INLINE
+    size_type find_index_migrating(const KeyT & key, std::true_type) {
+        this->migrate_groups(kMigrateGroupsPerStep);
+
+        std::size_t key_hash = this->hash_for(key);
+        size_type group_index = this->index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
+
+        size_type slot_index = this->find_index(key, group_index, ctrl_hash, key_hash);
+        if ((slot_index == this->slot_capacity()) && this->is_migrating()) {
+            slot_type * old_slot = this->find_in_old_table(key, key_hash);
+            if (old_slot != nullptr) {
+                slot_index = this->migrate_old_slot(old_slot);
+            }
+        }
+        return slot_index;
+    }
+
+    template <typename KeyT>
+    JSTD_FORCED_INLINE
+    std::pair<size_type, bool> find_or_insert_migrating(const KeyT & key) {
+        return this->find_or_insert_migrating(key, incremental_rehash_t{});
+    }
+
+    template <typename KeyT>
+    std::pair<size_type, bool> find_or_insert_migrating(const KeyT & key, std::false_type) {
+        JSTD_UNUSED(key);
+        return { this->slot_capacity(), kIsKeyExists };
+    }
+
+    template <typename KeyT>
+    JSTD_NO_INLINE
+    std::pair<size_type, bool> find_or_insert_migrating(const KeyT & key, std::true_type) {
+        this->migrate_groups(kMigrateGroupsPerStep);
+
+        std::size_t key_hash = this->hash_for(key);
+        size_type group_index = this->index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
+
+        size_type slot_index = this->find_index(key, group_index, ctrl_hash, key_hash);
+        if (slot_index != this->slot_capacity()) {
+            return { slot_index, kIsKeyExists };
+        }
+
+        if (this->is_migrating()) {
+            slot_type * old_slot = this->find_in_old_table(key, key_hash);
+            if (old_slot != nullptr) {
+                slot_index = this->migrate_old_slot(old_slot);
+                return { slot_index, kIsKeyExists };
+            }
+        }
+
+        if (JSTD_UNLIKELY(this->need_grow())) {
+            // It will finish the pending migration first.
+            this->grow_if_necessary();
+            group_index = this->index_for_hash(key_hash);
+        }
+
+        slot_index = this->find_empty_to_insert<false, KeyT>(key, group_index, ctrl_hash, key_hash);
+        return { slot_index, kNeedInsert };
+    }
+
     JSTD_FORCED_INLINE
     bool maybe_caused_overflow(ctrl_type * ctrl) const noexcept {
         std::uintptr_t ngroup = reinterpret_cast<std::uintptr_t>(ctrl) & (~(kGroupWidth - 1));
@@ -2614,17 +4314,26 @@ private:
 
     JSTD_FORCED_INLINE
     size_type find_and_erase(const key_type & key) {
+        if (JSTD_UNLIKELY(this->is_migrating())) {
+            this->migrate_groups(kMigrateGroupsPerStep);
+        }
+
         std::size_t key_hash = this->hash_for(key);
         size_type group_index = this->index_for_hash(key_hash);
         std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
 
-        size_type slot_index = this->find_index(key, group_index, ctrl_hash);
+        size_type slot_index = this->find_index(key, group_index, ctrl_hash, key_hash);
         if (slot_index != this->slot_capacity()) {
             this->erase_slot(slot_index);
             return 1;
-        } else {
-            return 0;
+        } else if (JSTD_UNLIKELY(this->is_migrating())) {
+            slot_type * old_slot = this->find_in_old_table(key, key_hash);
+            if (old_slot != nullptr) {
+                this->erase_old_slot(old_slot);
+                return 1;
+            }
         }
+        return 0;
     }
 
     // TODO: Optimize this assuming *this and other don't overlap.
@@ -2662,6 +4371,7 @@ private:
 #if GROUP16_USE_SEPARATE_SLOTS
         swap(this->groups_alloc_, other.groups_alloc_);
 #endif
+        swap(this->state_, other.state_);
     }
 
     JSTD_FORCED_INLINE
@@ -308,6 +308,15 @@ public:
         table_.rehash(new_capacity);
     }
 
+    // Reinsert the old elements by thread_count threads, 0 is hardware_concurrency().
+    void reserve(size_type new_capacity, size_type thread_count) {
+        table_.reserve(new_capacity, thread_count);
+    }
+
+    void rehash(size_type new_capacity, size_type thread_count) {
+        table_.rehash(new_capacity, thread_count);
+    }
+
     void shrink_to_fit(bool read_only = false) {
         table_.shrink_to_fit(read_only);
     }
@@ -81,6 +81,7 @@
 #include "jstd/hashmap/group_quadratic_prober.hpp"
 
 #include "jstd/hashmap/detail/hashmap_traits.h"
+#include "jstd/hashmap/detail/parallel_run.h"
 
 #include "jstd/hashmap/flat_map_type_policy.hpp"
 #include "jstd/hashmap/flat_map_slot_policy.hpp"
@@ -138,7 +139,7 @@ public:
     static constexpr size_type npos = static_cast<size_type>(-1);
 
     using ctrl_type = jstd::group30_meta_ctrl;
-    using group_type = jstd::flat_map_group15<group30_meta_ctrl>;
+    using group_type = jstd::flat_map_group30<group30_meta_ctrl>;
     using prober_type = jstd::group_quadratic_prober;
 
     static constexpr const std::uint8_t kEmptySlot    = ctrl_type::kEmptySlot;
@@ -178,6 +179,19 @@ public:
             (jstd::is_plain_type<key_type>::value &&
              jstd::is_plain_type<mapped_type>::value));
 
+    // The slots can be moved to the new place by memcpy, and the old ones are not destroyed.
+    static constexpr bool kIsRelocatableSlot = (std::is_trivially_copy_constructible<element_type>::value ||
+             jstd::is_trivially_relocatable<element_type>::value) &&
+            (jstd::is_std_allocator<Allocator>::value ||
+            !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value);
+
+    // The slots are transferred without any exception, the parallel rehash relies on it.
+    static constexpr bool kIsNothrowTransfer = kIsRelocatableSlot ||
+            (std::is_nothrow_move_constructible<typename std::conditional<kIsLayoutCompatible,
+                                                std::pair<key_type, mapped_type>, value_type>::type>::value &&
+            (jstd::is_std_allocator<Allocator>::value ||
+            !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value));
+
     static constexpr size_type kWordLength = sizeof(std::size_t) * CHAR_BIT;
     static constexpr size_type kSizeTypeLength = sizeof(std::size_t);
 
@@ -236,6 +250,9 @@ public:
 
     static constexpr size_type kSkipGroupsLimit = 5;
 
+    // The parallel rehash is only used when the old table has at least so many elements.
+    static constexpr size_type kMinParallelRehashSize = 65536;
+
     using group_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<group_type>;
     using slot_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<slot_type>;
 
@@ -757,6 +774,30 @@ public:
         }
     }
 
+    //
+    // Same as reserve() and rehash(), but the old slots are reinserted by
+    // thread_count threads, thread_count = 0 means std::thread::hardware_concurrency().
+    // It's used to cut the pause of growing a very large table.
+    //
+    void reserve(size_type new_capacity, size_type thread_count) {
+        if (JSTD_LIKELY(new_capacity != 0)) {
+            new_capacity = this->shrink_to_fit_capacity(new_capacity);
+            this->rehash_impl<false>(new_capacity, thread_count);
+        } else {
+            this->destroy<true>();
+        }
+    }
+
+    void rehash(size_type new_capacity, size_type thread_count) {
+        size_type fit_to_now = this->shrink_to_fit_capacity(this->size());
+        new_capacity = (std::max)(fit_to_now, new_capacity);
+        if (JSTD_LIKELY(new_capacity != 0)) {
+            this->rehash_impl<false>(new_capacity, thread_count);
+        } else {
+            this->destroy<true>();
+        }
+    }
+
     JSTD_FORCED_INLINE
     void shrink_to_fit(bool read_only = false) {
         size_type new_capacity;
@@ -1188,18 +1229,27 @@ public:
 
 private:
     static inline group_type * default_empty_groups() noexcept {
-        alignas(16) static const ctrl_type s_empty_ctrls[kGroupWidth * 2] = {
+        // The same layout as a group: kGroupSize ctrls, then the overflow masks.
+        alignas(32) static const ctrl_type s_empty_ctrls[kGroupWidth * 2] = {
             // Group 0
             { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
             { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
             { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
-            { kEmptySlot }, { kEmptySlot }, { kSentinelSlot }, { 0 },
+            { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
+            { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
+            { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
+            { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
+            { kEmptySlot }, { kSentinelSlot }, { 0 }, { 0 },
 
             // Group 1
             { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
             { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
             { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
-            { kEmptySlot }, { kEmptySlot }, { kSentinelSlot }, { 0 },
+            { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
+            { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
+            { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
+            { kEmptySlot }, { kEmptySlot }, { kEmptySlot }, { kEmptySlot },
+            { kEmptySlot }, { kSentinelSlot }, { 0 }, { 0 },
         };
 
         return reinterpret_cast<group_type *>(const_cast<ctrl_type *>(&s_empty_ctrls[0]));
@@ -1722,7 +1772,7 @@ private:
          */
         std::memcpy(
             reinterpret_cast<unsigned char *>(this->slots()),
-            reinterpret_cast<unsigned char *>(other.slots()),
+            reinterpret_cast<const unsigned char *>(other.slots()),
             other.slot_capacity() * sizeof(slot_type));
     }
 
@@ -1860,9 +1910,7 @@ private:
     void move_slots_array_from(group30_flat_table & other) {
         this->move_slots_array_from(
             other,
-            std::integral_constant<bool, std::is_trivially_copy_constructible<element_type>::value &&
-                                        (jstd::is_std_allocator<Allocator>::value ||
-                                        !jstd::alloc_has_construct<Allocator, value_type *, const value_type &>::value)>{}
+            std::integral_constant<bool, kIsRelocatableSlot>{}
         );
     }
 
@@ -1870,15 +1918,18 @@ private:
     void move_slots_array_from(group30_flat_table & other, std::true_type /* -> memcpy */) {
         /*
          * reinterpret_cast: GCC may complain about value_type not being trivially
-         * copy-assignable when we're relying on trivial copy constructibility.
+         * copy-assignable when we're relying on trivial copy constructibility
+         * or the trivial relocatability.
          */
         std::memcpy(
             reinterpret_cast<unsigned char *>(this->slots()),
             reinterpret_cast<unsigned char *>(other.slots()),
             other.slot_capacity() * sizeof(slot_type));
 
-        // Reset all of other slots
-        std::fill_n(other.slots(), other.slot_capacity(), slot_type());
+        // move_groups_array_from() only copies the groups, the other groups still mark
+        // the relocated elements as used, they must not be destroyed there. The caller
+        // releases the other table by destroy<false>(), it frees the arrays without
+        // destroying the slots.
     }
 
     JSTD_FORCED_INLINE
@@ -2106,7 +2157,7 @@ private:
 
     template <bool AllowShrink>
     JSTD_NO_INLINE
-    void rehash_impl(size_type new_capacity) {
+    void rehash_impl(size_type new_capacity, size_type thread_count = 1) {
         new_capacity = this->calc_capacity(new_capacity);
         assert(new_capacity > 0);
         assert(new_capacity >= kMinCapacity);
@@ -2127,7 +2178,12 @@ private:
 
             this->create_slots<false>(new_capacity);
 
-            if (old_groups != this_type::default_empty_groups()) {
+            if ((old_groups != this_type::default_empty_groups()) &&
+                !this->try_parallel_transfer(old_groups, old_group_capacity, old_slots,
+                                             old_slot_size, thread_count)) {
+                // With GROUP30_USE_INDEX_SHIFT, the home index is the high bits of the hash,
+                // so the old groups are scanned in the order of their new home regions, and
+                // this loop already writes the new arrays region by region, except the probed slots.
                 assert(old_groups != nullptr);
                 assert(old_slots != nullptr);
                 assert(old_group_capacity > 0);
@@ -2182,6 +2238,160 @@ private:
         }
     }
 
+    struct rehash_item {
+        slot_type *  slot;
+        std::size_t  key_hash;
+    };
+
+    //
+    // Transfer the old slots by several threads, in three phases:
+    //
+    //   1. Each thread hashes a range of the old groups, and scatters the slots
+    //      into the buckets of the new group partition where their home group is.
+    //   2. Each thread inserts the slots of one partition, the probe never leaves
+    //      the partition, so the threads never write the same group. The slots
+    //      whose probe would leave the partition are kept in the buckets.
+    //   3. The calling thread inserts the remaining slots.
+    //
+    // Returns false if it isn't worth it or the buckets can't be allocated,
+    // the old slots are untouched then. A transfer mustn't throw in the threads,
+    // so the slots whose move may throw always take the serial loop.
+    //
+    JSTD_NO_INLINE
+    bool try_parallel_transfer(group_type * old_groups, size_type old_group_capacity,
+                               slot_type * old_slots, size_type old_slot_size,
+                               size_type thread_count) {
+        if (!kIsNothrowTransfer || (thread_count == 1) || (old_slot_size < kMinParallelRehashSize))
+            return false;
+
+        size_type new_group_capacity = this->group_capacity();
+        thread_count = jstd::detail::clamp_rehash_threads(thread_count);
+        thread_count = (std::min)(thread_count, new_group_capacity);
+        if (thread_count <= 1)
+            return false;
+
+        size_type part_groups = (new_group_capacity + thread_count - 1) / thread_count;
+
+        std::vector<std::vector<rehash_item>> buckets;
+        std::vector<size_type> inserted_counts;
+        std::vector<std::uint8_t> is_failed;
+        try {
+            buckets.resize(thread_count * thread_count);
+            inserted_counts.resize(thread_count, 0);
+            is_failed.resize(thread_count, 0);
+        } catch (...) {
+            return false;
+        }
+
+        // Phase 1: scatter
+        jstd::detail::parallel_run(thread_count, [&](size_type index) {
+            size_type first_group = old_group_capacity * index / thread_count;
+            size_type last_group  = old_group_capacity * (index + 1) / thread_count;
+            std::vector<rehash_item> * part_buckets = &buckets[index * thread_count];
+            try {
+                for (size_type group_index = first_group; group_index < last_group; group_index++) {
+                    const group_type * group = old_groups + group_index;
+                    slot_type * slot_base = old_slots + group_index * kGroupSize;
+                    std::uint32_t used_mask = group->match_used();
+                    while (used_mask != 0) {
+                        std::uint32_t used_pos = BitUtils::bsf32(used_mask);
+                        if (JSTD_UNLIKELY(group->is_sentinel(used_pos)))
+                            break;
+                        used_mask = BitUtils::clearLowBit32(used_mask);
+                        slot_type * old_slot = slot_base + used_pos;
+                        std::size_t key_hash = this->hash_for(old_slot->get_key());
+                        size_type part = this->index_for_hash(key_hash) / part_groups;
+                        assert(part < thread_count);
+                        part_buckets[part].push_back({ old_slot, key_hash });
+                    }
+                }
+            } catch (...) {
+                is_failed[index] = 1;
+            }
+        });
+
+        for (size_type i = 0; i < thread_count; i++) {
+            if (is_failed[i] != 0)
+                return false;
+        }
+
+        // Phase 2: insert by partition
+        jstd::detail::parallel_run(thread_count, [&](size_type part) {
+            size_type first_group = part * part_groups;
+            size_type last_group  = (std::min)(first_group + part_groups, new_group_capacity);
+            size_type inserted = 0;
+            for (size_type i = 0; i < thread_count; i++) {
+                std::vector<rehash_item> & bucket = buckets[i * thread_count + part];
+                size_type remain = 0;
+                for (size_type n = 0; n < bucket.size(); n++) {
+                    const rehash_item & item = bucket[n];
+                    slot_type * new_slot = this->find_empty_in_range(item.key_hash, first_group, last_group);
+                    if (JSTD_LIKELY(new_slot != nullptr)) {
+                        this->transfer_slot(new_slot, item.slot);
+                        inserted++;
+                    } else {
+                        bucket[remain++] = item;
+                    }
+                }
+                bucket.resize(remain);
+            }
+            inserted_counts[part] = inserted;
+        });
+
+        // Phase 3: the remaining slots
+        for (size_type i = 0; i < buckets.size(); i++) {
+            for (const rehash_item & item : buckets[i]) {
+                size_type group_index = this->index_for_hash(item.key_hash);
+                std::size_t ctrl_hash = this->ctrl_for_hash(item.key_hash);
+                locator_t locator = this->find_empty_to_insert<true, key_type>(
+                                          item.slot->get_key(), group_index, ctrl_hash);
+                assert(locator.slot() != nullptr);
+                this->transfer_slot(locator.slot(), item.slot);
+                this->slot_size_++;
+            }
+        }
+
+        for (size_type i = 0; i < thread_count; i++) {
+            this->slot_size_ += inserted_counts[i];
+        }
+        assert(this->slot_size() <= this->slot_capacity());
+        return true;
+    }
+
+    //
+    // Same as find_empty_to_insert<true>(), but only probe the groups in [first_group, last_group),
+    // returns nullptr if the probe leaves the range.
+    //
+    JSTD_FORCED_INLINE
+    slot_type * find_empty_in_range(std::size_t key_hash, size_type first_group, size_type last_group) {
+        size_type group_index = this->index_for_hash(key_hash);
+        std::size_t ctrl_hash = this->ctrl_for_hash(key_hash);
+        prober_type prober(group_index);
+
+        do {
+            group_index = prober.get();
+            if ((group_index < first_group) || (group_index >= last_group))
+                break;
+            group_type * group = this->groups() + group_index;
+            std::uint32_t empty_mask = group->match_empty();
+            if (JSTD_LIKELY(empty_mask != 0)) {
+                std::uint32_t empty_pos = BitUtils::bsf32(empty_mask);
+                group->set_used(empty_pos, ctrl_hash);
+                return (this->slots() + group_index * kGroupSize + empty_pos);
+            } else {
+                group->set_overflow(ctrl_hash);
+            }
+        } while (prober.next_bucket(this->group_mask()));
+
+        return nullptr;
+    }
+
+    JSTD_FORCED_INLINE
+    void transfer_slot(slot_type * new_slot, slot_type * old_slot) {
+        SlotPolicyTraits::construct(&this->slot_allocator_, new_slot, old_slot);
+        this->destroy_slot(old_slot);
+    }
+
     JSTD_FORCED_INLINE
     void construct_slot(slot_type * slot) {
         SlotPolicyTraits::construct(&this->slot_allocator_, slot);
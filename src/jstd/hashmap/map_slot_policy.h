@@ -23,6 +23,7 @@
 #include <memory>       // For std::allocator<T>
 #include <utility>      // For std::pair<First, Second>
 #include <type_traits>
+#include <cstring>      // For std::memcpy()
 
 #include "jstd/basic/stddef.h"
 #include "jstd/lang/launder.h"
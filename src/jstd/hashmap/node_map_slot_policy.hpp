@@ -0,0 +1,174 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2018-2024 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+  -------------------------------------------------------------------
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_NODE_MAP_SLOT_POLICY_HPP
+#define JSTD_HASHMAP_NODE_MAP_SLOT_POLICY_HPP
+
+#pragma once
+
+#include <memory>       // For std::allocator_traits<T>
+#include <utility>      // For std::pair<First, Second>, std::swap()
+#include <type_traits>
+
+#include "jstd/basic/stddef.h"
+#include "jstd/traits/type_traits.h"
+
+namespace jstd {
+
+//
+// The slot of the node maps only stores the pointer of the node, the node
+// (the key-value pair) is allocated separately, so it never moves once
+// it's inserted, and the rehash only moves the pointers.
+//
+template <typename Key, typename Value>
+struct JSTD_DLL node_map_slot_type {
+public:
+    using key_type = typename std::remove_const<Key>::type;
+    using mapped_type = typename std::remove_const<Value>::type;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using mutable_value_type = std::pair<key_type, mapped_type>;
+    using init_type = std::pair<key_type, mapped_type>;
+    using element_type = value_type;
+
+    static constexpr const bool kIsLayoutCompatible = false;
+
+    value_type * node;
+
+    inline const key_type & get_key() const noexcept {
+        return this->node->first;
+    }
+};
+
+template <typename SlotType>
+class JSTD_DLL node_map_slot_policy {
+public:
+    using slot_type = SlotType;
+    using key_type = typename slot_type::key_type;
+    using mapped_type = typename slot_type::mapped_type;
+    using value_type = typename slot_type::value_type;
+    using mutable_value_type = typename slot_type::mutable_value_type;
+    using init_type = typename slot_type::init_type;
+    using element_type = typename slot_type::element_type;
+
+    // The slots only hold the pointers of the nodes, see slot_policy_traits.
+    using node_based = std::true_type;
+
+    using this_type = node_map_slot_policy<SlotType>;
+
+private:
+    template <typename Allocator>
+    using node_allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+
+    template <typename Allocator>
+    using node_alloc_traits_t = std::allocator_traits<node_allocator_t<Allocator>>;
+
+    template <typename Allocator, typename ... Args>
+    static value_type * new_node(Allocator * alloc, Args && ... args) {
+        node_allocator_t<Allocator> node_allocator(*alloc);
+        value_type * node = node_alloc_traits_t<Allocator>::allocate(node_allocator, 1);
+        try {
+            node_alloc_traits_t<Allocator>::construct(node_allocator, node, std::forward<Args>(args)...);
+        } catch (...) {
+            node_alloc_traits_t<Allocator>::deallocate(node_allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+public:
+    static value_type & element(slot_type * slot) {
+        return *slot->node;
+    }
+
+    static const value_type & element(const slot_type * slot) {
+        return *slot->node;
+    }
+
+    template <typename Allocator, typename ... Args>
+    static void construct(Allocator * alloc, slot_type * slot, Args && ... args) {
+        slot->node = this_type::new_node(alloc, std::forward<Args>(args)...);
+    }
+
+    //
+    // Construct this slot by moving from another slot, the node of the other slot
+    // is still owned by it, because it may belong to the other allocator.
+    //
+    template <typename Allocator>
+    static void construct(Allocator * alloc, slot_type * slot, slot_type * other) {
+        slot->node = this_type::new_node(alloc, std::move(*other->node));
+    }
+
+    //
+    // Construct this slot by copying from another slot.
+    //
+    template <typename Allocator>
+    static void construct(Allocator * alloc, slot_type * slot, const slot_type * other) {
+        slot->node = this_type::new_node(alloc, *other->node);
+    }
+
+    template <typename Allocator>
+    static void destroy(Allocator * alloc, slot_type * slot) {
+        node_allocator_t<Allocator> node_allocator(*alloc);
+        node_alloc_traits_t<Allocator>::destroy(node_allocator, slot->node);
+        node_alloc_traits_t<Allocator>::deallocate(node_allocator, slot->node, 1);
+    }
+
+    //
+    // Only the pointer is moved, the node stays where it is.
+    //
+    template <typename Allocator>
+    static void transfer(Allocator * alloc, slot_type * new_slot, slot_type * old_slot) {
+        JSTD_UNUSED(alloc);
+        new_slot->node = old_slot->node;
+    }
+
+    template <typename Allocator>
+    static void swap(Allocator * alloc, slot_type * slot1, slot_type * slot2, slot_type * tmp) {
+        JSTD_UNUSED(alloc);
+        JSTD_UNUSED(tmp);
+        std::swap(slot1->node, slot2->node);
+    }
+
+    template <typename Allocator>
+    static void exchange(Allocator * alloc, slot_type * src, slot_type * dest, slot_type * empty) {
+        JSTD_UNUSED(alloc);
+        empty->node = dest->node;
+        dest->node = src->node;
+    }
+
+    static std::size_t extra_space(const slot_type *) {
+        return sizeof(value_type);
+    }
+
+    template <typename First, typename ... Args>
+    static decltype(jstd::DecomposePair2(std::declval<First>(), std::declval<Args>()...))
+    apply(First && f, Args &&... args) {
+        return jstd::DecomposePair2(std::forward<First>(f), std::forward<Args>(args)...);
+    }
+
+    static mapped_type & value(value_type * kv) {
+        return kv->second;
+    }
+
+    static const mapped_type & value(const value_type * kv) {
+        return kv->second;
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_NODE_MAP_SLOT_POLICY_HPP
@@ -0,0 +1,85 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2024-2025 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+*************************************************************************************
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+  You are free to:
+
+    1. Share -- copy and redistribute the material in any medium or format.
+
+    2. Adapt -- remix, transforn, and build upon the material for any purpose,
+    even commerically.
+
+    The licensor cannot revoke these freedoms as long as you follow the license terms.
+
+  Under the following terms:
+
+    * Attribution -- You must give appropriate credit, provide a link to the license,
+    and indicate if changes were made. You may do so in any reasonable manner,
+    but not in any way that suggests the licensor endorses you or your use.
+
+    * ShareAlike -- If you remix, transform, or build upon the material, you must
+    distribute your contributions under the same license as the original.
+
+    * No additional restrictions -- You may not apply legal terms or technological
+    measures that legally restrict others from doing anything the license permits.
+
+  Notices:
+
+    * You do not have to comply with the license for elements of the material
+    in the public domain or where your use is permitted by an applicable exception
+    or limitation.
+
+    * No warranties are given. The license may not give you all of the permissions
+    necessary for your intended use. For example, other rights such as publicity,
+    privacy, or moral rights may limit how you use the material.
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_NODE_MAP_TYPE_POLICY_HPP
+#define JSTD_HASHMAP_NODE_MAP_TYPE_POLICY_HPP
+
+#pragma once
+
+#include <type_traits>
+#include <utility>          // For std::pair<F, S>
+
+#include "jstd/basic/stddef.h"
+#include "jstd/traits/type_traits.h"
+#include "jstd/hashmap/flat_map_type_policy.hpp"
+#include "jstd/hashmap/node_map_slot_policy.hpp"
+
+namespace jstd {
+
+//
+// The same as flat_map_type_policy, but the slots only store the pointers
+// of the separately allocated nodes.
+//
+template <typename Key, typename Value>
+class JSTD_DLL node_map_type_policy : public flat_map_type_policy<Key, Value>
+{
+public:
+    typedef flat_map_type_policy<Key, Value>                base_type;
+
+    typedef typename base_type::raw_key_type                raw_key_type;
+    typedef typename base_type::raw_mapped_type             raw_mapped_type;
+
+    typedef node_map_slot_type<raw_key_type, raw_mapped_type>   slot_type;
+    typedef node_map_slot_policy<slot_type>                     slot_policy;
+
+    typedef node_map_type_policy<Key, Value>                this_type;
+};
+
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_NODE_MAP_TYPE_POLICY_HPP
@@ -0,0 +1,363 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2024-2025 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+*************************************************************************************
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+  You are free to:
+
+    1. Share -- copy and redistribute the material in any medium or format.
+
+    2. Adapt -- remix, transforn, and build upon the material for any purpose,
+    even commerically.
+
+    The licensor cannot revoke these freedoms as long as you follow the license terms.
+
+  Under the following terms:
+
+    * Attribution -- You must give appropriate credit, provide a link to the license,
+    and indicate if changes were made. You may do so in any reasonable manner,
+    but not in any way that suggests the licensor endorses you or your use.
+
+    * ShareAlike -- If you remix, transform, or build upon the material, you must
+    distribute your contributions under the same license as the original.
+
+    * No additional restrictions -- You may not apply legal terms or technological
+    measures that legally restrict others from doing anything the license permits.
+
+  Notices:
+
+    * You do not have to comply with the license for elements of the material
+    in the public domain or where your use is permitted by an applicable exception
+    or limitation.
+
+    * No warranties are given. The license may not give you all of the permissions
+    necessary for your intended use. For example, other rights such as publicity,
+    privacy, or moral rights may limit how you use the material.
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_READ_MOSTLY_ROBIN_HASH_MAP_H
+#define JSTD_HASHMAP_READ_MOSTLY_ROBIN_HASH_MAP_H
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>       // For std::allocator<T>
+#include <functional>   // For std::hash<Key>, std::equal_to<Key>
+#include <type_traits>
+#include <utility>      // For std::pair<F, S>
+#include <atomic>
+#include <mutex>        // For std::mutex, std::lock_guard<T>
+#include <thread>       // For std::this_thread::get_id()
+
+#include "jstd/basic/stddef.h"
+#include "jstd/system/rw_spin_lock.h"   // For jstd::cpu_relax()
+#include "jstd/hashmap/robin_hash_map.h"
+
+namespace jstd {
+
+//
+// A read-mostly mode of robin_hash_map: one writer and any number of lock-free readers.
+//
+// robin_hash_map shifts the entries on insert and erase, and may rehash in place
+// inside any insertion (when the probe distance overflows), so the readers can't
+// validate an optimistic read of the live arrays. Instead, we keep two instances
+// (Left-Right): the readers always read the published instance and never retry,
+// the writer applies a modification to the hidden instance, publishes it,
+// waits the readers of the old instance to drain (the grace period), and then
+// applies the same modification to the old instance.
+//
+// So a rehash happens on the hidden instance only, and the old arrays are released
+// after all the readers have left them. The cost is twice the memory and the writes.
+//
+template < typename Key, typename Value,
+           typename Hash = std::hash<typename std::remove_const<Key>::type>,
+           typename KeyEqual = std::equal_to<typename std::remove_const<Key>::type>,
+           typename LayoutPolicy = jstd::default_layout_policy<Key, Value>,
+           typename Allocator = std::allocator<std::pair<typename std::add_const<typename std::remove_const<Key>::type>::type,
+                                                         typename std::remove_const<Value>::type>> >
+class JSTD_DLL read_mostly_robin_hash_map {
+public:
+    typedef jstd::robin_hash_map<Key, Value, Hash, KeyEqual, LayoutPolicy, Allocator>
+                                                map_type;
+
+    typedef typename map_type::size_type        size_type;
+    typedef typename map_type::key_type         key_type;
+    typedef typename map_type::mapped_type      mapped_type;
+    typedef typename map_type::value_type       value_type;
+    typedef typename map_type::hasher           hasher;
+    typedef typename map_type::key_equal        key_equal;
+    typedef typename map_type::allocator_type   allocator_type;
+
+    using this_type = read_mostly_robin_hash_map<Key, Value, Hash, KeyEqual, LayoutPolicy, Allocator>;
+
+    static constexpr size_type kCacheLineSize = 64;
+    static constexpr size_type kReaderStripes = 32;
+
+private:
+    //
+    // The read indicator is striped to avoid all the readers
+    // bouncing the same cache line.
+    //
+    struct alignas(kCacheLineSize) reader_stripe {
+        std::atomic<std::intptr_t> count;
+
+        reader_stripe() noexcept : count(0) {}
+    };
+
+    struct read_indicator {
+        reader_stripe stripes[kReaderStripes];
+
+        JSTD_FORCED_INLINE
+        void arrive(size_type stripe) noexcept {
+            this->stripes[stripe].count.fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        JSTD_FORCED_INLINE
+        void depart(size_type stripe) noexcept {
+            this->stripes[stripe].count.fetch_sub(1, std::memory_order_release);
+        }
+
+        bool is_empty() const noexcept {
+            for (size_type i = 0; i < kReaderStripes; i++) {
+                if (this->stripes[i].count.load(std::memory_order_acquire) != 0)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    map_type                    maps_[2];
+    read_indicator              indicators_[2];
+    std::atomic<std::uint32_t>  read_index_;
+    std::atomic<std::uint32_t>  version_index_;
+    std::mutex                  writer_mutex_;
+
+    //
+    // Pin a reader to the instance it reads, until it departs.
+    //
+    class read_guard {
+        const this_type &   owner_;
+        std::uint32_t       version_;
+        size_type           stripe_;
+
+    public:
+        explicit read_guard(const this_type & owner) noexcept
+            : owner_(owner), stripe_(this_type::reader_stripe_index()) {
+            read_indicator * indicators = const_cast<read_indicator *>(owner.indicators_);
+            this->version_ = owner.version_index_.load(std::memory_order_seq_cst);
+            indicators[this->version_].arrive(this->stripe_);
+        }
+
+        ~read_guard() {
+            read_indicator * indicators = const_cast<read_indicator *>(this->owner_.indicators_);
+            indicators[this->version_].depart(this->stripe_);
+        }
+
+        const map_type & map() const noexcept {
+            return this->owner_.maps_[this->owner_.read_index_.load(std::memory_order_seq_cst)];
+        }
+    };
+
+public:
+    read_mostly_robin_hash_map() : read_mostly_robin_hash_map(0) {}
+
+    explicit read_mostly_robin_hash_map(size_type init_capacity,
+                                        const hasher & hash = hasher(),
+                                        const key_equal & equal = key_equal(),
+                                        const allocator_type & alloc = allocator_type())
+        : maps_{ map_type(init_capacity, hash, equal, alloc),
+                 map_type(init_capacity, hash, equal, alloc) },
+          read_index_(0), version_index_(0) {
+    }
+
+    read_mostly_robin_hash_map(const read_mostly_robin_hash_map &) = delete;
+    read_mostly_robin_hash_map & operator = (const read_mostly_robin_hash_map &) = delete;
+
+    ~read_mostly_robin_hash_map() = default;
+
+    static const char * name() {
+        return "jstd::read_mostly_robin_hash_map<K, V>";
+    }
+
+    ///
+    /// Readers: lock-free and never blocked by the writer.
+    ///
+    size_type size() const {
+        read_guard guard(*this);
+        return guard.map().size();
+    }
+
+    bool empty() const {
+        return (this->size() == 0);
+    }
+
+    bool contains(const key_type & key) const {
+        read_guard guard(*this);
+        return guard.map().contains(key);
+    }
+
+    size_type count(const key_type & key) const {
+        read_guard guard(*this);
+        return guard.map().count(key);
+    }
+
+    //
+    // Copy the mapped value out, return false if the key is not exists.
+    //
+    bool find(const key_type & key, mapped_type & value) const {
+        read_guard guard(*this);
+        const map_type & map = guard.map();
+        // An unallocated robin_hash_map's find() doesn't return end().
+        if (map.empty())
+            return false;
+        auto iter = map.find(key);
+        if (iter != map.end()) {
+            value = iter->second;
+            return true;
+        }
+        return false;
+    }
+
+    //
+    // Call f(const value_type &) while the instance is pinned, the value
+    // must not be referenced after f() returns.
+    //
+    template <typename F>
+    bool cvisit(const key_type & key, F && f) const {
+        read_guard guard(*this);
+        const map_type & map = guard.map();
+        // An unallocated robin_hash_map's find() doesn't return end().
+        if (map.empty())
+            return false;
+        auto iter = map.find(key);
+        if (iter != map.end()) {
+            f(*iter);
+            return true;
+        }
+        return false;
+    }
+
+    ///
+    /// Writer: serialized, each modification is applied to both instances.
+    ///
+    bool insert(const value_type & value) {
+        return this->modify([&value](map_type & map) {
+            return map.insert(value).second;
+        });
+    }
+
+    bool insert_or_assign(const key_type & key, const mapped_type & value) {
+        return this->modify([&key, &value](map_type & map) {
+            return map.insert_or_assign(key, value).second;
+        });
+    }
+
+    size_type erase(const key_type & key) {
+        return this->modify([&key](map_type & map) {
+            return map.erase(key);
+        });
+    }
+
+    void clear() {
+        this->modify([](map_type & map) {
+            map.clear();
+            return true;
+        });
+    }
+
+    void reserve(size_type new_capacity) {
+        this->modify([new_capacity](map_type & map) {
+            map.reserve(new_capacity);
+            return true;
+        });
+    }
+
+    //
+    // Apply op(map_type &) to both instances, op must be deterministic,
+    // returns the result of the first application.
+    //
+    // If op throws, the instance it was applied to is restored as a copy of the other
+    // instance, and the exception is rethrown, so the two instances never diverge:
+    // when the first application throws, nothing is published; when the second one
+    // throws, the modification is kept. If the copy throws too (eg. std::bad_alloc),
+    // its exception is thrown instead, and the instance is left as op left it.
+    //
+    template <typename Op>
+    auto modify(Op && op) -> decltype(op(std::declval<map_type &>())) {
+        std::lock_guard<std::mutex> writer_guard(this->writer_mutex_);
+
+        std::uint32_t read_index = this->read_index_.load(std::memory_order_relaxed);
+        std::uint32_t write_index = read_index ^ 1u;
+
+        // Modify the hidden instance, and publish it.
+        auto result = this->apply_or_restore(op, write_index, read_index);
+        this->read_index_.store(write_index, std::memory_order_seq_cst);
+
+        // Wait the readers of the old instance to leave.
+        this->toggle_version_and_wait();
+
+        // Now no reader can see the old instance, apply the same op to it.
+        this->apply_or_restore(op, read_index, write_index);
+        return result;
+    }
+
+private:
+    //
+    // No reader can see maps_[index] here, so it can be overwritten.
+    //
+    template <typename Op>
+    auto apply_or_restore(Op & op, std::uint32_t index, std::uint32_t source_index)
+        -> decltype(op(std::declval<map_type &>())) {
+        try {
+            return op(this->maps_[index]);
+        } catch (...) {
+            this->maps_[index] = this->maps_[source_index];
+            throw;
+        }
+    }
+
+    static size_type reader_stripe_index() noexcept {
+        static thread_local size_type s_stripe_index =
+            std::hash<std::thread::id>()(std::this_thread::get_id()) % kReaderStripes;
+        return s_stripe_index;
+    }
+
+    void wait_for_readers(std::uint32_t version) noexcept {
+        std::uint32_t spins = 0;
+        while (!this->indicators_[version].is_empty()) {
+            if (spins < 64) {
+                spins++;
+                jstd::cpu_relax();
+            } else {
+                jstd::thread_yield();
+            }
+        }
+    }
+
+    void toggle_version_and_wait() noexcept {
+        std::uint32_t prev_version = this->version_index_.load(std::memory_order_relaxed);
+        std::uint32_t next_version = prev_version ^ 1u;
+        this->wait_for_readers(next_version);
+        this->version_index_.store(next_version, std::memory_order_seq_cst);
+        this->wait_for_readers(prev_version);
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_READ_MOSTLY_ROBIN_HASH_MAP_H
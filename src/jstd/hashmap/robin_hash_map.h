@@ -73,12 +73,14 @@
 #include "jstd/traits/type_traits.h"
 #include "jstd/iterator.h"
 #include "jstd/utility/utility.h"
+#include "jstd/memory/released_array.h"
 #include "jstd/lang/launder.h"
 #include "jstd/hasher/hashes.h"
 #include "jstd/hasher/hash_crc32.h"
 #include "jstd/hashmap/map_layout_policy.h"
 #include "jstd/hashmap/map_slot_policy.h"
 #include "jstd/hashmap/slot_policy_traits.h"
+#include "jstd/hashmap/detail/region_rehash.h"
 #include "jstd/support/BitUtils.h"
 #include "jstd/support/Power2.h"
 #include "jstd/support/BitVec.h"
@@ -104,6 +106,13 @@
 
 #define ROBIN_REHASH_READ_PREFETCH  0
 
+// Transfer the old slots by the region of their new home when a big table grows a lot,
+// see try_region_transfer(). It's slower while the LLC still holds the most of the new
+// arrays, so it's off by default.
+#ifndef ROBIN_USE_REGION_REHASH
+#define ROBIN_USE_REGION_REHASH     0
+#endif
+
 namespace jstd {
 
 template <typename Key, typename Value, typename SlotType>
@@ -276,6 +285,10 @@ public:
 
     static constexpr size_type kMinLookups = 4;
 
+    // With ROBIN_USE_REGION_REHASH, the rehash of a big table by a big growth rate transfers
+    // the old slots by the region of their new home, see try_region_transfer().
+    static constexpr size_type kMinRegionRehashSize = 65536;
+
     static constexpr float kMinLoadFactor = 0.3f;
     static constexpr float kMaxLoadFactor = 0.6f;
 
@@ -3041,6 +3054,7 @@ private:
 #if ROBIN_USE_HASH_POLICY
     hash_policy_t   hash_policy_;
 #endif
+    jstd::detail::released_array<slot_type> released_slots_;
 
     hasher          hasher_;
     key_equal       key_equal_;
@@ -3158,6 +3172,7 @@ public:
 #if ROBIN_USE_HASH_POLICY
         hash_policy_(jstd::exchange(other.hash_policy_ref(), hash_policy_t())),
 #endif
+        released_slots_(std::move(other.released_slots_)),
         hasher_(std::move(other.hash_function_ref())),
         key_equal_(std::move(other.key_eq_ref())),
         allocator_(std::move(other.get_allocator_ref())),
@@ -3240,6 +3255,7 @@ public:
 
     ~robin_hash_map() {
         this->destroy();
+        this->released_slots_.deallocate(this->slot_allocator_);
     }
 
     robin_hash_map & operator = (const robin_hash_map & other) {
@@ -3403,16 +3419,20 @@ public:
         return this->begin();
     }
 
+    //
+    // A miss of find() returns the last slot, and there is no slot array when the table is
+    // empty (eg. after clear(true)), so don't use max_slot_capacity() here, which is not 0 then.
+    //
     iterator end() {
         if (!kIsIndirectKV)
-            return this->iterator_at(this->max_slot_capacity());
+            return this->iterator_at(static_cast<size_type>(this->last_slot() - this->slots()));
         else
             return this->iterator_at(this->size());
     }
 
     const_iterator end() const {
         if (!kIsIndirectKV)
-            return this->iterator_at(this->max_slot_capacity());
+            return this->iterator_at(static_cast<size_type>(this->last_slot() - this->slots()));
         else
             return this->iterator_at(this->size());
     }
@@ -3501,10 +3521,14 @@ public:
         return "jstd::robin_hash_map<K, V>";
     }
 
+    //
+    // clear(true) shrinks to the default capacity, the pages of a huge slot array
+    // are returned to the OS and the array is reused by the next growth to the same capacity.
+    //
     void clear(bool need_destroy = false) noexcept {
         if (this->slot_capacity() > kDefaultCapacity) {
             if (need_destroy) {
-                this->destroy_data();
+                this->destroy_data<true>();
                 this->create_slots<false>(kDefaultCapacity);
                 assert(this->slot_size() == 0);
                 return;
@@ -3557,8 +3581,11 @@ public:
         const slot_type * slot = this->find_impl(key);
         if (!kIsIndirectKV)
             return this->iterator_at(this->index_of(slot));
-        else
+        else if (slot != this->last_slot())
             return this->iterator_at(slot);
+        else
+            // The indirect slots are packed, so a miss isn't at end().
+            return this->end();
     }
 
     std::pair<iterator, iterator> equal_range(const key_type & key) {
@@ -4172,19 +4199,24 @@ private:
         this->destroy_data();
     }
 
+    template <bool ReleaseSlots = false>
     void destroy_data() noexcept {
         // Note!!: destroy_slots() need use this->ctrls()
-        this->destroy_slots();
+        this->destroy_slots<ReleaseSlots>();
 
         this->destroy_ctrls();
     }
 
+    template <bool ReleaseSlots = false>
     void destroy_slots() noexcept {
         this->clear_slots();
 
         if (this->slots_ != nullptr) {
 #if ROBIN_USE_SEPARATE_SLOTS
-            SlotAllocTraits::deallocate(this->slot_allocator_, this->slots_, this->max_slot_capacity());
+            if (!ReleaseSlots ||
+                !this->released_slots_.retain(this->slot_allocator_, this->slots_, this->max_slot_capacity())) {
+                SlotAllocTraits::deallocate(this->slot_allocator_, this->slots_, this->max_slot_capacity());
+            }
 #endif
         }
         this->slots_ = nullptr;
@@ -4376,7 +4408,7 @@ private:
         this->clear_ctrls(new_ctrls, new_capacity, new_max_lookups, new_group_count);
 
 #if ROBIN_USE_SEPARATE_SLOTS
-        slot_type * new_slots = SlotAllocTraits::allocate(this->slot_allocator_, new_ctrl_capacity);
+        slot_type * new_slots = this->released_slots_.allocate(this->slot_allocator_, new_ctrl_capacity);
 #else
         slot_type * new_slots = this->AlignedSlots<kSlotAlignment>(new_ctrls, ctrl_alloc_size);
 #endif
@@ -4430,7 +4462,10 @@ private:
 
             if (!kIsIndirectKV) {
                 // kIsIndirectKV = false
-                if (old_slot_capacity >= kGroupWidth) {
+                if (this->try_region_transfer(old_ctrls, old_max_slot_capacity,
+                                              old_slots, old_slot_size, old_slot_capacity)) {
+                    // The old slots are transferred by the region of their new home.
+                } else if (old_slot_capacity >= kGroupWidth) {
 #if ROBIN_REHASH_READ_PREFETCH
                     static constexpr size_type kSlotSetp = sizeof(value_type) * kGroupWidth;
                     static constexpr size_type kCacheLine = 64;
@@ -4646,12 +4681,77 @@ private:
 
 #if ROBIN_USE_SEPARATE_SLOTS
             if (old_slots != nullptr) {
-                SlotAllocTraits::deallocate(this->slot_allocator_, old_slots, old_max_slot_capacity);
+                // Shrinking, keep the old slots for the next growth, but return it's pages.
+                bool is_shrink = AllowShrink && (this->slot_capacity() < old_slot_capacity);
+                if (!is_shrink ||
+                    !this->released_slots_.retain(this->slot_allocator_, old_slots, old_max_slot_capacity)) {
+                    SlotAllocTraits::deallocate(this->slot_allocator_, old_slots, old_max_slot_capacity);
+                }
             }
 #endif
         }
     }
 
+    struct rehash_item {
+        slot_type *  slot;
+        hash_code_t  hash_code;
+    };
+
+    //
+    // The home index is the low bits of the hash, so the old slots of a group go to
+    // (new_capacity / old_capacity) places, and a big growth writes the new arrays
+    // at random. Instead, hash the old slots first, partition them by the region
+    // of their new home (see jstd::detail::partition_by_region()), then insert
+    // them region by region, so the writes stay in a cached region.
+    //
+    // Returns false if it isn't worth it or the items can't be allocated,
+    // the old slots are untouched then.
+    //
+    JSTD_NO_INLINE
+    bool try_region_transfer(ctrl_type * old_ctrls, size_type old_max_slot_capacity,
+                             slot_type * old_slots, size_type old_slot_size,
+                             size_type old_slot_capacity) {
+        if ((ROBIN_USE_REGION_REHASH == 0) || (ROBIN_USE_HASH_POLICY != 0) ||
+            (old_slot_size < kMinRegionRehashSize) ||
+            (this->slot_capacity() < old_slot_capacity * jstd::detail::kMinRegionRehashGrowth))
+            return false;
+
+        std::vector<rehash_item> items;
+        try {
+            items.reserve(old_slot_size);
+        } catch (...) {
+            return false;
+        }
+
+        ctrl_type * last_ctrl = old_ctrls + old_max_slot_capacity;
+        slot_type * old_slot = old_slots;
+        for (ctrl_type * ctrl = old_ctrls; ctrl != last_ctrl; ctrl++) {
+            if (likely(ctrl->isUsed())) {
+                items.push_back({ old_slot, this->get_hash(old_slot->value.first) });
+            }
+            old_slot++;
+        }
+        assert(items.size() == old_slot_size);
+
+        size_type region_shift = jstd::detail::region_rehash_shift(sizeof(ctrl_type) + sizeof(slot_type));
+        size_type region_count = (this->slot_capacity() >> region_shift) + 1;
+        bool is_partitioned = jstd::detail::partition_by_region(items, region_count,
+            [this, region_shift](const rehash_item & item) -> std::size_t {
+                return (this->index_for_hash(item.hash_code) >> region_shift);
+            });
+        if (!is_partitioned)
+            return false;
+
+        for (const rehash_item & item : items) {
+            slot_type * new_slot = this->find_and_insert_no_grow_for_hash(item.hash_code);
+            SlotPolicyTraits::construct(&this->allocator_, new_slot, item.slot);
+            this->slot_size_++;
+            this->destroy_slot(item.slot);
+        }
+        assert(this->slot_size() <= this->slot_capacity());
+        return true;
+    }
+
     JSTD_FORCED_INLINE
     void construct_slot(size_type index) {
         slot_type * slot = this->slot_at(index);
@@ -6146,6 +6246,11 @@ InsertOrGrow_Start:
     JSTD_FORCED_INLINE
     slot_type * find_and_insert_no_grow(const KeyT & key) {
         hash_code_t hash_code = this->get_hash(key);
+        return this->find_and_insert_no_grow_for_hash(hash_code);
+    }
+
+    JSTD_FORCED_INLINE
+    slot_type * find_and_insert_no_grow_for_hash(hash_code_t hash_code) {
         size_type slot_index = this->index_for_hash(hash_code);
 
         ctrl_type * ctrl = this->ctrl_at(slot_index);
@@ -6556,6 +6661,7 @@ Insert_To_Slot:
         using std::swap;
         swap(this->ctrls_, other.ctrls_);
         swap(this->slots_, other.slots_);
+        swap(this->last_slot_, other.last_slot_);
         swap(this->slot_size_, other.slot_size_);
         swap(this->slot_mask_, other.slot_mask_);
         swap(this->max_lookups_, other.max_lookups_);
@@ -6565,6 +6671,7 @@ Insert_To_Slot:
 #if ROBIN_USE_HASH_POLICY
         swap(this->hash_policy_, other.hash_policy_ref());
 #endif
+        this->released_slots_.swap(other.released_slots_);
     }
 
     void swap_policy(this_type & other) noexcept {
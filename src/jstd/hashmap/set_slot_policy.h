@@ -0,0 +1,187 @@
+/************************************************************************************
+
+  CC BY-SA 4.0 License
+
+  Copyright (c) 2018-2024 XiongHui Guo (gz_shines at msn.com)
+
+  https://github.com/shines77/jstd_hashmap
+  https://gitee.com/shines77/jstd_hashmap
+
+  -------------------------------------------------------------------
+
+  CC Attribution-ShareAlike 4.0 International
+
+  https://creativecommons.org/licenses/by-sa/4.0/deed.en
+
+************************************************************************************/
+
+#ifndef JSTD_HASHMAP_SET_SLOT_POLICY_HPP
+#define JSTD_HASHMAP_SET_SLOT_POLICY_HPP
+
+#pragma once
+
+#include <memory>       // For std::allocator<T>
+#include <utility>      // For std::move()
+#include <type_traits>
+#include <cstring>      // For std::memcpy()
+
+#include "jstd/basic/stddef.h"
+#include "jstd/lang/launder.h"
+#include "jstd/traits/type_traits.h"
+
+namespace jstd {
+
+//
+// The slot of the sets only stores the key, there is no mapped value.
+//
+template <typename Key>
+union JSTD_DLL set_slot_type {
+public:
+    using key_type = typename std::remove_const<Key>::type;
+    // The sets have no mapped value, it's only used by the traits of the tables.
+    using mapped_type = key_type;
+    using value_type = key_type;
+    using mutable_value_type = key_type;
+    using init_type = key_type;
+    using element_type = value_type;
+
+    static constexpr const bool kIsLayoutCompatible = true;
+
+    value_type  value;
+
+    set_slot_type() {}
+    ~set_slot_type() = delete;
+
+    inline const key_type & get_key() const noexcept {
+        return value;
+    }
+};
+
+template <typename SlotType>
+class JSTD_DLL set_slot_policy {
+public:
+    using slot_type = SlotType;
+    using key_type = typename slot_type::key_type;
+    using mapped_type = typename slot_type::mapped_type;
+    using value_type = typename slot_type::value_type;
+    using mutable_value_type = typename slot_type::mutable_value_type;
+    using init_type = typename slot_type::init_type;
+    using element_type = typename slot_type::element_type;
+
+    using this_type = set_slot_policy<SlotType>;
+
+    static constexpr bool kIsLayoutCompatible = slot_type::kIsLayoutCompatible;
+
+private:
+    static void emplace(slot_type * slot) {
+        // The construction of union doesn't do anything at runtime but it allows us
+        // to access its members without violating aliasing rules.
+        new (slot) slot_type;
+    }
+
+public:
+    static value_type & element(slot_type * slot) {
+        return slot->value;
+    }
+
+    static const value_type & element(const slot_type * slot) {
+        return slot->value;
+    }
+
+    static const key_type & key(const slot_type * slot) {
+        return slot->value;
+    }
+
+    template <typename Allocator, typename ... Args>
+    static void construct(Allocator * alloc, slot_type * slot, Args && ... args) {
+        this_type::emplace(slot);
+        std::allocator_traits<Allocator>::construct(*alloc, &slot->value, std::forward<Args>(args)...);
+    }
+
+    //
+    // Construct this slot by moving from another slot.
+    //
+    template <typename Allocator>
+    static void construct(Allocator * alloc, slot_type * slot, slot_type * other) {
+        this_type::emplace(slot);
+        std::allocator_traits<Allocator>::construct(*alloc, &slot->value, std::move(other->value));
+    }
+
+    //
+    // Construct this slot by copying from another slot.
+    //
+    template <typename Allocator>
+    static void construct(Allocator * alloc, slot_type * slot, const slot_type * other) {
+        this_type::emplace(slot);
+        std::allocator_traits<Allocator>::construct(*alloc, &slot->value, other->value);
+    }
+
+    template <typename Allocator>
+    static void destroy(Allocator * alloc, slot_type * slot) {
+        std::allocator_traits<Allocator>::destroy(*alloc, &slot->value);
+    }
+
+    template <typename Allocator>
+    static void assign(Allocator * alloc, slot_type * dest_slot, slot_type * src_slot) {
+        dest_slot->value = std::move(src_slot->value);
+    }
+
+    template <typename Allocator>
+    static void assign(Allocator * alloc, slot_type * dest_slot, const slot_type * src_slot) {
+        dest_slot->value = src_slot->value;
+    }
+
+    template <typename Allocator>
+    static void mutable_assign(Allocator * alloc, slot_type * dest_slot, slot_type * src_slot) {
+        dest_slot->value = std::move(src_slot->value);
+    }
+
+    template <typename Allocator>
+    static void mutable_assign(Allocator * alloc, slot_type * dest_slot, const slot_type * src_slot) {
+        dest_slot->value = src_slot->value;
+    }
+
+    template <typename Allocator>
+    static void transfer(Allocator * alloc, slot_type * new_slot, slot_type * old_slot) {
+        static constexpr const bool kIsRelocatable = jstd::is_trivially_relocatable<value_type>::value;
+        this_type::emplace(new_slot);
+#if defined(__cpp_lib_launder) && (__cpp_lib_launder >= 201606)
+        if (kIsRelocatable) {
+            std::memcpy(static_cast<void *>(std::launder(&new_slot->value)),
+                        static_cast<const void *>(&old_slot->value),
+                        sizeof(value_type));
+            return;
+        }
+#endif // __cpp_lib_launder
+        std::allocator_traits<Allocator>::construct(*alloc, &new_slot->value, std::move(old_slot->value));
+        this_type::destroy(alloc, old_slot);
+    }
+
+    template <typename Allocator>
+    static void swap(Allocator * alloc, slot_type * slot1, slot_type * slot2, slot_type * tmp) {
+        this_type::transfer(alloc, tmp, slot2);
+        this_type::transfer(alloc, slot2, slot1);
+        this_type::transfer(alloc, slot1, tmp);
+    }
+
+    template <typename Allocator>
+    static void exchange(Allocator * alloc, slot_type * src, slot_type * dest, slot_type * empty) {
+        this_type::transfer(alloc, empty, dest);
+        this_type::transfer(alloc, dest, src);
+    }
+
+    template <typename Allocator>
+    static void move_assign_swap(Allocator * alloc, slot_type * slot1, slot_type * slot2, slot_type * tmp) {
+        this_type::mutable_assign(alloc, tmp, slot2);
+        this_type::mutable_assign(alloc, slot2, slot1);
+        this_type::mutable_assign(alloc, slot1, tmp);
+    }
+
+    static std::size_t extra_space(const slot_type *) {
+        return 0;
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_HASHMAP_SET_SLOT_POLICY_HPP
@@ -91,12 +91,27 @@ private:
         : Policy::constant_iterators {
     };
 
+    template <typename Policy = SlotPolicy, typename = void>
+    struct NodeBasedImpl : std::false_type {
+    };
+
+    template <typename Policy>
+    struct NodeBasedImpl<Policy, jstd::void_t<typename Policy::node_based>>
+        : Policy::node_based {
+    };
+
 public:
     // Policies can set this variable to tell hashmap that all iterators
     // should be constant, even `iterator`. This is useful for set-like containers.
     // Defaults to false if not provided by the policy.
     using constant_iterators = ConstantIteratorsImpl<>;
 
+    // Policies can set this variable to tell hashmap that the slots only hold
+    // the pointers of the separately allocated nodes, so the elements never move
+    // and the slots can't be copied by memcpy().
+    // Defaults to false if not provided by the policy.
+    using node_based = NodeBasedImpl<>;
+
     // PRECONDITION:  `slot` is UNINITIALIZED
     // POSTCONDITION: `slot` is INITIALIZED
     template <typename Alloc, typename ... Args>
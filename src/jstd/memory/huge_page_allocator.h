@@ -0,0 +1,254 @@
+
+#ifndef JSTD_MEMORY_HUGE_PAGE_ALLOCATOR_H
+#define JSTD_MEMORY_HUGE_PAGE_ALLOCATOR_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>       // For std::allocator<T>
+#include <new>          // For std::bad_alloc
+#include <limits>       // For std::numeric_limits<T>
+#include <type_traits>
+#include <assert.h>
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__MINGW32__) || defined(__CYGWIN__)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#define JSTD_HUGE_PAGE_WIN32    1
+#else
+#include <sys/mman.h>   // For mmap(), munmap(), madvise()
+#define JSTD_HUGE_PAGE_WIN32    0
+#endif
+
+#include "jstd/basic/stddef.h"
+
+namespace jstd {
+namespace detail {
+
+struct huge_pages {
+    static constexpr std::size_t kHugePageSize = 2 * 1024 * 1024;
+    static constexpr std::size_t kPageSize = 4096;
+
+    static std::size_t round_up(std::size_t size) noexcept {
+        return ((size + kHugePageSize - 1) & ~(kHugePageSize - 1));
+    }
+
+    //
+    // Touch one byte per page, to take the page faults now instead of
+    // in the first pass of inserts.
+    //
+    static void prefault(void * ptr, std::size_t size) noexcept {
+#if !JSTD_HUGE_PAGE_WIN32 && defined(MADV_POPULATE_WRITE)
+        if (::madvise(ptr, size, MADV_POPULATE_WRITE) == 0)
+            return;
+#endif
+        volatile char * first = static_cast<volatile char *>(ptr);
+        for (std::size_t offset = 0; offset < size; offset += kPageSize) {
+            first[offset] = 0;
+        }
+    }
+
+    //
+    // Returns a block of round_up(size) bytes, or nullptr if the system is out of memory.
+    // The block is kHugePageSize aligned on Linux, and on Windows if it's MEM_LARGE_PAGES,
+    // otherwise VirtualAlloc() only aligns it to the allocation granularity (64 KB).
+    //
+    static void * allocate(std::size_t size, bool use_hugetlb, bool populate) noexcept {
+        assert(size != 0);
+        std::size_t alloc_size = round_up(size);
+        void * ptr;
+#if JSTD_HUGE_PAGE_WIN32
+        ptr = nullptr;
+        if (use_hugetlb) {
+            // Needs the SeLockMemoryPrivilege, otherwise it fails and falls back.
+            std::size_t large_page_size = static_cast<std::size_t>(::GetLargePageMinimum());
+            if ((large_page_size != 0) && ((alloc_size % large_page_size) == 0)) {
+                ptr = ::VirtualAlloc(NULL, alloc_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                     PAGE_READWRITE);
+            }
+        }
+        if (ptr == nullptr) {
+            ptr = ::VirtualAlloc(NULL, alloc_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            if (ptr == nullptr)
+                return nullptr;
+        }
+#else
+#if defined(MAP_HUGETLB)
+        if (use_hugetlb) {
+            // Only succeeds if the huge pages are reserved (vm.nr_hugepages).
+            int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_POPULATE)
+            if (populate)
+                flags |= MAP_POPULATE;
+#endif
+            ptr = ::mmap(nullptr, alloc_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (ptr != MAP_FAILED)
+                return ptr;
+        }
+#else
+        JSTD_UNUSED(use_hugetlb);
+#endif
+        // Map one more huge page, and trim the head and tail to align it.
+        std::size_t map_size = alloc_size + kHugePageSize;
+        ptr = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            return nullptr;
+
+        char * first = static_cast<char *>(ptr);
+        char * aligned = reinterpret_cast<char *>(
+            (reinterpret_cast<std::uintptr_t>(first) + kHugePageSize - 1) & ~std::uintptr_t(kHugePageSize - 1));
+        std::size_t head = static_cast<std::size_t>(aligned - first);
+        std::size_t tail = map_size - head - alloc_size;
+        if (head != 0)
+            ::munmap(first, head);
+        if (tail != 0)
+            ::munmap(aligned + alloc_size, tail);
+        ptr = static_cast<void *>(aligned);
+
+#if defined(MADV_HUGEPAGE)
+        // The transparent huge pages, it's only a hint, the failure is harmless.
+        ::madvise(ptr, alloc_size, MADV_HUGEPAGE);
+#endif
+#endif // JSTD_HUGE_PAGE_WIN32
+        if (populate) {
+            prefault(ptr, alloc_size);
+        }
+        return ptr;
+    }
+
+    static void deallocate(void * ptr, std::size_t size) noexcept {
+        assert(ptr != nullptr);
+#if JSTD_HUGE_PAGE_WIN32
+        JSTD_UNUSED(size);
+        ::VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+        ::munmap(ptr, round_up(size));
+#endif
+    }
+};
+
+} // namespace detail
+
+//
+// The allocator for the backing arrays (groups and slots) of the big tables.
+//
+// The allocations of at least kHugePageThreshold bytes are mapped directly,
+// and are backed by the huge pages when possible:
+//
+//   - Linux: MAP_HUGETLB if kUseHugeTLB is set and the huge pages are reserved,
+//            otherwise madvise(MADV_HUGEPAGE) (the transparent huge pages),
+//            both are aligned to 2 MB;
+//   - Windows: MEM_LARGE_PAGES if kUseHugeTLB is set and the process holds
+//              SeLockMemoryPrivilege, which is aligned to 2 MB, otherwise
+//              the normal pages, which are only aligned to 64 KB.
+//
+// With kPrefault, the pages are faulted in when they are allocated, i.e.
+// in reserve() and the growing of the table. The smaller allocations
+// use std::allocator<T>.
+//
+// Any two instances can free the memory of each other, the flags only affect
+// the new allocations, and they are shared by the rebinds.
+//
+template <typename T>
+class huge_page_allocator {
+public:
+    typedef T                   value_type;
+    typedef T *                 pointer;
+    typedef const T *           const_pointer;
+    typedef T &                 reference;
+    typedef const T &           const_reference;
+    typedef std::size_t         size_type;
+    typedef std::ptrdiff_t      difference_type;
+
+    typedef std::true_type      propagate_on_container_copy_assignment;
+    typedef std::true_type      propagate_on_container_move_assignment;
+    typedef std::true_type      propagate_on_container_swap;
+    typedef std::true_type      is_always_equal;
+
+    template <typename U>
+    struct rebind {
+        typedef huge_page_allocator<U> other;
+    };
+
+    enum : unsigned {
+        kDefault    = 0,
+        kUseHugeTLB = 1u << 0,
+        kPrefault   = 1u << 1,
+    };
+
+    static constexpr std::size_t kHugePageSize = detail::huge_pages::kHugePageSize;
+    static constexpr std::size_t kHugePageThreshold = kHugePageSize;
+
+private:
+    template <typename U>
+    friend class huge_page_allocator;
+
+    unsigned flags_;
+
+    static bool is_huge(size_type n) noexcept {
+        return (n >= (kHugePageThreshold / sizeof(T)));
+    }
+
+public:
+    huge_page_allocator() noexcept : flags_(kDefault) {
+    }
+
+    explicit huge_page_allocator(unsigned flags) noexcept : flags_(flags) {
+    }
+
+    huge_page_allocator(const huge_page_allocator & other) noexcept : flags_(other.flags_) {
+    }
+
+    template <typename U>
+    huge_page_allocator(const huge_page_allocator<U> & other) noexcept : flags_(other.flags_) {
+    }
+
+    huge_page_allocator & operator = (const huge_page_allocator & other) noexcept {
+        this->flags_ = other.flags_;
+        return *this;
+    }
+
+    unsigned flags() const noexcept {
+        return this->flags_;
+    }
+
+    T * allocate(size_type n) {
+        if (JSTD_LIKELY(!is_huge(n))) {
+            return std::allocator<T>().allocate(n);
+        } else {
+            if (n > (std::numeric_limits<size_type>::max)() / sizeof(T))
+                throw std::bad_alloc();
+            void * ptr = detail::huge_pages::allocate(n * sizeof(T), (this->flags_ & kUseHugeTLB) != 0,
+                                                      (this->flags_ & kPrefault) != 0);
+            if (ptr == nullptr)
+                throw std::bad_alloc();
+            return static_cast<T *>(ptr);
+        }
+    }
+
+    void deallocate(T * ptr, size_type n) noexcept {
+        if (JSTD_LIKELY(!is_huge(n)))
+            std::allocator<T>().deallocate(ptr, n);
+        else
+            detail::huge_pages::deallocate(static_cast<void *>(ptr), n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator == (const huge_page_allocator<U> &) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator != (const huge_page_allocator<U> &) const noexcept {
+        return false;
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_MEMORY_HUGE_PAGE_ALLOCATOR_H
@@ -0,0 +1,222 @@
+
+#ifndef JSTD_MEMORY_POOL_ALLOCATOR_H
+#define JSTD_MEMORY_POOL_ALLOCATOR_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>       // For std::allocator<T>
+#include <new>          // For ::operator new()
+#include <type_traits>
+#include <utility>      // For std::swap()
+#include <assert.h>
+
+#include "jstd/basic/stddef.h"
+
+namespace jstd {
+namespace detail {
+
+//
+// The free lists of the fixed size nodes, one free list per size class
+// (a multiple of kAlignment). The nodes are carved from the kBlockSize blocks
+// and the blocks are only returned to the system when the pool is destroyed.
+//
+// A pool is shared by the allocators of one container (and the rebinds of them),
+// it's not thread-safe, the same as the container itself.
+//
+class node_pool {
+public:
+    static constexpr std::size_t kAlignment = alignof(std::max_align_t);
+    static constexpr std::size_t kMaxNodeSize = 1024;
+    static constexpr std::size_t kSizeClasses = kMaxNodeSize / kAlignment;
+    static constexpr std::size_t kBlockSize = 64 * 1024;
+
+private:
+    struct free_node {
+        free_node * next;
+    };
+
+    struct block_header {
+        block_header * next;
+    };
+
+    static constexpr std::size_t kBlockHeaderSize =
+        (sizeof(block_header) + kAlignment - 1) / kAlignment * kAlignment;
+
+    free_node *     free_lists_[kSizeClasses];
+    block_header *  blocks_;
+    char *          cursor_;
+    char *          limit_;
+    std::size_t     ref_count_;
+
+public:
+    node_pool() noexcept : blocks_(nullptr), cursor_(nullptr), limit_(nullptr), ref_count_(1) {
+        for (std::size_t i = 0; i < kSizeClasses; i++) {
+            this->free_lists_[i] = nullptr;
+        }
+    }
+
+    node_pool(const node_pool &) = delete;
+    node_pool & operator = (const node_pool &) = delete;
+
+    ~node_pool() {
+        block_header * block = this->blocks_;
+        while (block != nullptr) {
+            block_header * next = block->next;
+            ::operator delete(static_cast<void *>(block));
+            block = next;
+        }
+    }
+
+    static constexpr bool is_pooled(std::size_t size, std::size_t align) noexcept {
+        return ((size <= kMaxNodeSize) && (align <= kAlignment));
+    }
+
+    void add_ref() noexcept {
+        this->ref_count_++;
+    }
+
+    void release() noexcept {
+        assert(this->ref_count_ > 0);
+        if (--this->ref_count_ == 0) {
+            delete this;
+        }
+    }
+
+    void * allocate(std::size_t size) {
+        assert(size != 0 && size <= kMaxNodeSize);
+        std::size_t size_class = (size - 1) / kAlignment;
+        free_node * node = this->free_lists_[size_class];
+        if (JSTD_LIKELY(node != nullptr)) {
+            this->free_lists_[size_class] = node->next;
+            return static_cast<void *>(node);
+        }
+
+        std::size_t node_size = (size_class + 1) * kAlignment;
+        if (JSTD_UNLIKELY(node_size > static_cast<std::size_t>(this->limit_ - this->cursor_))) {
+            this->new_block();
+        }
+        void * ptr = static_cast<void *>(this->cursor_);
+        this->cursor_ += node_size;
+        return ptr;
+    }
+
+    void deallocate(void * ptr, std::size_t size) noexcept {
+        assert(ptr != nullptr);
+        assert(size != 0 && size <= kMaxNodeSize);
+        std::size_t size_class = (size - 1) / kAlignment;
+        free_node * node = static_cast<free_node *>(ptr);
+        node->next = this->free_lists_[size_class];
+        this->free_lists_[size_class] = node;
+    }
+
+private:
+    JSTD_NO_INLINE
+    void new_block() {
+        // The rest of the current block is less than one node, just drop it.
+        char * block = static_cast<char *>(::operator new(kBlockSize));
+        block_header * header = reinterpret_cast<block_header *>(block);
+        header->next = this->blocks_;
+        this->blocks_ = header;
+        this->cursor_ = block + kBlockHeaderSize;
+        this->limit_ = block + kBlockSize;
+    }
+};
+
+} // namespace detail
+
+//
+// The single object allocations (the nodes) are taken from a node_pool,
+// the arrays and the over-sized or over-aligned types use std::allocator<T>.
+//
+// The copies and the rebinds share the pool, a copy of the container
+// gets a new pool (select_on_container_copy_construction()), and the pool
+// follows the elements on move assignment and swap.
+//
+template <typename T>
+class pool_allocator {
+public:
+    typedef T                   value_type;
+    typedef T *                 pointer;
+    typedef const T *           const_pointer;
+    typedef T &                 reference;
+    typedef const T &           const_reference;
+    typedef std::size_t         size_type;
+    typedef std::ptrdiff_t      difference_type;
+
+    typedef std::false_type     propagate_on_container_copy_assignment;
+    typedef std::true_type      propagate_on_container_move_assignment;
+    typedef std::true_type      propagate_on_container_swap;
+    typedef std::false_type     is_always_equal;
+
+    template <typename U>
+    struct rebind {
+        typedef pool_allocator<U> other;
+    };
+
+    static constexpr bool kIsPooled = detail::node_pool::is_pooled(sizeof(T), alignof(T));
+
+private:
+    template <typename U>
+    friend class pool_allocator;
+
+    detail::node_pool * pool_;
+
+public:
+    pool_allocator() : pool_(new detail::node_pool()) {
+    }
+
+    pool_allocator(const pool_allocator & other) noexcept : pool_(other.pool_) {
+        this->pool_->add_ref();
+    }
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U> & other) noexcept : pool_(other.pool_) {
+        this->pool_->add_ref();
+    }
+
+    ~pool_allocator() {
+        this->pool_->release();
+    }
+
+    pool_allocator & operator = (const pool_allocator & other) noexcept {
+        pool_allocator tmp(other);
+        std::swap(this->pool_, tmp.pool_);
+        return *this;
+    }
+
+    T * allocate(size_type n) {
+        if (kIsPooled && (n == 1))
+            return static_cast<T *>(this->pool_->allocate(sizeof(T)));
+        else
+            return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T * ptr, size_type n) noexcept {
+        if (kIsPooled && (n == 1))
+            this->pool_->deallocate(static_cast<void *>(ptr), sizeof(T));
+        else
+            std::allocator<T>().deallocate(ptr, n);
+    }
+
+    pool_allocator select_on_container_copy_construction() const {
+        return pool_allocator();
+    }
+
+    template <typename U>
+    bool operator == (const pool_allocator<U> & other) const noexcept {
+        return (this->pool_ == other.pool_);
+    }
+
+    template <typename U>
+    bool operator != (const pool_allocator<U> & other) const noexcept {
+        return (this->pool_ != other.pool_);
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_MEMORY_POOL_ALLOCATOR_H
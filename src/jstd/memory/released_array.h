@@ -0,0 +1,231 @@
+
+#ifndef JSTD_MEMORY_RELEASED_ARRAY_H
+#define JSTD_MEMORY_RELEASED_ARRAY_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>       // For std::allocator_traits<T>
+#include <utility>      // For std::swap()
+#include <cerrno>
+#include <cstdio>       // For std::fopen(), reading /proc/self/smaps
+#include <cstring>      // For std::strchr()
+#include <assert.h>
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__MINGW32__) || defined(__CYGWIN__)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#define JSTD_RELEASED_ARRAY_WIN32   1
+#else
+#include <sys/mman.h>   // For madvise()
+#include <unistd.h>     // For sysconf()
+#define JSTD_RELEASED_ARRAY_WIN32   0
+#endif
+
+#include "jstd/basic/stddef.h"
+
+namespace jstd {
+
+static inline
+std::size_t system_page_size() noexcept {
+#if JSTD_RELEASED_ARRAY_WIN32
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    return static_cast<std::size_t>(info.dwPageSize);
+#else
+    return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+}
+
+//
+// Returns the page size of the mapping which ptr is in, it's the huge page size
+// for the MAP_HUGETLB mappings (see huge_page_allocator), or 0 if it's unknown.
+//
+static inline
+std::size_t mapping_page_size(const void * ptr) noexcept {
+#if defined(__linux__)
+    std::FILE * fp = std::fopen("/proc/self/smaps", "r");
+    if (fp == nullptr)
+        return 0;
+
+    std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(ptr);
+    std::size_t page_size = 0;
+    bool in_mapping = false;
+    bool line_start = true;
+    char line[256];
+    while (std::fgets(line, sizeof(line), fp) != nullptr) {
+        // Only parse from the start of the lines, the paths may be longer than the buffer.
+        bool is_line_start = line_start;
+        line_start = (std::strchr(line, '\n') != nullptr);
+        if (!is_line_start)
+            continue;
+
+        unsigned long long first, last, kb;
+        if (std::sscanf(line, "%llx-%llx ", &first, &last) == 2) {
+            in_mapping = (addr >= first) && (addr < last);
+        } else if (in_mapping && (std::sscanf(line, "KernelPageSize: %llu kB", &kb) == 1)) {
+            page_size = static_cast<std::size_t>(kb) * 1024;
+            break;
+        }
+    }
+    std::fclose(fp);
+    return page_size;
+#else
+    // Windows has no per mapping page size to query, a failed MEM_RESET is just returned.
+    JSTD_UNUSED(ptr);
+    return jstd::system_page_size();
+#endif
+}
+
+//
+// Returns the whole pages of page_size in [ptr, ptr + size) to the OS.
+//
+static inline
+bool release_pages(void * ptr, std::size_t size, std::size_t page_size) noexcept {
+    std::uintptr_t first = reinterpret_cast<std::uintptr_t>(ptr);
+    std::uintptr_t last = first + size;
+    first = (first + page_size - 1) & ~std::uintptr_t(page_size - 1);
+    last = last & ~std::uintptr_t(page_size - 1);
+    if (first >= last)
+        return false;
+#if JSTD_RELEASED_ARRAY_WIN32
+    return (::VirtualAlloc(reinterpret_cast<void *>(first), static_cast<SIZE_T>(last - first),
+                           MEM_RESET, PAGE_READWRITE) != NULL);
+#else
+    return (::madvise(reinterpret_cast<void *>(first), static_cast<std::size_t>(last - first),
+                      MADV_DONTNEED) == 0);
+#endif
+}
+
+//
+// Returns the whole pages in [ptr, ptr + size) to the OS, the range stays mapped,
+// the pages are faulted in again (zero filled) when they are touched.
+// The partial pages at both ends are kept, they may be shared with the others.
+//
+// Returns false if no page is released, eg. the range is smaller than a page,
+// or the OS can't release the pages of the mapping.
+//
+static inline
+bool release_pages(void * ptr, std::size_t size) noexcept {
+    std::size_t page_size = jstd::system_page_size();
+    errno = 0;
+    if (jstd::release_pages(ptr, size, page_size))
+        return true;
+#if !JSTD_RELEASED_ARRAY_WIN32
+    // The huge pages of a MAP_HUGETLB mapping can only be released as a whole,
+    // madvise() fails with EINVAL if the range is not aligned to them.
+    if (errno == EINVAL) {
+        std::size_t huge_page_size = jstd::mapping_page_size(ptr);
+        if (huge_page_size > page_size)
+            return jstd::release_pages(ptr, size, huge_page_size);
+    }
+#endif
+    return false;
+}
+
+namespace detail {
+
+//
+// A big array that a table has given up in clear(true) or shrink_to_fit(),
+// the pages are returned to the OS, but the address range is kept, so that
+// the next growth to the same size takes it back instead of calling the allocator.
+//
+template <typename T>
+class released_array {
+public:
+    static constexpr std::size_t kMinReleaseBytes = 16 * 1024 * 1024;
+
+private:
+    T *         data_;
+    std::size_t count_;
+
+public:
+    released_array() noexcept : data_(nullptr), count_(0) {}
+
+    released_array(const released_array &) = delete;
+    released_array & operator = (const released_array &) = delete;
+
+    released_array(released_array && other) noexcept
+        : data_(other.data_), count_(other.count_) {
+        other.data_ = nullptr;
+        other.count_ = 0;
+    }
+
+    released_array & operator = (released_array && other) noexcept {
+        // The owner must call deallocate() with it's allocator first.
+        assert(this->data_ == nullptr);
+        this->data_ = other.data_;
+        this->count_ = other.count_;
+        other.data_ = nullptr;
+        other.count_ = 0;
+        return *this;
+    }
+
+    ~released_array() {
+        // The owner must call deallocate() with it's allocator.
+        assert(this->data_ == nullptr);
+    }
+
+    bool is_empty() const noexcept { return (this->data_ == nullptr); }
+    std::size_t count() const noexcept { return this->count_; }
+
+    //
+    // Take the array of count elements (the elements are destroyed already),
+    // returns false if it's too small to be worth it, or it's pages can't be
+    // released (keeping it would pin the memory), then the caller frees it.
+    //
+    template <typename Allocator>
+    bool retain(Allocator & allocator, T * data, std::size_t count) noexcept {
+        if ((count * sizeof(T)) < kMinReleaseBytes)
+            return false;
+        if (!jstd::release_pages(static_cast<void *>(data), count * sizeof(T)))
+            return false;
+        this->deallocate(allocator);
+        this->data_ = data;
+        this->count_ = count;
+        return true;
+    }
+
+    //
+    // Reuse the released array if it has the same size, a bigger request
+    // means it will never be used again, so it's freed.
+    //
+    template <typename Allocator>
+    T * allocate(Allocator & allocator, std::size_t count) {
+        if (JSTD_UNLIKELY(this->data_ != nullptr)) {
+            if (count == this->count_) {
+                T * data = this->data_;
+                this->data_ = nullptr;
+                this->count_ = 0;
+                return data;
+            } else if (count > this->count_) {
+                this->deallocate(allocator);
+            }
+        }
+        return std::allocator_traits<Allocator>::allocate(allocator, count);
+    }
+
+    template <typename Allocator>
+    void deallocate(Allocator & allocator) noexcept {
+        if (this->data_ != nullptr) {
+            std::allocator_traits<Allocator>::deallocate(allocator, this->data_, this->count_);
+            this->data_ = nullptr;
+            this->count_ = 0;
+        }
+    }
+
+    void swap(released_array & other) noexcept {
+        std::swap(this->data_, other.data_);
+        std::swap(this->count_, other.count_);
+    }
+};
+
+} // namespace detail
+} // namespace jstd
+
+#endif // JSTD_MEMORY_RELEASED_ARRAY_H
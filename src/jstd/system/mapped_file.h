@@ -0,0 +1,141 @@
+#ifndef JSTD_SYSTEM_MAPPED_FILE_H
+#define JSTD_SYSTEM_MAPPED_FILE_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <utility>      // For std::swap()
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__MINGW32__) || defined(__CYGWIN__)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#define JSTD_MAPPED_FILE_WIN32  1
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>   // For mmap(), munmap()
+#include <fcntl.h>      // For open()
+#include <unistd.h>     // For close()
+#define JSTD_MAPPED_FILE_WIN32  0
+#endif
+
+namespace jstd {
+
+//
+// A whole file mapped into memory with the copy-on-write pages, the pages
+// are shared with the page cache (and the other processes) until they are written,
+// and the writes are never carried back to the file.
+//
+class mapped_file {
+    char *      data_;
+    std::size_t size_;
+
+public:
+    mapped_file() noexcept : data_(nullptr), size_(0) {}
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file & operator = (const mapped_file &) = delete;
+
+    mapped_file(mapped_file && other) noexcept : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    mapped_file & operator = (mapped_file && other) noexcept {
+        if (&other != this) {
+            this->close();
+            this->swap(other);
+        }
+        return *this;
+    }
+
+    ~mapped_file() {
+        this->close();
+    }
+
+    bool is_open() const noexcept { return (this->data_ != nullptr); }
+
+    char * data() noexcept { return this->data_; }
+    const char * data() const noexcept { return this->data_; }
+
+    std::size_t size() const noexcept { return this->size_; }
+
+    bool open(const char * path) noexcept {
+        this->close();
+        if (path == nullptr)
+            return false;
+#if JSTD_MAPPED_FILE_WIN32
+        HANDLE hFile = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER file_size;
+        if (!::GetFileSizeEx(hFile, &file_size) || (file_size.QuadPart <= 0)) {
+            ::CloseHandle(hFile);
+            return false;
+        }
+
+        HANDLE hMapping = ::CreateFileMappingA(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        ::CloseHandle(hFile);
+        if (hMapping == NULL)
+            return false;
+
+        // The view keeps the file mapping object alive.
+        void * data = ::MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+        ::CloseHandle(hMapping);
+        if (data == NULL)
+            return false;
+
+        this->data_ = static_cast<char *>(data);
+        this->size_ = static_cast<std::size_t>(file_size.QuadPart);
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if ((::fstat(fd, &st) != 0) || (st.st_size <= 0)) {
+            ::close(fd);
+            return false;
+        }
+
+        std::size_t size = static_cast<std::size_t>(st.st_size);
+        void * data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        // The mapping keeps the file alive.
+        ::close(fd);
+        if (data == MAP_FAILED)
+            return false;
+
+        this->data_ = static_cast<char *>(data);
+        this->size_ = size;
+#endif
+        return true;
+    }
+
+    void close() noexcept {
+        if (this->data_ != nullptr) {
+#if JSTD_MAPPED_FILE_WIN32
+            ::UnmapViewOfFile(this->data_);
+#else
+            ::munmap(this->data_, this->size_);
+#endif
+            this->data_ = nullptr;
+            this->size_ = 0;
+        }
+    }
+
+    void swap(mapped_file & other) noexcept {
+        std::swap(this->data_, other.data_);
+        std::swap(this->size_, other.size_);
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_SYSTEM_MAPPED_FILE_H
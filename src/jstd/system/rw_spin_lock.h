@@ -0,0 +1,185 @@
+
+#ifndef JSTD_SYSTEM_RW_SPIN_LOCK_H
+#define JSTD_SYSTEM_RW_SPIN_LOCK_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+#include "jstd/basic/stddef.h"
+#include "jstd/support/x86_intrin.h"
+#include "jstd/system/sleep.h"
+
+namespace jstd {
+
+/* Hint the CPU that we are in a spin-wait loop. */
+static inline
+void cpu_relax()
+{
+#if defined(_MSC_VER) || defined(__SSE2__) || defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+//
+// A reader/writer spin lock in a single 32-bit word.
+//
+// The highest bit is the writer bit, the low 31 bits are the reader count.
+// The writer waits for the readers to drain, new readers are blocked
+// as soon as the writer bit is set, so the writer can't be starved.
+//
+class rw_spin_lock
+{
+public:
+    typedef std::uint32_t value_type;
+
+    static constexpr value_type kWriterBit   = 0x80000000u;
+    static constexpr value_type kReaderMask  = 0x7FFFFFFFu;
+    static constexpr std::uint32_t kSpinLimit = 64;
+
+private:
+    std::atomic<value_type> state_;
+
+public:
+    rw_spin_lock() noexcept : state_(0) {}
+    ~rw_spin_lock() = default;
+
+    rw_spin_lock(const rw_spin_lock &) = delete;
+    rw_spin_lock & operator = (const rw_spin_lock &) = delete;
+
+    ///
+    /// Exclusive (writer)
+    ///
+    JSTD_FORCED_INLINE
+    bool try_lock() noexcept {
+        value_type expected = 0;
+        return this->state_.compare_exchange_strong(expected, kWriterBit,
+                                                    std::memory_order_acquire,
+                                                    std::memory_order_relaxed);
+    }
+
+    void lock() noexcept {
+        std::uint32_t spins = 0;
+        // Take the writer bit first, then wait for the readers to leave.
+        value_type state = this->state_.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((state & kWriterBit) == 0) {
+                if (this->state_.compare_exchange_weak(state, state | kWriterBit,
+                                                       std::memory_order_acquire,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+            } else {
+                backoff(spins);
+                state = this->state_.load(std::memory_order_relaxed);
+            }
+        }
+        while ((this->state_.load(std::memory_order_acquire) & kReaderMask) != 0) {
+            backoff(spins);
+        }
+    }
+
+    JSTD_FORCED_INLINE
+    void unlock() noexcept {
+        this->state_.fetch_and(kReaderMask, std::memory_order_release);
+    }
+
+    ///
+    /// Shared (reader)
+    ///
+    JSTD_FORCED_INLINE
+    bool try_lock_shared() noexcept {
+        value_type state = this->state_.load(std::memory_order_relaxed);
+        return (((state & kWriterBit) == 0) &&
+                this->state_.compare_exchange_strong(state, state + 1,
+                                                     std::memory_order_acquire,
+                                                     std::memory_order_relaxed));
+    }
+
+    void lock_shared() noexcept {
+        std::uint32_t spins = 0;
+        value_type state = this->state_.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((state & kWriterBit) == 0) {
+                if (this->state_.compare_exchange_weak(state, state + 1,
+                                                       std::memory_order_acquire,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+            } else {
+                backoff(spins);
+                state = this->state_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    JSTD_FORCED_INLINE
+    void unlock_shared() noexcept {
+        this->state_.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool is_locked() const noexcept {
+        return ((this->state_.load(std::memory_order_relaxed) & kWriterBit) != 0);
+    }
+
+private:
+    static inline void backoff(std::uint32_t & spins) noexcept {
+        if (JSTD_LIKELY(spins < kSpinLimit)) {
+            spins++;
+            jstd::cpu_relax();
+        } else {
+            jstd::thread_yield();
+        }
+    }
+};
+
+//
+// RAII guards, work with any lock which has lock()/unlock()
+// or lock_shared()/unlock_shared().
+//
+template <typename Lock>
+class exclusive_lock_guard
+{
+    Lock & lock_;
+
+public:
+    explicit exclusive_lock_guard(Lock & lock) noexcept : lock_(lock) {
+        this->lock_.lock();
+    }
+    ~exclusive_lock_guard() {
+        this->lock_.unlock();
+    }
+
+    exclusive_lock_guard(const exclusive_lock_guard &) = delete;
+    exclusive_lock_guard & operator = (const exclusive_lock_guard &) = delete;
+};
+
+template <typename Lock>
+class shared_lock_guard
+{
+    Lock & lock_;
+
+public:
+    explicit shared_lock_guard(Lock & lock) noexcept : lock_(lock) {
+        this->lock_.lock_shared();
+    }
+    ~shared_lock_guard() {
+        this->lock_.unlock_shared();
+    }
+
+    shared_lock_guard(const shared_lock_guard &) = delete;
+    shared_lock_guard & operator = (const shared_lock_guard &) = delete;
+};
+
+} // namespace jstd
+
+#endif // JSTD_SYSTEM_RW_SPIN_LOCK_H
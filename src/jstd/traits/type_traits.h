@@ -14,6 +14,7 @@
 #include <cassert>
 
 #include <string>
+#include <vector>
 #include <tuple>
 #include <memory>       // For std::allocator<T>
 #include <utility>      // For std::pair<T1, T2>
@@ -349,16 +350,18 @@ struct is_relocatable<const T> : is_relocatable<T> {};
 // According to https://github.com/abseil/abseil-cpp/issues/1479, this does not
 // work with NVCC either.
 //
+namespace type_traits_detail {
+
 #if __has_builtin(__is_trivially_relocatable) && \
     (defined(__cpp_impl_trivially_relocatable) ||    \
      (!defined(__clang__) && !defined(__APPLE__) && !defined(__NVCC__)))
 template <class T>
-struct is_trivially_relocatable : std::integral_constant<bool, __is_trivially_relocatable(T)> {};
+struct is_trivially_relocatable_impl : std::integral_constant<bool, __is_trivially_relocatable(T)> {};
 #elif __has_builtin(__is_trivially_relocatable) && defined(__clang__) && \
     !(defined(_WIN32) || defined(_WIN64)) && !defined(__APPLE__) &&      \
     !defined(__NVCC__)
 template <class T>
-struct is_trivially_relocatable
+struct is_trivially_relocatable_impl
     : std::integral_constant<bool, std::is_trivially_copyable<T>::value ||
                                    (__is_trivially_relocatable(T) &&
                                     std::is_trivially_move_assignable<T>::value)> {};
@@ -369,9 +372,80 @@ struct is_trivially_relocatable
 // relocatable.
 //
 template <class T>
-struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+struct is_trivially_relocatable_impl : std::is_trivially_copyable<T> {};
 #endif // __is_trivially_relocatable(T)
 
+} // namespace type_traits_detail
+
+//
+// The std::basic_string<> and std::vector<> with std::allocator<> only hold
+// the pointers and the sizes on libc++, the old COW string of libstdc++ and
+// MSVC without the iterator debugging. The SSO string of libstdc++ points to
+// it's own local buffer, and the debug containers are linked with their
+// iterators, they can't be moved by memcpy.
+//
+#ifndef JSTD_STD_STRING_IS_RELOCATABLE
+#if defined(_LIBCPP_VERSION)
+#define JSTD_STD_STRING_IS_RELOCATABLE      1
+#elif defined(__GLIBCXX__) && !defined(_GLIBCXX_DEBUG) && \
+      defined(_GLIBCXX_USE_CXX11_ABI) && (_GLIBCXX_USE_CXX11_ABI == 0)
+#define JSTD_STD_STRING_IS_RELOCATABLE      1
+#elif defined(_MSC_VER) && defined(_ITERATOR_DEBUG_LEVEL) && (_ITERATOR_DEBUG_LEVEL == 0)
+#define JSTD_STD_STRING_IS_RELOCATABLE      1
+#else
+#define JSTD_STD_STRING_IS_RELOCATABLE      0
+#endif
+#endif // JSTD_STD_STRING_IS_RELOCATABLE
+
+#ifndef JSTD_STD_VECTOR_IS_RELOCATABLE
+#if defined(_LIBCPP_VERSION)
+#define JSTD_STD_VECTOR_IS_RELOCATABLE      1
+#elif defined(__GLIBCXX__) && !defined(_GLIBCXX_DEBUG)
+#define JSTD_STD_VECTOR_IS_RELOCATABLE      1
+#elif defined(_MSC_VER) && defined(_ITERATOR_DEBUG_LEVEL) && (_ITERATOR_DEBUG_LEVEL == 0)
+#define JSTD_STD_VECTOR_IS_RELOCATABLE      1
+#else
+#define JSTD_STD_VECTOR_IS_RELOCATABLE      0
+#endif
+#endif // JSTD_STD_VECTOR_IS_RELOCATABLE
+
+//
+// Trait which can be specialized for the user types to opt in, the tables move
+// the slots of such types by memcpy in the rehash and the move assignment.
+//
+// Example:
+//   template <>
+//   struct is_trivially_relocatable<MyType> : std::true_type {};
+//
+template <class T>
+struct is_trivially_relocatable : type_traits_detail::is_trivially_relocatable_impl<T> {};
+
+template <class T>
+struct is_trivially_relocatable<const T> : is_trivially_relocatable<T> {};
+
+template <class T, class U>
+struct is_trivially_relocatable<std::pair<T, U>>
+    : std::integral_constant<bool, (type_traits_detail::is_trivially_relocatable_impl<std::pair<T, U>>::value ||
+                                   (is_trivially_relocatable<T>::value &&
+                                    is_trivially_relocatable<U>::value))> {};
+
+template <class T>
+struct is_trivially_relocatable<std::unique_ptr<T, std::default_delete<T>>> : std::true_type {};
+
+template <class T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template <class T>
+struct is_trivially_relocatable<std::weak_ptr<T>> : std::true_type {};
+
+template <class CharT, class Traits>
+struct is_trivially_relocatable<std::basic_string<CharT, Traits, std::allocator<CharT>>>
+    : std::integral_constant<bool, (JSTD_STD_STRING_IS_RELOCATABLE != 0)> {};
+
+template <class T>
+struct is_trivially_relocatable<std::vector<T, std::allocator<T>>>
+    : std::integral_constant<bool, (JSTD_STD_VECTOR_IS_RELOCATABLE != 0)> {};
+
 template <typename Caller, typename Function, typename = void>
 struct is_call_possible : public std::false_type {};
 
@@ -16,6 +16,6 @@
 #define JSTD_VERSION_STR        JSTD_TO_DOT3(JSTD_VERSION_MAJOR, JSTD_VERSION_MINOR, JSTD_VERSION_PATCH)
 #define JSTD_VERSION            JSTD_TO_VER3(JSTD_VERSION_MAJOR, JSTD_VERSION_MINOR, JSTD_VERSION_PATCH)
 
-#define JSTD_BUILD_DATE         "2025-01-25"
+#define JSTD_BUILD_DATE         "2024-12-05"
 
 #endif // JSTD_CONFIG_VERSION_H
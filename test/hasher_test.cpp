@@ -0,0 +1,320 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <jstd/basic/stddef.h>
+#include <jstd/hasher/hashes.h>
+#include <jstd/hasher/hash_crc32.h>
+#include <jstd/test/Test.h>
+
+static int s_failed_tests = 0;
+
+static void test_result(const char * name, bool passed)
+{
+    printf("Test: %-56s ", name);
+    if (passed) {
+        jstd::print_passed_ln();
+    } else {
+        jstd::print_failed_ln();
+        s_failed_tests++;
+    }
+}
+
+//
+// The test vectors of wyhash final version 4.2, with the default secret,
+// the seed of each one is its index.
+//
+void wyhash_test()
+{
+    static const char * const kMessages[] = {
+        "",
+        "a",
+        "abc",
+        "message digest",
+        "abcdefghijklmnopqrstuvwxyz",
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+        "12345678901234567890123456789012345678901234567890123456789012345678901234567890"
+    };
+    static const std::uint64_t kHashes[] = {
+        0x93228a4de0eec5a2ull,
+        0xc5bac3db178713c4ull,
+        0xa97f2f7b1d9b3314ull,
+        0x786d1f1df3801df4ull,
+        0xdca5a8138ad37c87ull,
+        0xb9e734f117cfaf70ull,
+        0x6cc5eab49a92d617ull
+    };
+
+    bool passed = true;
+    for (std::size_t i = 0; i < sizeof(kHashes) / sizeof(kHashes[0]); i++) {
+        std::uint64_t hash = jstd::hashes::wyhash(kMessages[i], strlen(kMessages[i]), i);
+        if (hash != kHashes[i])
+            passed = false;
+    }
+    test_result("hashes::wyhash(), the test vectors", passed);
+
+    jstd::WyHash hasher;
+    std::string key(kMessages[6]);
+    passed = (hasher(key) == jstd::hashes::wyhash(key.data(), key.size())) &&
+             (hasher(key.c_str()) == hasher(key)) &&
+             (hasher(12345) == jstd::hashes::wyhash64(12345, 0));
+    test_result("WyHash", passed);
+}
+
+//
+// The keys of all the lengths from 0 to max_length, with the pseudo random bytes.
+//
+static std::vector<std::string> make_test_keys(std::size_t max_length)
+{
+    std::vector<std::string> keys;
+    std::uint32_t seed = 2166136261u;
+    for (std::size_t length = 0; length <= max_length; length++) {
+        std::string key(length, '\0');
+        // hash_crc32() reads the last partial word of a key as a whole word.
+        key.reserve(length + sizeof(std::uint64_t));
+        for (std::size_t i = 0; i < length; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            key[i] = static_cast<char>(seed >> 24);
+        }
+        keys.push_back(std::move(key));
+    }
+    return keys;
+}
+
+//
+// hash_crc32_many() must give the same hash codes as hash_crc32() key by key,
+// the short and the long keys are mixed in a block.
+//
+void hash_crc32_many_test()
+{
+    std::vector<std::string> keys = make_test_keys(300);
+    std::vector<std::uint32_t> hash_codes(keys.size());
+    jstd::hashes::hash_crc32_many(keys.data(), keys.size(), hash_codes.data());
+
+    bool passed = true;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        if (hash_codes[i] != jstd::hashes::hash_crc32(keys[i].data(), keys[i].size()))
+            passed = false;
+    }
+
+    // The partial blocks of the lanes.
+    for (std::size_t count = 0; count <= 9; count++) {
+        std::size_t first = keys.size() - count;
+        jstd::hashes::hash_crc32_many(keys.data() + first, count, hash_codes.data());
+        for (std::size_t i = 0; i < count; i++) {
+            if (hash_codes[i] != jstd::hashes::hash_crc32(keys[first + i].data(), keys[first + i].size()))
+                passed = false;
+        }
+    }
+    test_result("hashes::hash_crc32_many()", passed);
+}
+
+//
+// The integer keys, the vector lanes and the scalar tail are both covered.
+//
+static std::vector<std::size_t> make_test_integers(std::size_t count)
+{
+    std::vector<std::size_t> values;
+    std::uint64_t seed = 1469598103934665603ull;
+    for (std::size_t i = 0; i < count; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        values.push_back((i < 8) ? i : static_cast<std::size_t>(seed));
+    }
+    return values;
+}
+
+template <typename BatchHash, typename Hash>
+static bool batch_hash_equals(const std::vector<std::size_t> & values,
+                              BatchHash && batch_hash, Hash && hash)
+{
+    bool passed = true;
+    std::vector<std::size_t> hash_codes(values.size());
+    for (std::size_t count = 0; count <= values.size(); count++) {
+        batch_hash(values.data(), count, hash_codes.data());
+        for (std::size_t i = 0; i < count; i++) {
+            if (hash_codes[i] != hash(values[i]))
+                passed = false;
+        }
+    }
+    return passed;
+}
+
+//
+// The batch hashes must give the same hash codes as the scalar ones,
+// the counts cover the partial vector blocks.
+//
+void batch_hash_test()
+{
+    std::vector<std::size_t> values = make_test_integers(37);
+
+    bool passed = batch_hash_equals(values,
+        [](const std::size_t * keys, std::size_t count, std::size_t * hash_codes) {
+            jstd::hashes::int_hash_crc32_many(keys, count, hash_codes);
+        },
+        [](std::size_t key) { return jstd::hashes::int_hash_crc32(key); });
+    test_result("hashes::int_hash_crc32_many()", passed);
+
+    passed = batch_hash_equals(values,
+        [](const std::size_t * keys, std::size_t count, std::size_t * hash_codes) {
+            jstd::hashes::fibonacci_hash_many(keys, count, hash_codes);
+        },
+        [](std::size_t key) { return jstd::hashes::fibonacci_hash(key); });
+    test_result("hashes::fibonacci_hash_many()", passed);
+
+    passed = batch_hash_equals(values,
+        [](const std::size_t * keys, std::size_t count, std::size_t * hash_codes) {
+            jstd::hashes::mum_hash_many(keys, count, hash_codes);
+        },
+        [](std::size_t key) { return jstd::hashes::mum_hash(key); });
+    test_result("hashes::mum_hash_many()", passed);
+
+    passed = batch_hash_equals(values,
+        [](const std::size_t * keys, std::size_t count, std::size_t * hash_codes) {
+            jstd::hashes::mum_mul_mix_many(keys, count, hash_codes);
+        },
+        [](std::size_t key) { return jstd::hashes::mum_mul_mix(key); });
+    test_result("hashes::mum_mul_mix_many()", passed);
+
+    jstd::fibonacci_hash_policy<std::hash<std::size_t>> fibonacci_policy;
+    passed = batch_hash_equals(values,
+        [&](const std::size_t * keys, std::size_t count, std::size_t * hash_codes) {
+            fibonacci_policy.get_hash_codes(keys, count, hash_codes);
+        },
+        [&](std::size_t key) { return fibonacci_policy.get_hash_code(key); });
+    test_result("fibonacci_hash_policy::get_hash_codes()", passed);
+
+    jstd::mum_hash_policy<std::hash<std::size_t>> mum_policy;
+    passed = batch_hash_equals(values,
+        [&](const std::size_t * keys, std::size_t count, std::size_t * hash_codes) {
+            mum_policy.get_hash_codes(keys, count, hash_codes);
+        },
+        [&](std::size_t key) { return mum_policy.get_hash_code(key); });
+    test_result("mum_hash_policy::get_hash_codes()", passed);
+}
+
+//
+// The keys of 48 bytes or more take the 3-way path of intel_crc32_x64(),
+// it must give the same crc as the serial chain of intel_crc32_x64_continue(),
+// the unaligned keys and the lengths around the 3 * 64 and 3 * 16 blocks too.
+//
+void hash_crc32_3way_test()
+{
+#if defined(__SSE4_2__) && JSTD_IS_X86_64
+    std::vector<std::string> keys = make_test_keys(500);
+
+    bool passed = true;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        const std::string & key = keys[i];
+        for (std::size_t offset = 0; offset < 8 && offset <= key.size(); offset++) {
+            const char * data = key.data() + offset;
+            std::size_t length = key.size() - offset;
+            std::uint32_t serial_crc = jstd::hashes::intel_crc32_x64_continue(~std::uint64_t(0), data, 0, length);
+            if (jstd::hashes::hash_crc32(data, length) != serial_crc)
+                passed = false;
+        }
+    }
+    test_result("hashes::hash_crc32(), the 3-way and the serial crc", passed);
+#endif
+}
+
+struct AesTestKey24 {
+    std::uint64_t id;
+    std::uint32_t parts[4];
+};
+
+struct AesTestKey40 {
+    std::uint64_t words[5];
+};
+
+template <typename Key>
+static bool all_distinct(const std::vector<Key> & keys)
+{
+    jstd::AesHash<Key> hasher;
+    std::vector<std::size_t> hash_codes;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hash_codes.push_back(hasher(keys[i]));
+    }
+    std::sort(hash_codes.begin(), hash_codes.end());
+    return (std::adjacent_find(hash_codes.begin(), hash_codes.end()) == hash_codes.end());
+}
+
+//
+// AesHash<T> must be stable for the equal keys and hash all the bytes of T,
+// the keys of 40 bytes end with a block that overlaps the previous one.
+//
+void aes_hash_test()
+{
+    std::vector<AesTestKey24> keys24;
+    std::vector<AesTestKey40> keys40;
+    for (std::uint64_t i = 0; i < 20000; i++) {
+        AesTestKey24 key24;
+        key24.id = i / 4;
+        for (std::size_t n = 0; n < 4; n++) {
+            key24.parts[n] = static_cast<std::uint32_t>((n == (i % 4)) ? i : 0);
+        }
+        keys24.push_back(key24);
+
+        AesTestKey40 key40;
+        std::memset(&key40, 0, sizeof(key40));
+        key40.words[i % 5] = i + 1;
+        keys40.push_back(key40);
+    }
+
+    jstd::AesHash<AesTestKey24> hasher24;
+    jstd::AesHash<AesTestKey40> hasher40;
+    bool passed = true;
+    for (std::size_t i = 0; i < keys24.size(); i++) {
+        AesTestKey24 copy24 = keys24[i];
+        AesTestKey40 copy40 = keys40[i];
+        if ((hasher24(copy24) != hasher24(keys24[i])) ||
+            (hasher40(copy40) != hasher40(keys40[i])))
+            passed = false;
+    }
+    test_result("AesHash<T>, the equal keys", passed);
+
+    // Flip each byte of the key alone.
+    AesTestKey40 base;
+    std::memset(&base, 0, sizeof(base));
+    std::vector<AesTestKey40> flipped(1, base);
+    for (std::size_t offset = 0; offset < sizeof(AesTestKey40); offset++) {
+        AesTestKey40 key = base;
+        reinterpret_cast<unsigned char *>(&key)[offset] ^= 0x01;
+        flipped.push_back(key);
+    }
+    passed = all_distinct(flipped) && all_distinct(keys24) && all_distinct(keys40);
+    test_result("AesHash<T>, the distinct keys", passed);
+
+    // The prefixes of a buffer, the lengths around the 16 bytes blocks.
+    std::vector<std::size_t> hash_codes;
+    unsigned char buffer[80];
+    std::memset(buffer, 0, sizeof(buffer));
+    for (std::size_t length = 0; length <= sizeof(buffer); length++) {
+        hash_codes.push_back(static_cast<std::size_t>(jstd::hashes::aes_hash(buffer, length)));
+    }
+    hash_codes.push_back(static_cast<std::size_t>(jstd::hashes::aes_hash(buffer, 16, 1)));
+    std::sort(hash_codes.begin(), hash_codes.end());
+    passed = (std::adjacent_find(hash_codes.begin(), hash_codes.end()) == hash_codes.end());
+    test_result("hashes::aes_hash(), the lengths and the seed", passed);
+}
+
+int main(int argc, char * argv[])
+{
+    wyhash_test();
+    hash_crc32_many_test();
+    hash_crc32_3way_test();
+    batch_hash_test();
+    aes_hash_test();
+
+    printf("\n");
+    return ((s_failed_tests == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
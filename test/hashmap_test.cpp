@@ -0,0 +1,1747 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+
+#include <jstd/hashmap/group15_flat_map.hpp>
+#include <jstd/hashmap/group16_flat_map.hpp>
+#include <jstd/hashmap/group30_flat_map.hpp>
+#include <jstd/hashmap/group15_flat_set.hpp>
+#include <jstd/hashmap/group16_flat_set.hpp>
+#include <jstd/hashmap/group15_node_map.hpp>
+#include <jstd/hashmap/group16_node_map.hpp>
+#include <jstd/hashmap/robin_hash_map.h>
+#include <jstd/hashmap/read_mostly_robin_hash_map.h>
+#include <jstd/hashmap/concurrent_group15_flat_map.hpp>
+#include <jstd/hashmap/concurrent_group16_flat_map.hpp>
+#include <jstd/hashmap/detail/region_rehash.h>
+#include <jstd/memory/huge_page_allocator.h>
+#include <jstd/memory/released_array.h>
+#include <jstd/test/Test.h>
+
+static int s_failed_tests = 0;
+
+static void test_result(const char * name, bool passed)
+{
+    printf("Test: %-56s ", name);
+    if (passed) {
+        jstd::print_passed_ln();
+    } else {
+        jstd::print_failed_ln();
+        s_failed_tests++;
+    }
+}
+
+//
+// A key type which is constructible from unsigned, for the heterogeneous inserts.
+//
+struct ConvertibleKey {
+    std::uint64_t value;
+
+    ConvertibleKey(unsigned v = 0) : value(v) {}
+
+    bool operator == (const ConvertibleKey & rhs) const {
+        return (this->value == rhs.value);
+    }
+};
+
+struct ConvertibleKeyHash {
+    std::size_t operator () (const ConvertibleKey & key) const {
+        return std::hash<std::uint64_t>()(key.value);
+    }
+};
+
+template <typename HashMap>
+bool insert_convertible_pair_test()
+{
+    static const unsigned kCount = 1000;
+    HashMap hashmap;
+    for (unsigned i = 0; i < kCount; i++) {
+        hashmap.insert(std::pair<unsigned, unsigned>(i, i * 2));
+        std::pair<unsigned, unsigned> lvalue(i, i * 3);
+        hashmap.insert(lvalue);
+    }
+
+    bool passed = (hashmap.size() == kCount);
+    for (unsigned i = 0; i < kCount; i++) {
+        auto iter = hashmap.find(ConvertibleKey(i));
+        if ((iter == hashmap.end()) || (iter->second != i * 2))
+            passed = false;
+    }
+    return passed;
+}
+
+void heterogeneous_insert_test()
+{
+    test_result("group16_flat_map::insert(pair<convertible, V>)",
+        insert_convertible_pair_test<jstd::group16_flat_map<ConvertibleKey, unsigned, ConvertibleKeyHash>>());
+    test_result("group15_flat_map::insert(pair<convertible, V>)",
+        insert_convertible_pair_test<jstd::group15_flat_map<ConvertibleKey, unsigned, ConvertibleKeyHash>>());
+}
+
+//
+// insert, find, erase, iterate and rehash, from the default empty groups on.
+//
+template <typename HashMap>
+bool basic_map_test()
+{
+    static const std::size_t kCount = 100000;
+    HashMap hashmap;
+    bool passed = (hashmap.find(0) == hashmap.end()) && (hashmap.begin() == hashmap.end());
+
+    for (std::size_t i = 0; i < kCount; i++) {
+        hashmap.emplace(i, i * 2);
+    }
+    passed = passed && (hashmap.size() == kCount);
+    for (std::size_t i = 0; i < kCount; i++) {
+        auto iter = hashmap.find(i);
+        if ((iter == hashmap.end()) || (iter->second != i * 2))
+            passed = false;
+    }
+    passed = passed && (hashmap.find(kCount) == hashmap.end());
+
+    for (std::size_t i = 0; i < kCount; i += 2) {
+        hashmap.erase(i);
+    }
+    std::size_t visits = 0;
+    for (auto iter = hashmap.begin(); iter != hashmap.end(); ++iter) {
+        if (((iter->first % 2) == 0) || (iter->second != iter->first * 2))
+            passed = false;
+        visits++;
+    }
+    passed = passed && (hashmap.size() == kCount / 2) && (visits == kCount / 2);
+
+    hashmap.rehash(hashmap.bucket_count() * 4);
+    for (std::size_t i = 0; i < kCount; i++) {
+        bool is_exists = (hashmap.find(i) != hashmap.end());
+        if (is_exists != ((i % 2) == 1))
+            passed = false;
+    }
+
+    hashmap.clear();
+    passed = passed && (hashmap.size() == 0) && (hashmap.find(1) == hashmap.end());
+    hashmap.emplace(1, 2);
+    return (passed && (hashmap.size() == 1) && (hashmap.find(1)->second == 2));
+}
+
+void basic_map_test()
+{
+    test_result("group16_flat_map, insert, find, erase, rehash",
+                basic_map_test<jstd::group16_flat_map<std::size_t, std::size_t>>());
+    test_result("group15_flat_map, insert, find, erase, rehash",
+                basic_map_test<jstd::group15_flat_map<std::size_t, std::size_t>>());
+    test_result("group30_flat_map, insert, find, erase, rehash",
+                basic_map_test<jstd::group30_flat_map<std::size_t, std::size_t>>());
+}
+
+//
+// A key larger than 16 bytes which isn't plain, the group16 table keeps its hash
+// codes in the hash array for such a key if GROUP16_USE_HASH_ARRAY is on.
+//
+template <typename HashMap>
+bool string_key_map_test()
+{
+    static const std::size_t kCount = 50000;
+    HashMap hashmap;
+    bool passed = (hashmap.find(std::string("0")) == hashmap.end());
+
+    for (std::size_t i = 0; i < kCount; i++) {
+        hashmap.emplace(std::to_string(i), i);
+    }
+    passed = passed && (hashmap.size() == kCount);
+    for (std::size_t i = 0; i < kCount; i++) {
+        auto iter = hashmap.find(std::to_string(i));
+        if ((iter == hashmap.end()) || (iter->second != i))
+            passed = false;
+    }
+    passed = passed && (hashmap.find(std::to_string(kCount)) == hashmap.end());
+
+    for (std::size_t i = 0; i < kCount; i += 2) {
+        hashmap.erase(std::to_string(i));
+    }
+    passed = passed && (hashmap.size() == kCount / 2);
+
+    hashmap.rehash(hashmap.bucket_count() * 4);
+    HashMap copy(hashmap);
+    passed = passed && (copy.size() == kCount / 2);
+    for (std::size_t i = 0; i < kCount; i++) {
+        auto iter = copy.find(std::to_string(i));
+        bool is_exists = (iter != copy.end());
+        if ((is_exists != ((i % 2) == 1)) || (is_exists && (iter->second != i)))
+            passed = false;
+        if ((hashmap.find(std::to_string(i)) != hashmap.end()) != is_exists)
+            passed = false;
+    }
+
+    std::size_t visits = 0;
+    for (auto iter = copy.begin(); iter != copy.end(); ++iter) {
+        if (iter->first != std::to_string(iter->second))
+            passed = false;
+        visits++;
+    }
+    return (passed && (visits == kCount / 2));
+}
+
+void string_key_map_test()
+{
+    test_result("group16_flat_map<string, V>, insert, find, erase, copy",
+                string_key_map_test<jstd::group16_flat_map<std::string, std::size_t>>());
+}
+
+//
+// insert, find, erase, iterate and rehash a set, the keys are the values.
+//
+template <typename HashSet>
+bool basic_set_test()
+{
+    static const std::size_t kCount = 100000;
+    HashSet hashset;
+    bool passed = (hashset.find(0) == hashset.end()) && (hashset.begin() == hashset.end());
+
+    for (std::size_t i = 0; i < kCount; i++) {
+        if (!hashset.insert(i).second)
+            passed = false;
+    }
+    // The duplicate inserts return the existing key.
+    for (std::size_t i = 0; i < kCount; i += 1000) {
+        auto result = hashset.emplace(i);
+        if (result.second || (*result.first != i))
+            passed = false;
+    }
+    passed = passed && (hashset.size() == kCount);
+    for (std::size_t i = 0; i < kCount; i++) {
+        auto iter = hashset.find(i);
+        if ((iter == hashset.end()) || (*iter != i))
+            passed = false;
+    }
+    passed = passed && !hashset.contains(kCount) && (hashset.count(kCount) == 0);
+
+    // Erase the even keys, by key and by iterator.
+    for (std::size_t i = 0; i < kCount; i += 4) {
+        if (hashset.erase(i) != 1)
+            passed = false;
+        hashset.erase(hashset.find(i + 2));
+    }
+    passed = passed && (hashset.erase(0) == 0);
+
+    std::size_t visits = 0;
+    for (auto iter = hashset.begin(); iter != hashset.end(); ++iter) {
+        if ((*iter % 2) == 0)
+            passed = false;
+        visits++;
+    }
+    passed = passed && (hashset.size() == kCount / 2) && (visits == kCount / 2);
+
+    hashset.rehash(hashset.bucket_count() * 4);
+    HashSet copy(hashset);
+    for (std::size_t i = 0; i < kCount; i++) {
+        bool expected = ((i % 2) == 1);
+        if ((hashset.contains(i) != expected) || (copy.contains(i) != expected))
+            passed = false;
+    }
+
+    hashset.clear();
+    passed = passed && (hashset.size() == 0) && !hashset.contains(1) && (copy.size() == kCount / 2);
+    hashset.insert(1);
+    return (passed && (hashset.size() == 1) && (*hashset.find(1) == 1));
+}
+
+void basic_set_test()
+{
+    test_result("group16_flat_set, insert, find, erase, rehash",
+                basic_set_test<jstd::group16_flat_set<std::size_t>>());
+    test_result("group15_flat_set, insert, find, erase, rehash",
+                basic_set_test<jstd::group15_flat_set<std::size_t>>());
+}
+
+//
+// The wrapper API: insert(first, last) inserts every element of the range,
+// insert_or_assign() assigns an existing key, and erase(iterator) returns
+// the next iterator, so the erase-in-a-loop idiom visits every element.
+//
+template <typename HashMap>
+bool wrapper_api_test()
+{
+    typedef typename HashMap::const_iterator const_iterator;
+
+    static const std::size_t kCount = 10000;
+
+    // The keys of the second half are repeated, the first value is kept.
+    std::vector<std::pair<std::size_t, std::size_t>> values;
+    for (std::size_t i = 0; i < kCount; i++) {
+        values.push_back(std::make_pair(i, i * 2));
+    }
+    for (std::size_t i = kCount / 2; i < kCount; i++) {
+        values.push_back(std::make_pair(i, i * 5));
+    }
+
+    HashMap hashmap;
+    hashmap.insert(values.begin(), values.end());
+    bool passed = (hashmap.size() == kCount);
+    for (std::size_t i = 0; i < kCount; i++) {
+        auto iter = hashmap.find(i);
+        if ((iter == hashmap.end()) || (iter->second != i * 2))
+            passed = false;
+    }
+
+    // insert_or_assign(), the new keys are inserted and the existing keys are assigned.
+    for (std::size_t i = 0; i < kCount + 100; i += 3) {
+        std::size_t key = i;
+        auto result = ((i % 2) == 0) ? hashmap.insert_or_assign(key, i * 3)
+                                     : hashmap.insert_or_assign(std::move(key), i * 3);
+        if ((result.second != (i >= kCount)) || (result.first->first != i) ||
+            (result.first->second != i * 3))
+            passed = false;
+    }
+    auto hint_iter = hashmap.insert_or_assign(hashmap.cbegin(), std::size_t(1), std::size_t(7));
+    passed = passed && (hint_iter->first == 1) && (hint_iter->second == 7);
+    for (std::size_t i = 0; i < kCount + 100; i++) {
+        std::size_t expected = (i == 1) ? 7 : (((i % 3) == 0) ? i * 3 : i * 2);
+        auto iter = hashmap.find(i);
+        bool is_exists = (i < kCount) || ((i % 3) == 0);
+        if ((iter != hashmap.end()) != is_exists)
+            passed = false;
+        else if (is_exists && (iter->second != expected))
+            passed = false;
+    }
+    std::size_t size = hashmap.size();
+
+    // Erase the even keys in one pass, by erase(iterator) and erase(const_iterator).
+    std::size_t visits = 0, erased = 0;
+    for (auto iter = hashmap.begin(); iter != hashmap.end(); ) {
+        visits++;
+        if ((iter->first % 4) == 0) {
+            iter = hashmap.erase(iter);
+            erased++;
+        } else if ((iter->first % 4) == 2) {
+            iter = hashmap.erase(const_iterator(iter));
+            erased++;
+        } else {
+            ++iter;
+        }
+    }
+    passed = passed && (visits == size) && (hashmap.size() == size - erased);
+    for (auto iter = hashmap.begin(); iter != hashmap.end(); ++iter) {
+        if ((iter->first % 2) == 0)
+            passed = false;
+    }
+    return passed;
+}
+
+void wrapper_api_test()
+{
+    test_result("group16_flat_map, insert(first, last), erase(iter)",
+                wrapper_api_test<jstd::group16_flat_map<std::size_t, std::size_t>>());
+    test_result("group15_flat_map, insert(first, last), erase(iter)",
+                wrapper_api_test<jstd::group15_flat_map<std::size_t, std::size_t>>());
+    test_result("group16_node_map, insert(first, last), erase(iter)",
+                wrapper_api_test<jstd::group16_node_map<std::size_t, std::size_t>>());
+    test_result("group15_node_map, insert(first, last), erase(iter)",
+                wrapper_api_test<jstd::group15_node_map<std::size_t, std::size_t>>());
+}
+
+//
+// A value whose move constructor isn't noexcept, the rehash moves it serially.
+//
+struct MayThrowMoveValue {
+    std::size_t value;
+
+    MayThrowMoveValue(std::size_t v = 0) : value(v) {}
+    MayThrowMoveValue(const MayThrowMoveValue & src) : value(src.value) {}
+    MayThrowMoveValue(MayThrowMoveValue && src) : value(src.value) {}
+
+    MayThrowMoveValue & operator = (const MayThrowMoveValue & rhs) {
+        this->value = rhs.value;
+        return *this;
+    }
+
+    bool operator == (const MayThrowMoveValue & rhs) const {
+        return (this->value == rhs.value);
+    }
+};
+
+template <typename HashMap>
+bool same_contents(const HashMap & hashmap, const HashMap & expected)
+{
+    if (hashmap.size() != expected.size())
+        return false;
+    std::size_t visits = 0;
+    for (auto iter = hashmap.begin(); iter != hashmap.end(); ++iter) {
+        auto expected_iter = expected.find(iter->first);
+        if ((expected_iter == expected.end()) || !(expected_iter->second == iter->second))
+            return false;
+        visits++;
+    }
+    return (visits == expected.size());
+}
+
+//
+// The old table is bigger than kMinParallelRehashSize, so rehash(n, 4) reinserts it
+// by 4 threads, it must give the same contents as the serial rehash.
+//
+template <typename HashMap, typename ValueMaker>
+bool parallel_rehash_test(ValueMaker && make_value)
+{
+    static const std::size_t kCount = 200000;
+    HashMap hashmap;
+    for (std::size_t i = 0; i < kCount; i++) {
+        hashmap.emplace(i * 7, make_value(i));
+    }
+    HashMap expected(hashmap);
+
+    std::size_t new_capacity = hashmap.bucket_count() * 2;
+    hashmap.rehash(new_capacity, 4);
+    expected.rehash(new_capacity, 1);
+    bool passed = (hashmap.bucket_count() == expected.bucket_count()) &&
+                  same_contents(hashmap, expected);
+
+    hashmap.reserve(kCount * 8, 4);
+    return (passed && same_contents(hashmap, expected));
+}
+
+//
+// build_from() by 4 threads, the duplicate keys keep the first value like insert().
+//
+template <typename HashMap>
+bool parallel_build_from_test()
+{
+    static const std::size_t kCount = 200000;
+    std::vector<std::pair<std::size_t, std::size_t>> values;
+    for (std::size_t i = 0; i < kCount; i++) {
+        values.emplace_back((i * 13) % (kCount / 2), i);
+    }
+
+    HashMap hashmap;
+    hashmap.emplace(kCount, kCount);
+    hashmap.build_from(values.begin(), values.end(), 4);
+
+    HashMap expected;
+    expected.emplace(kCount, kCount);
+    expected.insert(values.begin(), values.end());
+    return same_contents(hashmap, expected);
+}
+
+void parallel_rehash_test()
+{
+    auto make_size = [](std::size_t i) { return i; };
+    auto make_string = [](std::size_t i) { return std::to_string(i); };
+    auto make_may_throw = [](std::size_t i) { return MayThrowMoveValue(i); };
+
+    test_result("group16_flat_map::rehash(n, 4), <size_t, size_t>",
+        parallel_rehash_test<jstd::group16_flat_map<std::size_t, std::size_t>>(make_size));
+    test_result("group16_flat_map::rehash(n, 4), <size_t, string>",
+        parallel_rehash_test<jstd::group16_flat_map<std::size_t, std::string>>(make_string));
+    test_result("group16_flat_map::rehash(n, 4), throwing move",
+        parallel_rehash_test<jstd::group16_flat_map<std::size_t, MayThrowMoveValue>>(make_may_throw));
+    test_result("group15_flat_map::rehash(n, 4), <size_t, string>",
+        parallel_rehash_test<jstd::group15_flat_map<std::size_t, std::string>>(make_string));
+    test_result("group15_flat_map::rehash(n, 4), throwing move",
+        parallel_rehash_test<jstd::group15_flat_map<std::size_t, MayThrowMoveValue>>(make_may_throw));
+    test_result("group30_flat_map::rehash(n, 4), <size_t, size_t>",
+        parallel_rehash_test<jstd::group30_flat_map<std::size_t, std::size_t>>(make_size));
+
+    test_result("group16_flat_map::build_from(first, last, 4)",
+        parallel_build_from_test<jstd::group16_flat_map<std::size_t, std::size_t>>());
+    test_result("group15_flat_map::build_from(first, last, 4)",
+        parallel_build_from_test<jstd::group15_flat_map<std::size_t, std::size_t>>());
+}
+
+//
+// Insert the keys until a grow starts an incremental rehash.
+//
+template <typename HashMap>
+std::size_t fill_until_migrating(HashMap & hashmap)
+{
+    std::size_t count = 0;
+    while (!hashmap.is_migrating() && (count < 1000000)) {
+        hashmap.emplace(count, count * 2);
+        count++;
+    }
+    return count;
+}
+
+template <typename HashMap>
+bool const_find_while_migrating_test()
+{
+    HashMap hashmap;
+    std::size_t count = fill_until_migrating(hashmap);
+    const HashMap & const_map = hashmap;
+
+    bool passed = hashmap.is_migrating();
+    for (std::size_t i = 0; i < count; i++) {
+        auto iter = const_map.find(i);
+        if ((iter == const_map.end()) || (iter->first != i) || (iter->second != i * 2))
+            passed = false;
+    }
+    if (const_map.find(count) != const_map.end())
+        passed = false;
+    // The const lookups mustn't migrate.
+    return (passed && hashmap.is_migrating());
+}
+
+template <typename HashMap>
+bool const_iterate_while_migrating_test()
+{
+    HashMap hashmap;
+    std::size_t count = fill_until_migrating(hashmap);
+    const HashMap & const_map = hashmap;
+
+    std::vector<char> visited(count, 0);
+    std::size_t visits = 0;
+    bool passed = hashmap.is_migrating();
+    for (auto iter = const_map.begin(); iter != const_map.end(); ++iter) {
+        if ((iter->first >= count) || visited[iter->first] || (iter->second != iter->first * 2))
+            passed = false;
+        else
+            visited[iter->first] = 1;
+        visits++;
+    }
+    passed = passed && (visits == count) && (const_map.size() == count);
+
+    // Copying reads the both arrays too.
+    HashMap copy(const_map);
+    passed = passed && (copy.size() == count);
+    for (std::size_t i = 0; i < count; i++) {
+        auto iter = copy.find(i);
+        if ((iter == copy.end()) || (iter->second != i * 2))
+            passed = false;
+    }
+    return (passed && hashmap.is_migrating());
+}
+
+template <typename HashMap>
+bool erase_old_slot_iterator_test()
+{
+    HashMap hashmap;
+    std::size_t count = fill_until_migrating(hashmap);
+
+    // The first iterator refers to a slot in the old arrays.
+    auto iter = hashmap.begin();
+    std::size_t key = iter->first;
+    auto next = hashmap.erase(iter);
+    bool passed = (hashmap.size() == count - 1) && !hashmap.contains(key);
+    // The iterator after the erased one walks the rest of the elements.
+    std::size_t visits = 0;
+    for (; next != hashmap.end(); ++next)
+        visits++;
+    return (passed && (visits == count - 1));
+}
+
+void incremental_rehash_test()
+{
+    using map_type = jstd::group16_flat_map<std::size_t, std::size_t,
+                                            std::hash<std::size_t>, std::equal_to<std::size_t>,
+                                            std::allocator<std::pair<const std::size_t, std::size_t>>,
+                                            jstd::flat_map_type_policy<std::size_t, std::size_t>,
+                                            jstd::flat_table_policy<true>>;
+    using default_map_type = jstd::group16_flat_map<std::size_t, std::size_t>;
+    test_result("group16_flat_map::incremental_rehash(), by the table policy",
+                map_type::incremental_rehash() && !default_map_type::incremental_rehash());
+    test_result("group16_flat_map::find() const, while migrating",
+                const_find_while_migrating_test<map_type>());
+    test_result("group16_flat_map::begin() const, copy, while migrating",
+                const_iterate_while_migrating_test<map_type>());
+    test_result("group16_flat_map::erase(old iterator), while migrating",
+                erase_old_slot_iterator_test<map_type>());
+}
+
+//
+// find_batch() and contains_batch() must agree with find(), for the hits and
+// the misses, and for a count which isn't a multiple of the prefetch batch.
+//
+template <typename HashMap>
+bool find_batch_test(bool is_migrating)
+{
+    typedef typename HashMap::iterator       iterator;
+    typedef typename HashMap::const_iterator const_iterator;
+
+    static const std::size_t kBatchCount = 1000 + 7;
+
+    HashMap hashmap;
+    std::size_t count = 10000;
+    if (is_migrating) {
+        count = fill_until_migrating(hashmap);
+    } else {
+        for (std::size_t i = 0; i < count; i++) {
+            hashmap.emplace(i, i * 2);
+        }
+    }
+
+    // About a half of the keys are beyond all the keys, they miss.
+    std::vector<std::size_t> keys;
+    for (std::size_t i = 0; i < kBatchCount; i++) {
+        keys.push_back((i * 7919) % (count * 2));
+    }
+
+    const HashMap & const_map = hashmap;
+    std::vector<const_iterator> iters(kBatchCount);
+    std::unique_ptr<bool[]> results(new bool[kBatchCount]);
+    const_map.find_batch(keys.data(), keys.size(), iters.data());
+    std::size_t found = const_map.contains_batch(keys.data(), keys.size(), results.get());
+
+    bool passed = (hashmap.is_migrating() == is_migrating);
+    std::size_t expected_found = 0;
+    for (std::size_t i = 0; i < kBatchCount; i++) {
+        const_iterator expected = const_map.find(keys[i]);
+        bool is_exists = (expected != const_map.end());
+        if ((iters[i] != expected) || (results[i] != is_exists) || (is_exists != (keys[i] < count)))
+            passed = false;
+        if (is_exists && (iters[i]->second != keys[i] * 2))
+            passed = false;
+        expected_found += is_exists;
+    }
+    passed = passed && (found == expected_found) && (expected_found != 0) &&
+             (expected_found != kBatchCount);
+
+    // The non-const find_batch() may migrate, so compare it with the keys only.
+    std::vector<iterator> mutable_iters(kBatchCount);
+    hashmap.find_batch(keys.data(), keys.size(), mutable_iters.data());
+    for (std::size_t i = 0; i < kBatchCount; i++) {
+        bool is_exists = (mutable_iters[i] != hashmap.end());
+        if ((is_exists != (keys[i] < count)) ||
+            (is_exists && ((mutable_iters[i]->first != keys[i]) || (mutable_iters[i]->second != keys[i] * 2))))
+            passed = false;
+    }
+    return passed;
+}
+
+void find_batch_test()
+{
+    using incremental_map_type = jstd::group16_flat_map<std::size_t, std::size_t,
+                                            std::hash<std::size_t>, std::equal_to<std::size_t>,
+                                            std::allocator<std::pair<const std::size_t, std::size_t>>,
+                                            jstd::flat_map_type_policy<std::size_t, std::size_t>,
+                                            jstd::flat_table_policy<true>>;
+    test_result("group16_flat_map::find_batch(), contains_batch()",
+                find_batch_test<jstd::group16_flat_map<std::size_t, std::size_t>>(false));
+    test_result("group16_flat_map::find_batch(), while migrating",
+                find_batch_test<incremental_map_type>(true));
+}
+
+//
+// insert_batch() and try_emplace_batch() from an empty map, each batch has the keys
+// repeated in it and the keys of the previous batch, so the first value of a key
+// is kept. The table grows partway through the batches.
+//
+template <typename HashMap>
+bool insert_batch_test(bool use_try_emplace)
+{
+    typedef typename HashMap::value_type value_type;
+
+    static const std::size_t kBatches = 20;
+    static const std::size_t kNewKeys = 1000 + 3;
+
+    HashMap hashmap;
+    std::size_t bucket_count = hashmap.bucket_count();
+    std::size_t grows = 0;
+    bool passed = true;
+
+    for (std::size_t batch = 0; batch < kBatches; batch++) {
+        std::vector<value_type> values;
+        std::vector<std::size_t> keys, mappeds;
+        std::size_t first = batch * kNewKeys;
+        for (std::size_t n = 0; n < kNewKeys; n++) {
+            std::size_t key = first + n;
+            keys.push_back(key);
+            mappeds.push_back(key * 2);
+            // Repeat every 3rd key in the batch, and a key of the previous batch.
+            if ((n % 3) == 0) {
+                keys.push_back(key);
+                mappeds.push_back(key * 3);
+            }
+            if ((batch > 0) && ((n % 5) == 0)) {
+                keys.push_back(key - kNewKeys);
+                mappeds.push_back(key * 3);
+            }
+        }
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            values.push_back(value_type(keys[i], mappeds[i]));
+        }
+
+        std::size_t inserted;
+        if (use_try_emplace)
+            inserted = hashmap.try_emplace_batch(keys.data(), mappeds.data(), keys.size());
+        else
+            inserted = hashmap.insert_batch(values.data(), values.size());
+        if ((inserted != kNewKeys) || (hashmap.size() != first + kNewKeys))
+            passed = false;
+
+        if (hashmap.bucket_count() != bucket_count) {
+            bucket_count = hashmap.bucket_count();
+            grows++;
+        }
+    }
+
+    for (std::size_t key = 0; key < kBatches * kNewKeys; key++) {
+        auto iter = hashmap.find(key);
+        if ((iter == hashmap.end()) || (iter->second != key * 2))
+            passed = false;
+    }
+    passed = passed && (hashmap.find(kBatches * kNewKeys) == hashmap.end());
+    // The first batch grows from the empty table, the later batches grow it too.
+    return (passed && (grows > 1));
+}
+
+void insert_batch_test()
+{
+    test_result("group15_flat_map::insert_batch(), repeated keys",
+                insert_batch_test<jstd::group15_flat_map<std::size_t, std::size_t>>(false));
+    test_result("group15_flat_map::try_emplace_batch(), repeated keys",
+                insert_batch_test<jstd::group15_flat_map<std::size_t, std::size_t>>(true));
+}
+
+template <typename HashMap>
+bool iterate_stale_groups_test()
+{
+    static const std::size_t kCount = 10000;
+    static const std::size_t kNewCount = 100;
+    HashMap hashmap;
+    for (std::size_t i = 0; i < kCount; i++) {
+        hashmap.emplace(i, i * 2);
+    }
+    hashmap.clear();
+    for (std::size_t i = kCount; i < kCount + kNewCount; i++) {
+        hashmap.emplace(i, i * 2);
+    }
+
+    // The elements in the stale groups are not visited.
+    const HashMap & const_map = hashmap;
+    bool passed = hashmap.has_stale_groups();
+    std::size_t visits = 0;
+    for (auto iter = const_map.begin(); iter != const_map.end(); ++iter) {
+        if ((iter->first < kCount) || (iter->second != iter->first * 2))
+            passed = false;
+        visits++;
+    }
+    passed = passed && (visits == kNewCount);
+
+    // Neither from an iterator of find().
+    std::size_t tail_visits = 0;
+    for (auto iter = hashmap.find(kCount); iter != hashmap.end(); ++iter) {
+        if (iter->first < kCount)
+            passed = false;
+        tail_visits++;
+    }
+    passed = passed && (tail_visits >= 1) && (tail_visits <= kNewCount);
+
+    // Nor backwards.
+    auto last = hashmap.find(kCount);
+    for (std::size_t i = 1; i < tail_visits; i++)
+        ++last;
+    std::size_t back_visits = 1;
+    for (auto iter = last; iter != hashmap.begin(); --iter) {
+        if (iter->first < kCount)
+            passed = false;
+        back_visits++;
+    }
+    passed = passed && (back_visits == kNewCount);
+
+    // The iterators mustn't reset the stale groups.
+    return (passed && hashmap.has_stale_groups());
+}
+
+//
+// Each round clears the map and reinserts an overlapping range of keys with the new values,
+// more rounds than the generations, so the generation wraps too.
+//
+template <typename HashMap>
+bool clear_reinsert_test()
+{
+    static const std::size_t kRounds = 300;
+    HashMap hashmap;
+    std::size_t last_first = 0, last_count = 0;
+    bool passed = true;
+    for (std::size_t round = 0; round < kRounds; round++) {
+        std::size_t first = round * 7;
+        std::size_t count = 500 + (round % 5) * 200;
+        hashmap.clear();
+        passed = passed && (hashmap.size() == 0) && hashmap.empty();
+        for (std::size_t key = first; key < first + count; key++) {
+            auto result = hashmap.emplace(key, key + round);
+            if (!result.second)
+                passed = false;
+        }
+        passed = passed && (hashmap.size() == count);
+
+        for (std::size_t key = first; key < first + count; key++) {
+            auto iter = hashmap.find(key);
+            if ((iter == hashmap.end()) || (iter->second != key + round))
+                passed = false;
+        }
+        // The keys of the last round which are not reinserted are gone.
+        for (std::size_t key = last_first; key < first; key++) {
+            if (hashmap.contains(key))
+                passed = false;
+        }
+        for (std::size_t key = first + count; key < last_first + last_count; key++) {
+            if (hashmap.find(key) != hashmap.end())
+                passed = false;
+        }
+
+        std::size_t visits = 0;
+        for (auto iter = hashmap.begin(); iter != hashmap.end(); ++iter) {
+            if ((iter->first < first) || (iter->first >= first + count) ||
+                (iter->second != iter->first + round))
+                passed = false;
+            visits++;
+        }
+        passed = passed && (visits == count);
+
+        last_first = first;
+        last_count = count;
+    }
+    return passed;
+}
+
+void generation_clear_test()
+{
+    using map_type = jstd::group16_flat_map<std::size_t, std::size_t,
+                                            std::hash<std::size_t>, std::equal_to<std::size_t>,
+                                            std::allocator<std::pair<const std::size_t, std::size_t>>,
+                                            jstd::flat_map_type_policy<std::size_t, std::size_t>,
+                                            jstd::flat_table_policy<false, true>>;
+    using default_map_type = jstd::group16_flat_map<std::size_t, std::size_t>;
+    test_result("group16_flat_map::generation_clear(), by the table policy",
+                map_type::generation_clear() && !default_map_type::generation_clear());
+    test_result("group16_flat_map::iterator, skip the stale groups",
+                iterate_stale_groups_test<map_type>());
+    test_result("group16_flat_map::clear(), reinsert, generation clear",
+                clear_reinsert_test<map_type>());
+    test_result("group16_flat_map::clear(), reinsert",
+                clear_reinsert_test<default_map_type>());
+}
+
+//
+// A big table holds only a few elements between two clear(), the values are long strings,
+// so the slots which are not destroyed by clear() are leaked.
+//
+template <typename HashMap>
+bool sparse_clear_reinsert_test()
+{
+    static const std::size_t kRounds = 200;
+    HashMap hashmap;
+    hashmap.reserve(1 << 16);
+    std::size_t capacity = hashmap.bucket_count();
+    std::size_t last_first = 0;
+    bool passed = true;
+    for (std::size_t round = 0; round < kRounds; round++) {
+        std::size_t first = (round * 7919) % (1 << 20);
+        std::size_t count = 1 + (round % 50);
+        hashmap.clear();
+        passed = passed && (hashmap.size() == 0) && (hashmap.begin() == hashmap.end());
+        for (std::size_t key = first; key < first + count; key++) {
+            auto result = hashmap.emplace(key, std::string(32, char('a' + round % 26)));
+            if (!result.second)
+                passed = false;
+        }
+        passed = passed && (hashmap.size() == count);
+        for (std::size_t key = first; key < first + count; key++) {
+            auto iter = hashmap.find(key);
+            if ((iter == hashmap.end()) || (iter->second != std::string(32, char('a' + round % 26))))
+                passed = false;
+        }
+        if ((round != 0) && (last_first != first) && hashmap.contains(last_first))
+            passed = false;
+        std::size_t visits = 0;
+        for (auto iter = hashmap.begin(); iter != hashmap.end(); ++iter) {
+            if ((iter->first < first) || (iter->first >= first + count))
+                passed = false;
+            visits++;
+        }
+        passed = passed && (visits == count);
+        last_first = first;
+    }
+    // clear() doesn't shrink the table.
+    passed = passed && (hashmap.bucket_count() == capacity);
+    return passed;
+}
+
+void sparse_clear_test()
+{
+    using sparse_policy = jstd::flat_table_policy<false, false, false, false, true>;
+    using map_type = jstd::group15_flat_map<std::size_t, std::size_t,
+                                            std::hash<std::size_t>, std::equal_to<std::size_t>,
+                                            std::allocator<std::pair<const std::size_t, std::size_t>>,
+                                            jstd::flat_map_type_policy<std::size_t, std::size_t>,
+                                            sparse_policy>;
+    using str_map_type = jstd::group15_flat_map<std::size_t, std::string,
+                                                std::hash<std::size_t>, std::equal_to<std::size_t>,
+                                                std::allocator<std::pair<const std::size_t, std::string>>,
+                                                jstd::flat_map_type_policy<std::size_t, std::string>,
+                                                sparse_policy>;
+    using default_map_type = jstd::group15_flat_map<std::size_t, std::size_t>;
+    test_result("group15_flat_map::sparse_clear(), by the table policy",
+                map_type::sparse_clear() && !default_map_type::sparse_clear());
+    test_result("group15_flat_map::clear(), reinsert, sparse clear",
+                clear_reinsert_test<map_type>());
+    test_result("group15_flat_map::clear(), reinsert",
+                clear_reinsert_test<default_map_type>());
+    test_result("group15_flat_map::clear(), a few strings, sparse clear",
+                str_map_type::sparse_clear() && sparse_clear_reinsert_test<str_map_type>());
+    test_result("group15_flat_map::clear(), a few strings",
+                sparse_clear_reinsert_test<jstd::group15_flat_map<std::size_t, std::string>>());
+}
+
+//
+// A sliding window of keys: each step erases the oldest key and inserts a new one,
+// so the size never changes. The erases lower the slot threshold, the overflow purge
+// must get it back in place instead of growing the table.
+//
+template <typename HashMap>
+bool insert_erase_churn_test()
+{
+    static const std::size_t kWindow = 12000;
+    static const std::size_t kSteps = 2000000;
+    static const std::size_t kMultiplier = static_cast<std::size_t>(0x9E3779B97F4A7C15ull);
+    HashMap hashmap;
+    for (std::size_t i = 0; i < kWindow; i++) {
+        hashmap.emplace(i * kMultiplier, i);
+    }
+    std::size_t capacity = hashmap.bucket_count();
+    bool passed = (hashmap.size() == kWindow);
+    for (std::size_t i = kWindow; i < kSteps; i++) {
+        if (hashmap.erase((i - kWindow) * kMultiplier) != 1)
+            passed = false;
+        hashmap.emplace(i * kMultiplier, i);
+        if (hashmap.bucket_count() != capacity)
+            passed = false;
+    }
+    passed = passed && (hashmap.size() == kWindow) && (hashmap.slot_threshold() >= hashmap.size());
+
+    // An explicit purge keeps the table and the elements too.
+    hashmap.purge_overflow();
+    passed = passed && (hashmap.bucket_count() == capacity) && (hashmap.size() == kWindow);
+    for (std::size_t i = kSteps - kWindow; i < kSteps; i++) {
+        auto iter = hashmap.find(i * kMultiplier);
+        if ((iter == hashmap.end()) || (iter->second != i))
+            passed = false;
+    }
+    passed = passed && !hashmap.contains((kSteps - kWindow - 1) * kMultiplier);
+    std::size_t visits = 0;
+    for (auto iter = hashmap.begin(); iter != hashmap.end(); ++iter) {
+        visits++;
+    }
+    return (passed && (visits == kWindow));
+}
+
+void overflow_purge_test()
+{
+    test_result("group16_flat_map::erase(), insert, churn keeps the capacity",
+                insert_erase_churn_test<jstd::group16_flat_map<std::size_t, std::size_t>>());
+}
+
+//
+// Each region must be one contiguous range, in the order of the regions,
+// and the items must be the same.
+//
+static bool partition_by_region_test()
+{
+    static const std::size_t kCount = 100000;
+    static const std::size_t kRegions = 37;
+    std::vector<std::size_t> items;
+    std::vector<std::size_t> counts(kRegions, 0);
+    for (std::size_t i = 0; i < kCount; i++) {
+        std::size_t item = (i * 2654435761u) % (kCount * 4);
+        items.push_back(item);
+        counts[item % kRegions]++;
+    }
+    auto region_of = [](std::size_t item) -> std::size_t { return (item % kRegions); };
+    bool passed = jstd::detail::partition_by_region(items, kRegions, region_of) &&
+                  (items.size() == kCount);
+
+    std::size_t index = 0;
+    for (std::size_t region = 0; region < kRegions; region++) {
+        for (std::size_t n = 0; n < counts[region]; n++) {
+            if (region_of(items[index++]) != region)
+                passed = false;
+        }
+    }
+    std::vector<std::uint8_t> seen(kCount * 4, 0);
+    for (std::size_t item : items) {
+        if (seen[item]++ != 0)
+            passed = false;
+    }
+    return passed;
+}
+
+//
+// A big growth of a big table, by reserve(), must keep all the elements.
+//
+template <typename HashMap>
+bool big_growth_rehash_test()
+{
+    static const std::size_t kCount = 70000;
+    static const std::size_t kMultiplier = static_cast<std::size_t>(0x9E3779B97F4A7C15ull);
+    HashMap hashmap;
+    for (std::size_t i = 0; i < kCount; i++) {
+        hashmap.emplace(i * kMultiplier, i);
+    }
+    hashmap.reserve(kCount * 32);
+    bool passed = (hashmap.size() == kCount);
+    for (std::size_t i = 0; i < kCount; i++) {
+        auto iter = hashmap.find(i * kMultiplier);
+        if ((iter == hashmap.end()) || (iter->second != i))
+            passed = false;
+    }
+    std::size_t visits = 0;
+    for (auto iter = hashmap.begin(); iter != hashmap.end(); ++iter) {
+        visits++;
+    }
+    return (passed && (visits == kCount) && !hashmap.contains(kCount * kMultiplier));
+}
+
+void region_rehash_test()
+{
+    test_result("detail::partition_by_region()",
+                partition_by_region_test());
+    test_result("robin_hash_map::reserve(), big growth",
+                big_growth_rehash_test<jstd::robin_hash_map<std::size_t, std::size_t>>());
+    test_result("group16_flat_map::reserve(), big growth",
+                big_growth_rehash_test<jstd::group16_flat_map<std::size_t, std::size_t>>());
+}
+
+///////////////////////////////////////////////////////////
+// The snapshot: save() and open_mapped()
+///////////////////////////////////////////////////////////
+
+//
+// Copy the file, and overwrite one byte of the copy at offset.
+//
+static bool copy_file_with_byte(const char * path, const char * new_path,
+                                std::size_t offset, char byte)
+{
+    std::vector<char> content;
+    std::FILE * fp = std::fopen(path, "rb");
+    if (fp == nullptr)
+        return false;
+    char buffer[4096];
+    std::size_t read_bytes;
+    while ((read_bytes = std::fread(buffer, 1, sizeof(buffer), fp)) != 0) {
+        content.insert(content.end(), buffer, buffer + read_bytes);
+    }
+    std::fclose(fp);
+    if (offset >= content.size())
+        return false;
+    content[offset] = byte;
+
+    fp = std::fopen(new_path, "wb");
+    if (fp == nullptr)
+        return false;
+    bool ok = (std::fwrite(content.data(), 1, content.size(), fp) == content.size());
+    return (std::fclose(fp) == 0) && ok;
+}
+
+//
+// The saved map is opened by another map, then all keys are found in the mapped file,
+// and a grow moves the table out of the file.
+//
+template <typename HashMap, typename SavedMap>
+bool snapshot_round_trip_test(const char * path)
+{
+    static const std::size_t kCount = 10000;
+    SavedMap saved;
+    for (std::size_t key = 0; key < kCount; key++) {
+        saved.emplace(key, key * 3);
+    }
+    bool passed = saved.save(path);
+
+    HashMap hashmap;
+    hashmap.emplace(kCount * 2, 0);
+    passed = passed && hashmap.open_mapped(path) && hashmap.is_mapped();
+    passed = passed && (hashmap.size() == kCount) && !hashmap.contains(kCount * 2);
+    for (std::size_t key = 0; key < kCount; key++) {
+        auto iter = hashmap.find(key);
+        if ((iter == hashmap.end()) || (iter->second != key * 3))
+            passed = false;
+    }
+    for (std::size_t key = kCount; key < kCount + 1000; key++) {
+        if (hashmap.find(key) != hashmap.end())
+            passed = false;
+    }
+
+    // The mapped pages are copy-on-write, the file is not changed.
+    hashmap[0] = 1;
+    hashmap.erase(1);
+    for (std::size_t key = kCount; key < kCount * 4; key++) {
+        hashmap.emplace(key, key * 3);
+    }
+    passed = passed && !hashmap.is_mapped() && (hashmap.size() == kCount * 4 - 1);
+    passed = passed && (hashmap[0] == 1) && !hashmap.contains(1) && (hashmap[2] == 6);
+
+    HashMap reopened;
+    passed = passed && reopened.open_mapped(path) && (reopened.size() == kCount) &&
+             (reopened[0] == 0) && (reopened[1] == 3);
+    return passed;
+}
+
+//
+// A file of the other layout, or with a damaged header, is rejected,
+// and the map keeps it's content.
+//
+template <typename HashMap, typename OtherMap>
+bool snapshot_reject_test(const char * path, const char * bad_path)
+{
+    HashMap saved;
+    for (std::size_t key = 0; key < 1000; key++) {
+        saved.emplace(key, key);
+    }
+    bool passed = saved.save(path);
+
+    OtherMap other;
+    other.emplace(7, 7);
+    passed = passed && !other.open_mapped(path) && !other.is_mapped() &&
+             (other.size() == 1) && other.contains(7);
+
+    HashMap hashmap;
+    hashmap.emplace(7, 8);
+    // The magic.
+    passed = passed && copy_file_with_byte(path, bad_path, 0, 'X') &&
+             !hashmap.open_mapped(bad_path);
+    // The version.
+    passed = passed && copy_file_with_byte(path, bad_path, 8, 0x7F) &&
+             !hashmap.open_mapped(bad_path);
+    passed = passed && !hashmap.open_mapped("hashmap_test_no_such_file.snapshot");
+    passed = passed && !hashmap.is_mapped() && (hashmap.size() == 1) && (hashmap[7] == 8);
+
+    passed = passed && hashmap.open_mapped(path) && (hashmap.size() == 1000);
+    std::remove(bad_path);
+    return passed;
+}
+
+void snapshot_test()
+{
+    using snapshot_policy = jstd::flat_table_policy<false, false, true>;
+    using map16_type = jstd::group16_flat_map<std::uint64_t, std::uint64_t,
+                                              std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                              std::allocator<std::pair<const std::uint64_t, std::uint64_t>>,
+                                              jstd::flat_map_type_policy<std::uint64_t, std::uint64_t>,
+                                              snapshot_policy>;
+    using map15_type = jstd::group15_flat_map<std::uint64_t, std::uint64_t,
+                                              std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                              std::allocator<std::pair<const std::uint64_t, std::uint64_t>>,
+                                              jstd::flat_map_type_policy<std::uint64_t, std::uint64_t>,
+                                              snapshot_policy>;
+    using map16_u32_type = jstd::group16_flat_map<std::uint64_t, std::uint32_t,
+                                                  std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                                  std::allocator<std::pair<const std::uint64_t, std::uint32_t>>,
+                                                  jstd::flat_map_type_policy<std::uint64_t, std::uint32_t>,
+                                                  snapshot_policy>;
+    using map15_u32_type = jstd::group15_flat_map<std::uint64_t, std::uint32_t,
+                                                  std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                                  std::allocator<std::pair<const std::uint64_t, std::uint32_t>>,
+                                                  jstd::flat_map_type_policy<std::uint64_t, std::uint32_t>,
+                                                  snapshot_policy>;
+    static const char * kPath = "hashmap_test.snapshot";
+    static const char * kBadPath = "hashmap_test_bad.snapshot";
+
+    test_result("group16_flat_map::open_mapped(), by the table policy",
+                map16_type::table_policy::snapshot &&
+                !jstd::group16_flat_map<std::uint64_t, std::uint64_t>::table_policy::snapshot &&
+                !jstd::group16_flat_map<std::uint64_t, std::uint64_t>().is_mapped());
+    test_result("group16_flat_map::save(), open_mapped(), find()",
+                snapshot_round_trip_test<map16_type, map16_type>(kPath));
+    test_result("group16_flat_map::open_mapped(), the default map's file",
+                snapshot_round_trip_test<map16_type, jstd::group16_flat_map<std::uint64_t, std::uint64_t>>(kPath));
+    test_result("group16_flat_map::open_mapped(), reject the other layout",
+                snapshot_reject_test<map16_type, map16_u32_type>(kPath, kBadPath));
+    test_result("group16_flat_map::open_mapped(), reject the group15 file",
+                snapshot_reject_test<map15_type, map16_type>(kPath, kBadPath));
+
+    test_result("group15_flat_map::save(), open_mapped(), find()",
+                snapshot_round_trip_test<map15_type, map15_type>(kPath));
+    test_result("group15_flat_map::open_mapped(), the default map's file",
+                snapshot_round_trip_test<map15_type, jstd::group15_flat_map<std::uint64_t, std::uint64_t>>(kPath));
+    test_result("group15_flat_map::open_mapped(), reject the other layout",
+                snapshot_reject_test<map15_type, map15_u32_type>(kPath, kBadPath));
+    test_result("group15_flat_map::open_mapped(), reject the group16 file",
+                snapshot_reject_test<map16_type, map15_type>(kPath, kBadPath));
+    std::remove(kPath);
+}
+
+///////////////////////////////////////////////////////////
+// The huge page allocator
+///////////////////////////////////////////////////////////
+
+//
+// The small allocations go to std::allocator<T>, the big ones are mapped and aligned
+// to 2 MB, except the normal pages of Windows, which are aligned to 64 KB.
+//
+bool huge_page_allocate_test(unsigned allocator_flags)
+{
+    using allocator_type = jstd::huge_page_allocator<std::uint64_t>;
+    static const std::size_t kHugeCount = 3 * allocator_type::kHugePageThreshold / sizeof(std::uint64_t) + 5;
+#if defined(_WIN32) || defined(_WIN64)
+    static const std::size_t kAlignment = 64 * 1024;
+#else
+    static const std::size_t kAlignment = allocator_type::kHugePageSize;
+#endif
+    allocator_type allocator(allocator_flags);
+    bool passed = (allocator.flags() == allocator_flags);
+
+    std::size_t counts[] = { 1, 1000, kHugeCount };
+    for (std::size_t count : counts) {
+        std::uint64_t * data = allocator.allocate(count);
+        if (count == kHugeCount) {
+            passed = passed && ((reinterpret_cast<std::uintptr_t>(data) % kAlignment) == 0);
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            data[i] = i;
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            if (data[i] != i)
+                passed = false;
+        }
+        // A rebound copy frees the memory of the other.
+        jstd::huge_page_allocator<char> rebound(allocator);
+        allocator_type(rebound).deallocate(data, count);
+    }
+    return passed;
+}
+
+//
+// A table whose arrays grow from the std::allocator<T> ones to the mapped ones.
+//
+template <typename HashMap>
+bool huge_page_map_test(unsigned allocator_flags)
+{
+    static const std::size_t kCount = 500000;
+    HashMap hashmap(0, typename HashMap::hasher(), typename HashMap::key_equal(),
+                    typename HashMap::allocator_type(allocator_flags));
+    for (std::size_t key = 0; key < kCount; key++) {
+        hashmap.emplace(key, key * 2);
+    }
+    HashMap copy(hashmap);
+    bool passed = (hashmap.size() == kCount) && (copy.size() == kCount) &&
+                  (hashmap.get_allocator().flags() == allocator_flags);
+    for (std::size_t key = 0; key < kCount; key++) {
+        auto iter = copy.find(key);
+        if ((iter == copy.end()) || (iter->second != key * 2))
+            passed = false;
+    }
+    hashmap.clear(true);
+    passed = passed && (hashmap.size() == 0) && (hashmap.find(1) == hashmap.end());
+    return passed;
+}
+
+void huge_page_allocator_test()
+{
+    using pair_type = std::pair<const std::uint64_t, std::uint64_t>;
+    using allocator_type = jstd::huge_page_allocator<pair_type>;
+    using map_type = jstd::group16_flat_map<std::uint64_t, std::uint64_t,
+                                            std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                            allocator_type>;
+    static const unsigned kHugeTLB = allocator_type::kUseHugeTLB;
+    static const unsigned kPrefault = allocator_type::kPrefault;
+
+    test_result("huge_page_allocator::allocate(), deallocate()",
+                huge_page_allocate_test(0) && huge_page_allocate_test(kPrefault));
+    test_result("huge_page_allocator::allocate(), MAP_HUGETLB if reserved",
+                huge_page_allocate_test(kHugeTLB) && huge_page_allocate_test(kHugeTLB | kPrefault));
+    test_result("group16_flat_map<K, V, huge_page_allocator>, copy",
+                huge_page_map_test<map_type>(0) && huge_page_map_test<map_type>(kPrefault));
+}
+
+///////////////////////////////////////////////////////////
+// The released arrays: clear(true) and shrink_to_fit()
+///////////////////////////////////////////////////////////
+
+//
+// The pages of a mapped range are released, only the whole pages in the range.
+//
+bool release_pages_test(unsigned allocator_flags)
+{
+    static const std::size_t kBytes = 4 * 1024 * 1024;
+    jstd::huge_page_allocator<char> allocator(allocator_flags);
+    char * data = allocator.allocate(kBytes);
+    std::memset(data, 1, kBytes);
+
+    std::size_t page_size = jstd::system_page_size();
+    std::size_t mapping_page_size = jstd::mapping_page_size(data);
+    bool passed = (jstd::release_pages(data + 1, page_size - 2) == false);
+    passed = passed && (data[1] == 1);
+#if defined(__linux__)
+    passed = passed && (mapping_page_size >= page_size);
+    // Without MAP_HUGETLB, the range is released by the normal pages.
+    if ((allocator_flags & jstd::huge_page_allocator<char>::kUseHugeTLB) == 0) {
+        passed = passed && (mapping_page_size == page_size);
+        passed = passed && jstd::release_pages(data + 1, page_size * 3) &&
+                 (data[0] == 1) && (data[page_size] == 0) && (data[page_size * 3] == 1);
+    }
+#endif
+    passed = passed && jstd::release_pages(data, kBytes);
+#if defined(__linux__)
+    passed = passed && (data[0] == 0) && (data[kBytes - 1] == 0);
+#endif
+    JSTD_UNUSED(mapping_page_size);
+    allocator.deallocate(data, kBytes);
+    return passed;
+}
+
+//
+// The slot array of 32 MB is released by clear(true) and shrink_to_fit(),
+// then reused by the next growth.
+//
+template <typename HashMap>
+bool release_slots_test(unsigned allocator_flags)
+{
+    static const std::size_t kCount = 1500000;
+    HashMap hashmap(0, typename HashMap::hasher(), typename HashMap::key_equal(),
+                    typename HashMap::allocator_type(allocator_flags));
+    bool passed = true;
+    for (std::size_t round = 0; round < 2; round++) {
+        for (std::size_t key = 0; key < kCount; key++) {
+            hashmap.emplace(key, key + round);
+        }
+        passed = passed && (hashmap.size() == kCount);
+        for (std::size_t key = 0; key < kCount; key++) {
+            auto iter = hashmap.find(key);
+            if ((iter == hashmap.end()) || (iter->second != key + round))
+                passed = false;
+        }
+        if (round == 0) {
+            hashmap.clear(true);
+            passed = passed && (hashmap.size() == 0) && (hashmap.find(1) == hashmap.end());
+        } else {
+            for (std::size_t key = 10; key < kCount; key++) {
+                hashmap.erase(key);
+            }
+            hashmap.shrink_to_fit();
+            passed = passed && (hashmap.size() == 10) && (hashmap[9] == 10);
+            for (std::size_t key = 0; key < kCount; key++) {
+                hashmap.emplace(key, key);
+            }
+            passed = passed && (hashmap.size() == kCount) && (hashmap[9] == 10) &&
+                     (hashmap[kCount - 1] == kCount - 1);
+        }
+    }
+
+    // A miss is end(), also in the empty table and after a swap.
+    HashMap other;
+    passed = passed && (other.find(1) == other.end()) && (other.begin() == other.end());
+    other.swap(hashmap);
+    passed = passed && (other.size() == kCount) && (other.find(kCount) == other.end()) &&
+             (hashmap.size() == 0) && (hashmap.find(1) == hashmap.end());
+    return passed;
+}
+
+void release_pages_test()
+{
+    using pair_type = std::pair<const std::uint64_t, std::uint64_t>;
+    using allocator_type = jstd::huge_page_allocator<pair_type>;
+    using release_policy = jstd::flat_table_policy<false, false, false, true>;
+    using map16_type = jstd::group16_flat_map<std::uint64_t, std::uint64_t,
+                                              std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                              allocator_type,
+                                              jstd::flat_map_type_policy<std::uint64_t, std::uint64_t>,
+                                              release_policy>;
+    using map15_type = jstd::group15_flat_map<std::uint64_t, std::uint64_t,
+                                              std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                              allocator_type,
+                                              jstd::flat_map_type_policy<std::uint64_t, std::uint64_t>,
+                                              release_policy>;
+    using robin_map_type = jstd::robin_hash_map<std::uint64_t, std::uint64_t,
+                                                std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                                jstd::default_layout_policy<std::uint64_t, std::uint64_t>,
+                                                allocator_type>;
+    static const unsigned kHugeTLB = allocator_type::kUseHugeTLB;
+
+    test_result("jstd::release_pages()",
+                release_pages_test(0));
+    test_result("jstd::release_pages(), MAP_HUGETLB if reserved",
+                release_pages_test(kHugeTLB));
+    test_result("group16_flat_map::clear(true), released slots",
+                release_slots_test<map16_type>(0) && release_slots_test<map16_type>(kHugeTLB));
+    test_result("group15_flat_map::clear(true), released slots",
+                release_slots_test<map15_type>(0) && release_slots_test<map15_type>(kHugeTLB));
+    test_result("robin_hash_map::clear(true), released slots",
+                release_slots_test<robin_map_type>(0) && release_slots_test<robin_map_type>(kHugeTLB));
+}
+
+//
+// The op inserts the key 2, but in the n-th application, it inserts the key 9
+// and then throws, it leaves the instance half-modified.
+//
+template <typename HashMap>
+bool modify_throws_test(int throw_at)
+{
+    using map_type = typename HashMap::map_type;
+    HashMap hashmap;
+    hashmap.insert_or_assign(1, 1);
+
+    int applied = 0;
+    bool is_thrown = false;
+    try {
+        hashmap.modify([&applied, throw_at](map_type & map) {
+            if (++applied == throw_at) {
+                map.insert_or_assign(9, 9);
+                throw std::runtime_error("modify_throws_test");
+            }
+            map.insert_or_assign(2, 2);
+            return true;
+        });
+    } catch (const std::runtime_error &) {
+        is_thrown = true;
+    }
+
+    // If the first application throws, the key isn't published, otherwise it's kept.
+    bool expected = (throw_at != 1);
+    bool passed = is_thrown && (hashmap.contains(2) == expected) && !hashmap.contains(9);
+
+    // The next modification publishes the other instance, it must be the same.
+    hashmap.insert_or_assign(3, 3);
+    passed = passed && (hashmap.contains(2) == expected) && !hashmap.contains(9) && hashmap.contains(3);
+    hashmap.insert_or_assign(4, 4);
+    passed = passed && (hashmap.contains(2) == expected) && !hashmap.contains(9) &&
+             (hashmap.size() == (expected ? 4 : 3));
+    return passed;
+}
+
+static inline void make_key(std::size_t & key, std::size_t n) { key = n; }
+static inline void make_key(std::string & key, std::size_t n) { key = std::to_string(n); }
+
+//
+// The writer inserts the new keys, so the instances rehash, and erases the half
+// of them. Meanwhile the readers look up the first keys, which must be found,
+// the new keys, which may be found, and the keys never inserted, which must be missed.
+// The std::string keys take the indirect layout of robin_hash_map.
+//
+template <typename HashMap>
+bool read_mostly_readers_test()
+{
+    typedef typename HashMap::key_type   key_type;
+    typedef typename HashMap::value_type value_type;
+
+    static const std::size_t kReaders = 2;
+    static const std::size_t kStableKeys = 1000;
+    static const std::size_t kNewKeys = 20000;
+    static const std::size_t kKeyCount = kStableKeys + kNewKeys;
+    static const std::size_t kEraseLag = 100;
+
+    HashMap hashmap;
+    key_type key;
+    for (std::size_t n = 0; n < kStableKeys; n++) {
+        make_key(key, n);
+        hashmap.insert_or_assign(key, n * 2);
+    }
+
+    std::atomic<bool> writer_done(false);
+    std::atomic<std::size_t> bad_count(0);
+    std::vector<std::thread> readers;
+
+    for (std::size_t r = 0; r < kReaders; r++) {
+        readers.emplace_back([&hashmap, &writer_done, &bad_count, r]() {
+            key_type key;
+            std::size_t n = r;
+            while (!writer_done.load()) {
+                std::size_t value = 0;
+                make_key(key, n % kStableKeys);
+                if (!hashmap.find(key, value) || (value != (n % kStableKeys) * 2))
+                    bad_count++;
+                std::size_t expected = (kStableKeys + n % kNewKeys) * 2;
+                make_key(key, kStableKeys + n % kNewKeys);
+                hashmap.cvisit(key, [&bad_count, expected](const value_type & value) {
+                    if (value.second != expected)
+                        bad_count++;
+                });
+                if (hashmap.find(key, value) && (value != expected))
+                    bad_count++;
+                make_key(key, kKeyCount + n % kNewKeys);
+                if (hashmap.find(key, value) || hashmap.contains(key))
+                    bad_count++;
+                n += 7;
+            }
+        });
+    }
+
+    for (std::size_t n = kStableKeys; n < kKeyCount; n++) {
+        make_key(key, n);
+        if (!hashmap.insert_or_assign(key, n * 2))
+            bad_count++;
+        // Erase the even keys a while after they are inserted.
+        if (((n % 2) == 0) && (n >= kStableKeys + kEraseLag)) {
+            make_key(key, n - kEraseLag);
+            if (hashmap.erase(key) != 1)
+                bad_count++;
+        }
+    }
+    writer_done = true;
+
+    for (auto & thread : readers) {
+        thread.join();
+    }
+
+    bool passed = (bad_count.load() == 0);
+    std::size_t found = 0;
+    for (std::size_t n = 0; n < kKeyCount; n++) {
+        std::size_t value = 0;
+        make_key(key, n);
+        if (hashmap.find(key, value)) {
+            if (value != n * 2)
+                passed = false;
+            found++;
+        }
+    }
+    std::size_t expected_size = kStableKeys + kNewKeys / 2 + kEraseLag / 2;
+    return (passed && (found == expected_size) && (hashmap.size() == expected_size));
+}
+
+void read_mostly_modify_test()
+{
+    using map_type = jstd::read_mostly_robin_hash_map<int, int>;
+    test_result("read_mostly_robin_hash_map::modify(), the 1st op throws",
+                modify_throws_test<map_type>(1));
+    test_result("read_mostly_robin_hash_map::modify(), the 2nd op throws",
+                modify_throws_test<map_type>(2));
+    test_result("read_mostly_robin_hash_map, readers, insert, erase",
+                read_mostly_readers_test<jstd::read_mostly_robin_hash_map<std::size_t, std::size_t>>());
+    test_result("read_mostly_robin_hash_map<string, V>, readers, erase",
+                read_mostly_readers_test<jstd::read_mostly_robin_hash_map<std::string, std::size_t>>());
+}
+
+///////////////////////////////////////////////////////////
+// The concurrent maps
+///////////////////////////////////////////////////////////
+
+//
+// Each writer inserts it's own keys into an empty map, so the tables grow,
+// then erases the even keys and updates the odd ones. Meanwhile the readers
+// look up all the keys, they must only see the values which are written.
+//
+template <typename ConcurrentMap>
+bool concurrent_map_test()
+{
+    typedef typename ConcurrentMap::value_type value_type;
+
+    static const std::size_t kWriters = 4;
+    static const std::size_t kReaders = 2;
+    static const std::size_t kKeysPerWriter = 20000;
+    static const std::size_t kKeyCount = kWriters * kKeysPerWriter;
+
+    ConcurrentMap hashmap;
+    std::atomic<std::size_t> writers_done(0);
+    std::atomic<std::size_t> bad_count(0);
+    std::vector<std::thread> threads;
+
+    for (std::size_t w = 0; w < kWriters; w++) {
+        threads.emplace_back([&hashmap, &writers_done, &bad_count, w]() {
+            std::size_t first = w * kKeysPerWriter;
+            std::size_t last = first + kKeysPerWriter;
+            for (std::size_t key = first; key < last; key++) {
+                if (!hashmap.insert(std::make_pair(key, key * 2)))
+                    bad_count++;
+            }
+            for (std::size_t key = first; key < last; key += 2) {
+                if (hashmap.erase(key) != 1)
+                    bad_count++;
+            }
+            for (std::size_t key = first + 1; key < last; key += 2) {
+                if (!hashmap.visit(key, [](value_type & value) { value.second = value.first * 3; }))
+                    bad_count++;
+            }
+            writers_done++;
+        });
+    }
+
+    for (std::size_t r = 0; r < kReaders; r++) {
+        threads.emplace_back([&hashmap, &writers_done, &bad_count, r]() {
+            std::size_t key = r;
+            while (writers_done.load() < kWriters) {
+                hashmap.cvisit(key % kKeyCount, [&bad_count](const value_type & value) {
+                    if ((value.second != value.first * 2) && (value.second != value.first * 3))
+                        bad_count++;
+                });
+                if (hashmap.size() > kKeyCount)
+                    bad_count++;
+                key += 7919;
+            }
+        });
+    }
+
+    for (auto & thread : threads) {
+        thread.join();
+    }
+
+    bool passed = (bad_count.load() == 0) && (hashmap.size() == kKeyCount / 2);
+    for (std::size_t key = 0; key < kKeyCount; key++) {
+        bool is_found = hashmap.cvisit(key, [&passed](const value_type & value) {
+            if (value.second != value.first * 3)
+                passed = false;
+        });
+        if (is_found != ((key % 2) == 1))
+            passed = false;
+    }
+    std::size_t visits = 0;
+    hashmap.cvisit_all([&visits](const value_type &) { visits++; });
+    return (passed && (visits == kKeyCount / 2));
+}
+
+//
+// The readers look up the keys which are inserted first, while the writers insert
+// the other keys and rehash() the table, the first keys must never be missed.
+//
+template <typename ConcurrentMap>
+bool concurrent_grow_test()
+{
+    typedef typename ConcurrentMap::value_type value_type;
+
+    static const std::size_t kWriters = 2;
+    static const std::size_t kReaders = 2;
+    static const std::size_t kStableKeys = 1000;
+    static const std::size_t kKeysPerWriter = 50000;
+
+    ConcurrentMap hashmap;
+    for (std::size_t key = 0; key < kStableKeys; key++) {
+        hashmap.emplace(key, key * 2);
+    }
+    std::size_t capacity = hashmap.capacity();
+
+    std::atomic<std::size_t> writers_done(0);
+    std::atomic<std::size_t> bad_count(0);
+    std::vector<std::thread> threads;
+
+    for (std::size_t w = 0; w < kWriters; w++) {
+        threads.emplace_back([&hashmap, &writers_done, &bad_count, w]() {
+            std::size_t first = kStableKeys + w * kKeysPerWriter;
+            std::size_t last = first + kKeysPerWriter;
+            for (std::size_t key = first; key < last; key++) {
+                bool is_visited = false;
+                if (!hashmap.emplace_or_visit(key, key * 2, [&is_visited](value_type &) { is_visited = true; }) ||
+                    is_visited)
+                    bad_count++;
+                if ((w == 0) && ((key % 10000) == 0))
+                    hashmap.rehash(hashmap.capacity() * 2);
+            }
+            // Erase the other half of it's keys by erase_if(key, pred).
+            for (std::size_t key = first; key < last; key++) {
+                std::size_t erased = hashmap.erase_if(key, [](const value_type & value) {
+                    return ((value.first % 2) == 0);
+                });
+                if (erased != (((key % 2) == 0) ? 1u : 0u))
+                    bad_count++;
+            }
+            writers_done++;
+        });
+    }
+
+    for (std::size_t r = 0; r < kReaders; r++) {
+        threads.emplace_back([&hashmap, &writers_done, &bad_count, r]() {
+            std::size_t key = r;
+            while (writers_done.load() < kWriters) {
+                bool is_found = hashmap.cvisit(key % kStableKeys, [&bad_count](const value_type & value) {
+                    if (value.second != value.first * 2)
+                        bad_count++;
+                });
+                if (!is_found)
+                    bad_count++;
+                key += 7;
+            }
+        });
+    }
+
+    for (auto & thread : threads) {
+        thread.join();
+    }
+
+    std::size_t expected_size = kStableKeys + kWriters * kKeysPerWriter / 2;
+    bool passed = (bad_count.load() == 0) && (hashmap.size() == expected_size) &&
+                  (hashmap.capacity() > capacity);
+    for (std::size_t key = 0; key < kStableKeys + kWriters * kKeysPerWriter; key++) {
+        bool expected = (key < kStableKeys) || ((key % 2) == 1);
+        if (hashmap.contains(key) != expected)
+            passed = false;
+    }
+    return passed;
+}
+
+void concurrent_map_test()
+{
+    test_result("concurrent_group16_flat_map, insert, erase, visit, size",
+                concurrent_map_test<jstd::concurrent_group16_flat_map<std::size_t, std::size_t>>());
+    test_result("concurrent_group15_flat_map, insert, erase, visit, size",
+                concurrent_map_test<jstd::concurrent_group15_flat_map<std::size_t, std::size_t>>());
+    test_result("concurrent_group15_flat_map, grow, rehash(), readers",
+                concurrent_grow_test<jstd::concurrent_group15_flat_map<std::size_t, std::size_t>>());
+}
+
+//
+// The node maps keep the addresses of the elements when the table grows.
+//
+template <typename HashMap>
+bool node_map_test(const char * expected_name)
+{
+    static const std::size_t kCount = 20000;
+    HashMap hashmap;
+    hashmap.emplace(0, std::string("zero"));
+    const std::string * first_value = &hashmap.find(0)->second;
+    for (std::size_t i = 1; i < kCount; i++) {
+        hashmap.emplace(i, std::to_string(i));
+    }
+
+    bool passed = (hashmap.size() == kCount) && (&hashmap.find(0)->second == first_value) &&
+                  (*first_value == "zero") && (strcmp(HashMap::name(), expected_name) == 0);
+    for (std::size_t i = 1; i < kCount; i++) {
+        auto iter = hashmap.find(i);
+        if ((iter == hashmap.end()) || (iter->second != std::to_string(i)))
+            passed = false;
+    }
+
+    for (std::size_t i = 0; i < kCount; i += 2) {
+        hashmap.erase(i);
+    }
+    HashMap copy(hashmap);
+    passed = passed && (copy.size() == kCount / 2) && (copy.count(1) == 1) && (copy.count(2) == 0);
+
+    try {
+        copy.at(kCount);
+        passed = false;
+    } catch (const std::out_of_range &) {
+        // Expected
+    }
+    return passed;
+}
+
+void node_map_test()
+{
+    test_result("group16_node_map<K, V>",
+        node_map_test<jstd::group16_node_map<std::size_t, std::string>>("jstd::group16_node_map"));
+    test_result("group15_node_map<K, V>",
+        node_map_test<jstd::group15_node_map<std::size_t, std::string>>("jstd::group15_node_map"));
+}
+
+int main(int argc, char * argv[])
+{
+    basic_map_test();
+    string_key_map_test();
+    basic_set_test();
+    wrapper_api_test();
+    heterogeneous_insert_test();
+    parallel_rehash_test();
+    node_map_test();
+    incremental_rehash_test();
+    find_batch_test();
+    insert_batch_test();
+    generation_clear_test();
+    sparse_clear_test();
+    overflow_purge_test();
+    region_rehash_test();
+    snapshot_test();
+    huge_page_allocator_test();
+    release_pages_test();
+    read_mostly_modify_test();
+    concurrent_map_test();
+
+    printf("\n");
+    return ((s_failed_tests == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}